@@ -252,6 +252,10 @@ static const ALCfunction alcFunctions[] = {
     { "alGetBufferSamplesSOFT",     (ALCvoid *) alGetBufferSamplesSOFT   },
     { "alIsBufferFormatSupportedSOFT",(ALCvoid *) alIsBufferFormatSupportedSOFT},
 
+    { "alBufferDataStaticSOFT",     (ALCvoid *) alBufferDataStaticSOFT   },
+    { "alLoadBankSOFT",             (ALCvoid *) alLoadBankSOFT           },
+    { "alBufferCallbackSOFT",       (ALCvoid *) alBufferCallbackSOFT     },
+
     { "alDeferUpdatesSOFT",         (ALCvoid *) alDeferUpdatesSOFT       },
     { "alProcessUpdatesSOFT",       (ALCvoid *) alProcessUpdatesSOFT     },
 
@@ -293,6 +297,10 @@ static const ALCenums enumeration[] = {
     { "ALC_FORMAT_CHANNELS_SOFT",             ALC_FORMAT_CHANNELS_SOFT            },
     { "ALC_FORMAT_TYPE_SOFT",                 ALC_FORMAT_TYPE_SOFT                },
 
+    // Voice budget Properties
+    { "ALC_MAX_VOICES_SOFT",                  ALC_MAX_VOICES_SOFT                 },
+    { "ALC_STOLEN_VOICES_SOFT",               ALC_STOLEN_VOICES_SOFT              },
+
     // Buffer Channel Configurations
     { "ALC_MONO_SOFT",                        ALC_MONO_SOFT                       },
     { "ALC_STEREO_SOFT",                      ALC_STEREO_SOFT                     },
@@ -346,7 +354,7 @@ static const ALCchar alcNoDeviceExtList[] =
 static const ALCchar alcExtensionList[] =
     "ALC_ENUMERATE_ALL_EXT ALC_ENUMERATION_EXT ALC_EXT_CAPTURE "
     "ALC_EXT_DEDICATED ALC_EXT_disconnect ALC_EXT_EFX "
-    "ALC_EXT_thread_local_context ALC_SOFT_loopback";
+    "ALC_EXT_thread_local_context ALC_SOFT_loopback ALC_SOFTX_voice_budget";
 static const ALCint alcMajorVersion = 1;
 static const ALCint alcMinorVersion = 1;
 
@@ -378,7 +386,9 @@ static const ALchar alExtList[] =
     "AL_EXT_IMA4 AL_EXT_LINEAR_DISTANCE AL_EXT_MCFORMATS AL_EXT_MULAW "
     "AL_EXT_MULAW_MCFORMATS AL_EXT_OFFSET AL_EXT_source_distance_model "
     "AL_LOKI_quadriphonic AL_SOFT_buffer_samples AL_SOFT_buffer_sub_data "
-    "AL_SOFTX_deferred_updates AL_SOFT_direct_channels AL_SOFT_loop_points";
+    "AL_SOFTX_deferred_updates AL_SOFT_direct_channels AL_SOFT_loop_points "
+    "AL_SOFTX_source_priority AL_SOFTX_static_buffer AL_SOFTX_sound_bank "
+    "AL_SOFTX_callback_buffer";
 
 // Mixing Priority Level
 ALint RTPrioLevel;
@@ -579,7 +589,8 @@ static void alc_initconfig(void)
 
     ReadALConfig();
 
-    InitHrtf();
+    aluInitResamplers();
+    aluInitFFT();
 
 #ifdef _WIN32
     RTPrioLevel = 1;
@@ -596,12 +607,14 @@ static void alc_initconfig(void)
             DefaultResampler = LinearResampler;
         else if(strcasecmp(str, "cubic") == 0)
             DefaultResampler = CubicResampler;
+        else if(strcasecmp(str, "sinc") == 0)
+            DefaultResampler = SincResampler;
         else
         {
             char *end;
 
             n = strtol(str, &end, 0);
-            if(*end == '\0' && (n == PointResampler || n == LinearResampler || n == CubicResampler))
+            if(*end == '\0' && (n >= PointResampler && n < ResamplerMax))
                 DefaultResampler = n;
             else
                 WARN("Invalid resampler: %s\n", str);
@@ -619,6 +632,23 @@ static void alc_initconfig(void)
 
     EmulateEAXReverb = GetConfigValueBool("reverb", "emulate-eax", AL_FALSE);
 
+    if(ConfigValueInt("reverb", "decimate", &n))
+    {
+        if(n == 1 || n == 2 || n == 4)
+            ReverbDecimation = n;
+        else
+            WARN("Invalid reverb decimation: %d\n", n);
+    }
+
+    CompressedBuffers = GetConfigValueBool(NULL, "compressed_buffers", AL_TRUE);
+
+    ResampleBuffers = GetConfigValueBool(NULL, "resample_buffers", AL_FALSE);
+    if(ResampleBuffers)
+        InitBufferResampler();
+
+    if(ConfigValueFloat(NULL, "virtual_threshold", &valf))
+        VirtualThreshold = aluPow(10.0f, valf / 20.0f);
+
     if(((devs=getenv("ALSOFT_DRIVERS")) && devs[0]) ||
        ConfigValueStr(NULL, "drivers", &devs))
     {
@@ -1038,6 +1068,19 @@ static void alcSetError(ALCdevice *device, ALCenum errorCode)
 }
 
 
+/* InitMixThreads
+ *
+ * Starts the extra source mixing threads requested by the config, if any.
+ */
+static ALCvoid InitMixThreads(ALCdevice *device)
+{
+    ALuint threads = 1;
+
+    ConfigValueUInt(NULL, "mix_threads", &threads);
+    if(threads > 1)
+        device->MixPool = CreateMixThreadPool(threads-1);
+}
+
 /* UpdateDeviceParams
  *
  * Updates device parameters according to the attribute list (caller is
@@ -1061,7 +1104,7 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
             GotType  = 1<<2,
             GotAll   = GotFreq|GotChans|GotType
         };
-        ALCuint freq, numMono, numStereo, numSends;
+        ALCuint freq, numMono, numStereo, numSends, numVoices;
         enum DevFmtChannels schans;
         enum DevFmtType stype;
         ALCuint attrIdx = 0;
@@ -1076,6 +1119,7 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
         numMono = device->NumMonoSources;
         numStereo = device->NumStereoSources;
         numSends = device->NumAuxSends;
+        numVoices = device->MaxVoices;
         schans = device->FmtChans;
         stype = device->FmtType;
         freq = device->Frequency;
@@ -1120,6 +1164,9 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
             if(attrList[attrIdx] == ALC_MAX_AUXILIARY_SENDS)
                 numSends = attrList[attrIdx + 1];
 
+            if(attrList[attrIdx] == ALC_MAX_VOICES_SOFT)
+                numVoices = attrList[attrIdx + 1];
+
             attrIdx += 2;
         }
 
@@ -1142,10 +1189,11 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
         device->NumMonoSources = numMono;
         device->NumStereoSources = numStereo;
         device->NumAuxSends = numSends;
+        device->MaxVoices = numVoices;
     }
     else if(attrList && attrList[0])
     {
-        ALCuint freq, numMono, numStereo, numSends;
+        ALCuint freq, numMono, numStereo, numSends, numVoices;
         ALCuint attrIdx = 0;
 
         /* If a context is already running on the device, stop playback so the
@@ -1158,6 +1206,7 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
         numMono = device->NumMonoSources;
         numStereo = device->NumStereoSources;
         numSends = device->NumAuxSends;
+        numVoices = device->MaxVoices;
 
         while(attrList[attrIdx])
         {
@@ -1179,6 +1228,9 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
             if(attrList[attrIdx] == ALC_MAX_AUXILIARY_SENDS)
                 numSends = attrList[attrIdx + 1];
 
+            if(attrList[attrIdx] == ALC_MAX_VOICES_SOFT)
+                numVoices = attrList[attrIdx + 1];
+
             attrIdx += 2;
         }
 
@@ -1195,6 +1247,7 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
         device->NumMonoSources = numMono;
         device->NumStereoSources = numStereo;
         device->NumAuxSends = numSends;
+        device->MaxVoices = numVoices;
     }
 
     if((device->Flags&DEVICE_RUNNING))
@@ -1248,10 +1301,55 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
     }
 
     device->Hrtf = NULL;
-    if(device->Type != Loopback && GetConfigValueBool(NULL, "hrtf", AL_FALSE))
+    if(device->Type != Loopback ? GetConfigValueBool(NULL, "hrtf", AL_FALSE) :
+                                  GetConfigValueBool("loopback", "hrtf", AL_FALSE))
         device->Hrtf = GetHrtf(device);
     TRACE("HRTF %s\n", device->Hrtf?"enabled":"disabled");
 
+    if(device->Hrtf && !device->HrtfCache)
+    {
+        ALuint size = 256;
+        ConfigValueUInt(NULL, "hrtf_cache_size", &size);
+        if(size > 0)
+        {
+            device->HrtfCache = CreateHrtfCache(size);
+            if(!device->HrtfCache)
+                ERR("Failed to allocate HRTF cache\n");
+        }
+    }
+    if(device->HrtfCache)
+        ResetHrtfCache(device->HrtfCache, device->Hrtf);
+
+    device->HrtfFft = AL_FALSE;
+    free(device->HrtfBed);
+    device->HrtfBed = NULL;
+    if(device->Hrtf)
+    {
+        const char *str;
+        if(ConfigValueStr(NULL, "hrtf_convolver", &str))
+        {
+            if(strcasecmp(str, "fft") == 0)
+                device->HrtfFft = AL_TRUE;
+            else if(strcasecmp(str, "direct") != 0)
+                WARN("Invalid HRTF convolver: %s\n", str);
+        }
+        if(ConfigValueStr(NULL, "hrtf_mode", &str))
+        {
+            if(strcasecmp(str, "bed") == 0)
+            {
+                device->HrtfBed = CreateHrtfBed(device->Hrtf);
+                if(!device->HrtfBed)
+                    ERR("Failed to allocate HRTF bed\n");
+            }
+            else if(strcasecmp(str, "full") != 0)
+                WARN("Invalid HRTF mode: %s\n", str);
+        }
+        if(device->HrtfBed)
+            TRACE("HRTF mode: bed\n");
+        else
+            TRACE("HRTF convolver: %s\n", device->HrtfFft?"fft":"direct");
+    }
+
     if(!device->Hrtf && device->Bs2bLevel > 0 && device->Bs2bLevel <= 6)
     {
         if(!device->Bs2b)
@@ -1289,12 +1387,15 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
 
     oldMode = SetMixerFPUMode();
     LockDevice(device);
+    device->RankVoices = AL_TRUE;
     context = device->ContextList;
     while(context)
     {
         ALsizei pos;
 
         context->UpdateSources = AL_FALSE;
+        if(!CalcListenerParams(context))
+            context->UpdateSources = AL_TRUE;
         LockUIntMapRead(&context->EffectSlotMap);
         for(pos = 0;pos < context->EffectSlotMap.size;pos++)
         {
@@ -1365,6 +1466,9 @@ static ALCvoid FreeDevice(ALCdevice *device)
 {
     TRACE("%p\n", device);
 
+    DestroyMixThreadPool(device->MixPool);
+    device->MixPool = NULL;
+
     if(device->DefaultSlot)
     {
         ALeffectState_Destroy(device->DefaultSlot->EffectState);
@@ -1395,6 +1499,22 @@ static ALCvoid FreeDevice(ALCdevice *device)
     free(device->Bs2b);
     device->Bs2b = NULL;
 
+    free(device->HrtfBed);
+    device->HrtfBed = NULL;
+
+    if(device->HrtfCache)
+    {
+        ALuint hits, misses;
+        GetHrtfCacheStats(device->HrtfCache, &hits, &misses);
+        TRACE("HRTF cache: %u hits, %u misses\n", hits, misses);
+    }
+    free(device->HrtfCache);
+    device->HrtfCache = NULL;
+
+    free(device->VoiceRanks);
+    device->VoiceRanks = NULL;
+    device->VoiceRanksSize = 0;
+
     free(device->szDeviceName);
     device->szDeviceName = NULL;
 
@@ -1453,6 +1573,7 @@ static ALvoid InitContext(ALCcontext *pContext)
     //Initialise listener
     pContext->Listener.Gain = 1.0f;
     pContext->Listener.MetersPerUnit = 1.0f;
+    pContext->Listener.PropSeq = 0;
     pContext->Listener.Position[0] = 0.0f;
     pContext->Listener.Position[1] = 0.0f;
     pContext->Listener.Position[2] = 0.0f;
@@ -1470,6 +1591,7 @@ static ALvoid InitContext(ALCcontext *pContext)
         for(j = 0;j < 4;j++)
             pContext->Listener.Matrix[i][j] = ((i==j) ? 1.0f : 0.0f);
     }
+    CalcListenerParams(pContext);
 
     //Validate pContext
     pContext->LastError = AL_NO_ERROR;
@@ -1558,6 +1680,7 @@ static void ReleaseContext(ALCcontext *context, ALCdevice *device)
             break;
         tmp_ctx = &(*tmp_ctx)->next;
     }
+    device->RankVoices = AL_TRUE;
     UnlockDevice(device);
 
     ALCcontext_DecRef(context);
@@ -2002,6 +2125,8 @@ ALC_API ALCvoid ALC_APIENTRY alcGetIntegerv(ALCdevice *device,ALCenum param,ALsi
             case ALC_CAPTURE_SAMPLES:
             case ALC_FORMAT_CHANNELS_SOFT:
             case ALC_FORMAT_TYPE_SOFT:
+            case ALC_MAX_VOICES_SOFT:
+            case ALC_STOLEN_VOICES_SOFT:
                 alcSetError(NULL, ALC_INVALID_DEVICE);
                 break;
 
@@ -2055,11 +2180,11 @@ ALC_API ALCvoid ALC_APIENTRY alcGetIntegerv(ALCdevice *device,ALCenum param,ALsi
                 break;
 
             case ALC_ATTRIBUTES_SIZE:
-                *data = 13;
+                *data = 15;
                 break;
 
             case ALC_ALL_ATTRIBUTES:
-                if(size < 13)
+                if(size < 15)
                     alcSetError(device, ALC_INVALID_VALUE);
                 else
                 {
@@ -2094,6 +2219,9 @@ ALC_API ALCvoid ALC_APIENTRY alcGetIntegerv(ALCdevice *device,ALCenum param,ALsi
                     data[i++] = ALC_MAX_AUXILIARY_SENDS;
                     data[i++] = device->NumAuxSends;
 
+                    data[i++] = ALC_MAX_VOICES_SOFT;
+                    data[i++] = device->MaxVoices;
+
                     data[i++] = 0;
                 }
                 break;
@@ -2142,6 +2270,14 @@ ALC_API ALCvoid ALC_APIENTRY alcGetIntegerv(ALCdevice *device,ALCenum param,ALsi
                 *data = device->NumAuxSends;
                 break;
 
+            case ALC_MAX_VOICES_SOFT:
+                *data = device->MaxVoices;
+                break;
+
+            case ALC_STOLEN_VOICES_SOFT:
+                *data = device->StolenVoices;
+                break;
+
             case ALC_CONNECTED:
                 *data = device->Connected;
                 break;
@@ -2480,6 +2616,11 @@ ALC_API ALCdevice* ALC_APIENTRY alcOpenDevice(const ALCchar *deviceName)
     device->MaxNoOfSources = 256;
     device->AuxiliaryEffectSlotMax = 4;
     device->NumAuxSends = MAX_SENDS;
+    device->MaxVoices = 0;
+    device->StolenVoices = 0;
+    device->RankVoices = AL_FALSE;
+    device->VoiceRanks = NULL;
+    device->VoiceRanksSize = 0;
 
     InitUIntMap(&device->BufferMap, ~0);
     InitUIntMap(&device->EffectMap, ~0);
@@ -2620,6 +2761,8 @@ ALC_API ALCdevice* ALC_APIENTRY alcOpenDevice(const ALCchar *deviceName)
     ConfigValueUInt(NULL, "sends", &device->NumAuxSends);
     if(device->NumAuxSends > MAX_SENDS) device->NumAuxSends = MAX_SENDS;
 
+    ConfigValueUInt(NULL, "max_voices", &device->MaxVoices);
+
     ConfigValueInt(NULL, "cf_level", &device->Bs2bLevel);
 
     device->NumStereoSources = 1;
@@ -2653,6 +2796,8 @@ ALC_API ALCdevice* ALC_APIENTRY alcOpenDevice(const ALCchar *deviceName)
         }
     }
 
+    InitMixThreads(device);
+
     do {
         device->next = DeviceList;
     } while(!CompExchangePtr((XchgPtr*)&DeviceList, device->next, device));
@@ -2744,6 +2889,11 @@ ALC_API ALCdevice* ALC_APIENTRY alcLoopbackOpenDeviceSOFT(const ALCchar *deviceN
     device->MaxNoOfSources = 256;
     device->AuxiliaryEffectSlotMax = 4;
     device->NumAuxSends = MAX_SENDS;
+    device->MaxVoices = 0;
+    device->StolenVoices = 0;
+    device->RankVoices = AL_FALSE;
+    device->VoiceRanks = NULL;
+    device->VoiceRanksSize = 0;
 
     InitUIntMap(&device->BufferMap, ~0);
     InitUIntMap(&device->EffectMap, ~0);
@@ -2766,11 +2916,16 @@ ALC_API ALCdevice* ALC_APIENTRY alcLoopbackOpenDeviceSOFT(const ALCchar *deviceN
     ConfigValueUInt(NULL, "sends", &device->NumAuxSends);
     if(device->NumAuxSends > MAX_SENDS) device->NumAuxSends = MAX_SENDS;
 
+    ConfigValueUInt(NULL, "max_voices", &device->MaxVoices);
+
     device->NumStereoSources = 1;
     device->NumMonoSources = device->MaxNoOfSources - device->NumStereoSources;
 
     // Open the "backend"
     ALCdevice_OpenPlayback(device, "Loopback");
+
+    InitMixThreads(device);
+
     do {
         device->next = DeviceList;
     } while(!CompExchangePtr((XchgPtr*)&DeviceList, device->next, device));
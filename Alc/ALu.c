@@ -48,6 +48,9 @@ ALfloat ConeScale = 0.5f;
 /* Localized Z scalar for mono sources */
 ALfloat ZScale = 1.0f;
 
+/* Sources with all gains below this are not mixed (0 disables) */
+ALfloat VirtualThreshold = 0.0f;
+
 
 static __inline ALvoid aluMatrixVector(ALfloat *vector,ALfloat w,ALfloat matrix[4][4])
 {
@@ -61,6 +64,74 @@ static __inline ALvoid aluMatrixVector(ALfloat *vector,ALfloat w,ALfloat matrix[
 }
 
 
+/* Sets whether the source is a virtual voice, with its direct path and sends
+ * all below the virtual voice threshold, and its score for the voice budget
+ * from the loudest of them */
+static ALvoid SetVoiceAudibility(ALsource *ALSource, ALfloat DryGain,
+                                 ALint NumSends)
+{
+    ALfloat MaxGain = DryGain;
+    ALint i;
+
+    for(i = 0;i < NumSends;i++)
+    {
+        if(ALSource->Params.Send[i].Slot)
+            MaxGain = maxf(MaxGain, ALSource->Params.Send[i].WetGain);
+    }
+    ALSource->Params.Virtual = (MaxGain < VirtualThreshold);
+    ALSource->Params.Score = ALSource->Priority * MaxGain;
+}
+
+/* Picks the HRTF mixer for the source, making sure it has coefficient state
+ * for its channels and the device's HRIR length, and FFT convolution state
+ * when the device uses it. Falls back to the time-domain mixer for the HRIR
+ * length if the FFT state can't be allocated, and to plain panning if the
+ * coefficients can't be. Sources only get panned when the device has an HRTF
+ * bed. */
+static DryMixerFunc SelectHrtfMixer(ALsource *ALSource, const ALCdevice *Device)
+{
+    const ALuint IrSize = GetHrtfIrSize(Device->Hrtf);
+
+    if(Device->HrtfBed)
+        return MixDirect_HrtfBed;
+
+    /* New state has no coefficients to move from */
+    if(!ALSource->Hrtf || ALSource->Hrtf->IrSize != IrSize ||
+       ALSource->Hrtf->NumChannels != ALSource->NumChannels)
+    {
+        ALSource->HrtfMoving = AL_FALSE;
+        ALSource->HrtfCounter = 0;
+    }
+    ALSource->Hrtf = ResizeHrtfState(ALSource->Hrtf, ALSource->NumChannels,
+                                     IrSize);
+    if(!ALSource->Hrtf)
+        return MixDirect;
+
+    if(Device->HrtfFft)
+    {
+        /* New state has no filter to move from */
+        if(!ALSource->HrtfFft || ALSource->HrtfFft->IrSize != IrSize ||
+           ALSource->HrtfFft->NumChannels != ALSource->NumChannels)
+        {
+            ALSource->HrtfMoving = AL_FALSE;
+            ALSource->HrtfCounter = 0;
+        }
+        ALSource->HrtfFft = ResizeHrtfFftState(ALSource->HrtfFft,
+                                               ALSource->NumChannels,
+                                               IrSize);
+        if(ALSource->HrtfFft)
+            return MixDirect_HrtfFft;
+    }
+    switch(IrSize)
+    {
+        case 8: return MixDirect_Hrtf8;
+        case 16: return MixDirect_Hrtf16;
+        case 32: return MixDirect_Hrtf32;
+    }
+    return MixDirect_Hrtf64;
+}
+
+
 ALvoid CalcNonAttnSourceParams(ALsource *ALSource, const ALCcontext *ALContext)
 {
     static const struct ChanMap MonoMap[1] = { { FRONT_CENTER, 0.0f } };
@@ -110,6 +181,7 @@ ALvoid CalcNonAttnSourceParams(ALsource *ALSource, const ALCcontext *ALContext)
     ALfloat SourceVolume,ListenerGain,MinVolume,MaxVolume;
     ALbufferlistitem *BufferListItem;
     enum FmtChannels Channels;
+    enum FmtType FmtType;
     ALfloat (*SrcMatrix)[MAXCHANNELS];
     ALfloat DryGain, DryGainHF;
     ALfloat WetGain[MAX_SENDS];
@@ -130,7 +202,7 @@ ALvoid CalcNonAttnSourceParams(ALsource *ALSource, const ALCcontext *ALContext)
     Frequency = Device->Frequency;
 
     /* Get listener properties */
-    ListenerGain = ALContext->Listener.Gain;
+    ListenerGain = ALContext->Listener.Params.Gain;
 
     /* Get source properties */
     SourceVolume    = ALSource->flGain;
@@ -142,6 +214,7 @@ ALvoid CalcNonAttnSourceParams(ALsource *ALSource, const ALCcontext *ALContext)
 
     /* Calculate the stepping value */
     Channels = FmtMono;
+    FmtType = FmtFloat;
     BufferListItem = ALSource->queue;
     while(BufferListItem != NULL)
     {
@@ -167,14 +240,17 @@ ALvoid CalcNonAttnSourceParams(ALsource *ALSource, const ALCcontext *ALContext)
                 Resampler = PointResampler;
 
             Channels = ALBuffer->FmtChannels;
+            FmtType = ALBuffer->FmtType;
             break;
         }
         BufferListItem = BufferListItem->next;
     }
+    ALSource->Params.Resample = SelectResampler(Resampler, FmtType);
+    ALSource->Params.ResampleStack = SelectResampler(Resampler, FmtFloat);
     if(!DirectChannels && Device->Hrtf)
-        ALSource->Params.DoMix = SelectHrtfMixer(Resampler);
+        ALSource->Params.DryMix = SelectHrtfMixer(ALSource, Device);
     else
-        ALSource->Params.DoMix = SelectMixer(Resampler);
+        ALSource->Params.DryMix = MixDirect;
 
     /* Calculate gains */
     DryGain  = clampf(SourceVolume, MinVolume, MaxVolume);
@@ -262,31 +338,52 @@ ALvoid CalcNonAttnSourceParams(ALsource *ALSource, const ALCcontext *ALContext)
             }
         }
     }
-    else if(Device->Hrtf)
+    else if(Device->HrtfBed)
     {
         for(c = 0;c < num_channels;c++)
         {
+            if(chans[c].channel == LFE)
+            {
+                /* Skip LFE */
+                for(i = 0;i < HRTF_BED_CHANNELS;i++)
+                    ALSource->Params.HrtfBedGains[c][i] = 0.0f;
+                continue;
+            }
+            GetHrtfBedGains(0.0f, chans[c].angle, DryGain*ListenerGain,
+                            ALSource->Params.HrtfBedGains[c]);
+        }
+    }
+    else if(ALSource->Params.DryMix != MixDirect)
+    {
+        const ALuint IrSize = ALSource->Hrtf->IrSize;
+
+        for(c = 0;c < num_channels;c++)
+        {
+            ALfloat (*Coeffs)[2] = &ALSource->Hrtf->Coeffs[c*IrSize];
+
             if(chans[c].channel == LFE)
             {
                 /* Skip LFE */
                 ALSource->Params.HrtfDelay[c][0] = 0;
                 ALSource->Params.HrtfDelay[c][1] = 0;
-                for(i = 0;i < HRIR_LENGTH;i++)
+                for(i = 0;i < (ALint)IrSize;i++)
                 {
-                    ALSource->Params.HrtfCoeffs[c][i][0] = 0.0f;
-                    ALSource->Params.HrtfCoeffs[c][i][1] = 0.0f;
+                    Coeffs[i][0] = 0.0f;
+                    Coeffs[i][1] = 0.0f;
                 }
             }
             else
             {
                 /* Get the static HRIR coefficients and delays for this
                  * channel. */
-                GetLerpedHrtfCoeffs(Device->Hrtf,
+                GetLerpedHrtfCoeffs(Device->Hrtf, Device->HrtfCache,
                                     0.0f, chans[c].angle,
-                                    DryGain*ListenerGain,
-                                    ALSource->Params.HrtfCoeffs[c],
+                                    DryGain*ListenerGain, Coeffs,
                                     ALSource->Params.HrtfDelay[c]);
             }
+            if(ALSource->Params.DryMix == MixDirect_HrtfFft)
+                SetHrtfFftFilter(ALSource->HrtfFft, c, Coeffs,
+                                 ALSource->Params.HrtfDelay[c], 0);
             ALSource->HrtfCounter = 0;
         }
     }
@@ -321,6 +418,7 @@ ALvoid CalcNonAttnSourceParams(ALsource *ALSource, const ALCcontext *ALContext)
         ALSource->Params.Send[i].Slot = Slot;
         ALSource->Params.Send[i].WetGain = WetGain[i] * ListenerGain;
     }
+    SetVoiceAudibility(ALSource, DryGain*ListenerGain, NumSends);
 
     /* Update filter coefficients. Calculations based on the I3DL2
      * spec. */
@@ -338,6 +436,50 @@ ALvoid CalcNonAttnSourceParams(ALsource *ALSource, const ALCcontext *ALContext)
     }
 }
 
+/* Copies the listener properties for the source updates to use. The vector
+ * setters don't take the device lock, so rather than wait out one that's in
+ * progress, this gives up after a few tries and leaves the previous copy in
+ * place, returning AL_FALSE. */
+ALboolean CalcListenerParams(ALCcontext *ALContext)
+{
+    ALlistener *Listener = &ALContext->Listener;
+    ALfloat Position[3], Velocity[3], Matrix[4][4];
+    ALfloat Gain, MetersPerUnit;
+    ALuint tries, i, j;
+    int seq;
+
+    for(tries = 0;tries < 4;tries++)
+    {
+        seq = ReadPropSeq(&Listener->PropSeq);
+        if((seq&1))
+            break;
+
+        for(i = 0;i < 3;i++)
+        {
+            Position[i] = Listener->Position[i];
+            Velocity[i] = Listener->Velocity[i];
+        }
+        for(i = 0;i < 4;i++)
+        {
+            for(j = 0;j < 4;j++)
+                Matrix[i][j] = Listener->Matrix[i][j];
+        }
+        Gain = Listener->Gain;
+        MetersPerUnit = Listener->MetersPerUnit;
+
+        if(EndPropRead(&Listener->PropSeq, seq))
+        {
+            memcpy(Listener->Params.Position, Position, sizeof(Position));
+            memcpy(Listener->Params.Velocity, Velocity, sizeof(Velocity));
+            memcpy(Listener->Params.Matrix, Matrix, sizeof(Matrix));
+            Listener->Params.Gain = Gain;
+            Listener->Params.MetersPerUnit = MetersPerUnit;
+            return AL_TRUE;
+        }
+    }
+    return AL_FALSE;
+}
+
 ALvoid CalcSourceParams(ALsource *ALSource, const ALCcontext *ALContext)
 {
     const ALCdevice *Device = ALContext->Device;
@@ -364,12 +506,15 @@ ALvoid CalcSourceParams(ALsource *ALSource, const ALCcontext *ALContext)
     ALboolean WetGainAuto;
     ALboolean WetGainHFAuto;
     enum Resampler Resampler;
+    enum FmtType FmtType;
     ALfloat Matrix[4][4];
     ALfloat Pitch;
     ALuint Frequency;
     ALint NumSends;
     ALfloat cw;
+    ALuint tries;
     ALint i, j;
+    int seq;
 
     DryGainHF = 1.0f;
     for(i = 0;i < MAX_SENDS;i++)
@@ -382,11 +527,11 @@ ALvoid CalcSourceParams(ALsource *ALSource, const ALCcontext *ALContext)
     Frequency     = Device->Frequency;
 
     //Get listener properties
-    ListenerGain   = ALContext->Listener.Gain;
-    MetersPerUnit  = ALContext->Listener.MetersPerUnit;
-    ListenerVel[0] = ALContext->Listener.Velocity[0];
-    ListenerVel[1] = ALContext->Listener.Velocity[1];
-    ListenerVel[2] = ALContext->Listener.Velocity[2];
+    ListenerGain   = ALContext->Listener.Params.Gain;
+    MetersPerUnit  = ALContext->Listener.Params.MetersPerUnit;
+    ListenerVel[0] = ALContext->Listener.Params.Velocity[0];
+    ListenerVel[1] = ALContext->Listener.Params.Velocity[1];
+    ListenerVel[2] = ALContext->Listener.Params.Velocity[2];
 
     //Get source properties
     SourceVolume   = ALSource->flGain;
@@ -394,15 +539,6 @@ ALvoid CalcSourceParams(ALsource *ALSource, const ALCcontext *ALContext)
     MaxVolume      = ALSource->flMaxGain;
     Pitch          = ALSource->flPitch;
     Resampler      = ALSource->Resampler;
-    Position[0]    = ALSource->vPosition[0] * MetersPerUnit;
-    Position[1]    = ALSource->vPosition[1] * MetersPerUnit;
-    Position[2]    = ALSource->vPosition[2] * MetersPerUnit;
-    Direction[0]   = ALSource->vOrientation[0];
-    Direction[1]   = ALSource->vOrientation[1];
-    Direction[2]   = ALSource->vOrientation[2];
-    Velocity[0]    = ALSource->vVelocity[0];
-    Velocity[1]    = ALSource->vVelocity[1];
-    Velocity[2]    = ALSource->vVelocity[2];
     MinDist        = ALSource->flRefDistance * MetersPerUnit;
     MaxDist        = ALSource->flMaxDistance * MetersPerUnit;
     Rolloff        = ALSource->flRollOffFactor;
@@ -413,6 +549,44 @@ ALvoid CalcSourceParams(ALsource *ALSource, const ALCcontext *ALContext)
     WetGainAuto     = ALSource->WetGainAuto;
     WetGainHFAuto   = ALSource->WetGainHFAuto;
     RoomRolloffBase = ALSource->RoomRolloffFactor;
+
+    // The vectors are written as a set without the device lock, so copy
+    // them out together and only work from the copies. Rather than wait out
+    // a write in progress, use the last copies and update again later.
+    for(tries = 0;tries < 4;tries++)
+    {
+        seq = ReadPropSeq(&ALSource->PropSeq);
+        if((seq&1))
+            break;
+        Position[0]  = ALSource->vPosition[0];
+        Position[1]  = ALSource->vPosition[1];
+        Position[2]  = ALSource->vPosition[2];
+        Direction[0] = ALSource->vOrientation[0];
+        Direction[1] = ALSource->vOrientation[1];
+        Direction[2] = ALSource->vOrientation[2];
+        Velocity[0]  = ALSource->vVelocity[0];
+        Velocity[1]  = ALSource->vVelocity[1];
+        Velocity[2]  = ALSource->vVelocity[2];
+        if(EndPropRead(&ALSource->PropSeq, seq))
+            break;
+    }
+    if(tries == 4 || (seq&1))
+    {
+        memcpy(Position, ALSource->Params.Position, sizeof(Position));
+        memcpy(Direction, ALSource->Params.Direction, sizeof(Direction));
+        memcpy(Velocity, ALSource->Params.Velocity, sizeof(Velocity));
+        ALSource->NeedsUpdate = AL_TRUE;
+    }
+    else
+    {
+        memcpy(ALSource->Params.Position, Position, sizeof(Position));
+        memcpy(ALSource->Params.Direction, Direction, sizeof(Direction));
+        memcpy(ALSource->Params.Velocity, Velocity, sizeof(Velocity));
+    }
+    Position[0] *= MetersPerUnit;
+    Position[1] *= MetersPerUnit;
+    Position[2] *= MetersPerUnit;
+
     for(i = 0;i < NumSends;i++)
     {
         ALeffectslot *Slot = ALSource->Send[i].Slot;
@@ -457,16 +631,16 @@ ALvoid CalcSourceParams(ALsource *ALSource, const ALCcontext *ALContext)
     for(i = 0;i < 4;i++)
     {
         for(j = 0;j < 4;j++)
-            Matrix[i][j] = ALContext->Listener.Matrix[i][j];
+            Matrix[i][j] = ALContext->Listener.Params.Matrix[i][j];
     }
 
     //1. Translate Listener to origin (convert to head relative)
     if(ALSource->bHeadRelative == AL_FALSE)
     {
         /* Translate position */
-        Position[0] -= ALContext->Listener.Position[0] * MetersPerUnit;
-        Position[1] -= ALContext->Listener.Position[1] * MetersPerUnit;
-        Position[2] -= ALContext->Listener.Position[2] * MetersPerUnit;
+        Position[0] -= ALContext->Listener.Params.Position[0] * MetersPerUnit;
+        Position[1] -= ALContext->Listener.Params.Position[1] * MetersPerUnit;
+        Position[2] -= ALContext->Listener.Params.Position[2] * MetersPerUnit;
 
         /* Transform source vectors into listener space */
         aluMatrixVector(Position, 1.0f, Matrix);
@@ -646,6 +820,7 @@ ALvoid CalcSourceParams(ALsource *ALSource, const ALCcontext *ALContext)
                  clampf(SpeedOfSound-VSS, 1.0f, SpeedOfSound*2.0f - 1.0f);
     }
 
+    FmtType = FmtFloat;
     BufferListItem = ALSource->queue;
     while(BufferListItem != NULL)
     {
@@ -670,16 +845,19 @@ ALvoid CalcSourceParams(ALsource *ALSource, const ALCcontext *ALContext)
             if(ALSource->Params.Step == FRACTIONONE)
                 Resampler = PointResampler;
 
+            FmtType = ALBuffer->FmtType;
             break;
         }
         BufferListItem = BufferListItem->next;
     }
+    ALSource->Params.Resample = SelectResampler(Resampler, FmtType);
+    ALSource->Params.ResampleStack = SelectResampler(Resampler, FmtFloat);
     if(Device->Hrtf)
-        ALSource->Params.DoMix = SelectHrtfMixer(Resampler);
+        ALSource->Params.DryMix = SelectHrtfMixer(ALSource, Device);
     else
-        ALSource->Params.DoMix = SelectMixer(Resampler);
+        ALSource->Params.DryMix = MixDirect;
 
-    if(Device->Hrtf)
+    if(ALSource->Params.DryMix != MixDirect)
     {
         // Use a binaural HRTF algorithm for stereo headphone playback
         ALfloat delta, ev = 0.0f, az = 0.0f;
@@ -698,8 +876,11 @@ ALvoid CalcSourceParams(ALsource *ALSource, const ALCcontext *ALContext)
             az = aluAtan2(Position[0], -Position[2]*ZScale);
         }
 
+        // Pan into the bed when the device binauralizes it as a whole.
+        if(Device->HrtfBed)
+            GetHrtfBedGains(ev, az, DryGain, ALSource->Params.HrtfBedGains[0]);
         // Check to see if the HRIR is already moving.
-        if(ALSource->HrtfMoving)
+        else if(ALSource->HrtfMoving)
         {
             // Calculate the normalized HRTF transition factor (delta).
             delta = CalcHrtfDelta(ALSource->Params.HrtfGain, DryGain,
@@ -709,12 +890,17 @@ ALvoid CalcSourceParams(ALsource *ALSource, const ALCcontext *ALContext)
             if(delta > 0.001f)
             {
                 ALSource->HrtfCounter = GetMovingHrtfCoeffs(Device->Hrtf,
-                                          ev, az, DryGain, delta,
+                                          Device->HrtfCache, ev, az, DryGain, delta,
                                           ALSource->HrtfCounter,
-                                          ALSource->Params.HrtfCoeffs[0],
+                                          ALSource->Hrtf->Coeffs,
                                           ALSource->Params.HrtfDelay[0],
-                                          ALSource->Params.HrtfCoeffStep,
+                                          ALSource->Hrtf->CoeffStep,
                                           ALSource->Params.HrtfDelayStep);
+                if(ALSource->Params.DryMix == MixDirect_HrtfFft)
+                    SetHrtfFftFilter(ALSource->HrtfFft, 0,
+                                     ALSource->Hrtf->Coeffs,
+                                     ALSource->Params.HrtfDelay[0],
+                                     ALSource->HrtfCounter);
                 ALSource->Params.HrtfGain = DryGain;
                 ALSource->Params.HrtfDir[0] = Position[0];
                 ALSource->Params.HrtfDir[1] = Position[1];
@@ -724,9 +910,14 @@ ALvoid CalcSourceParams(ALsource *ALSource, const ALCcontext *ALContext)
         else
         {
             // Get the initial (static) HRIR coefficients and delays.
-            GetLerpedHrtfCoeffs(Device->Hrtf, ev, az, DryGain,
-                                ALSource->Params.HrtfCoeffs[0],
+            GetLerpedHrtfCoeffs(Device->Hrtf, Device->HrtfCache,
+                                ev, az, DryGain,
+                                ALSource->Hrtf->Coeffs,
                                 ALSource->Params.HrtfDelay[0]);
+            if(ALSource->Params.DryMix == MixDirect_HrtfFft)
+                SetHrtfFftFilter(ALSource->HrtfFft, 0,
+                                 ALSource->Hrtf->Coeffs,
+                                 ALSource->Params.HrtfDelay[0], 0);
             ALSource->HrtfCounter = 0;
             ALSource->Params.HrtfGain = DryGain;
             ALSource->Params.HrtfDir[0] = Position[0];
@@ -773,6 +964,7 @@ ALvoid CalcSourceParams(ALsource *ALSource, const ALCcontext *ALContext)
     }
     for(i = 0;i < NumSends;i++)
         ALSource->Params.Send[i].WetGain = WetGain[i];
+    SetVoiceAudibility(ALSource, DryGain, NumSends);
 
     /* Update filter coefficients. */
     cw = aluCos(F_PI*2.0f * LOWPASSFREQREF / Frequency);
@@ -809,17 +1001,16 @@ static __inline ALubyte aluF2UB(ALfloat val)
 static void Write_##T##_##N(ALCdevice *device, T *RESTRICT buffer,            \
                             ALuint SamplesToDo)                               \
 {                                                                             \
-    ALfloat (*RESTRICT DryBuffer)[MAXCHANNELS] = device->DryBuffer;           \
-    const enum Channel *ChanMap = device->DevChannels;                        \
+    ALfloat (*RESTRICT DryBuffer)[BUFFERSIZE] = device->DryBuffer;            \
     ALuint i, j;                                                              \
                                                                               \
     for(j = 0;j < N;j++)                                                      \
     {                                                                         \
+        const ALfloat *RESTRICT in = DryBuffer[j];                            \
         T *RESTRICT out = buffer + j;                                         \
-        enum Channel chan = ChanMap[j];                                       \
                                                                               \
         for(i = 0;i < SamplesToDo;i++)                                        \
-            out[i*N] = func(DryBuffer[i][chan]);                              \
+            out[i*N] = func(in[i]);                                           \
     }                                                                         \
 }
 
@@ -911,34 +1102,233 @@ DECL_TEMPLATE(ALbyte)
 
 #undef DECL_TEMPLATE
 
+
+/* Recalculates the source's mixing parameters, unless its properties are
+ * being changed at the moment. In that case the old parameters are kept and
+ * the source is flagged to try again with the next update. The update itself
+ * works from a consistent copy of the properties, so a change starting after
+ * this check only makes it wait for the writer to finish. */
+static ALvoid UpdateSourceParams(ALsource *source, const ALCcontext *context)
+{
+    if(!(ReadPropSeq(&source->PropSeq)&1))
+        ALsource_Update(source, context);
+    else
+        source->NeedsUpdate = AL_TRUE;
+}
+
+/* Orders sources by descending score, with virtual voices last since they
+ * don't count against the budget. Ties go by ID so the order is stable
+ * between updates. */
+/* Orders audible voices before virtual ones, then by descending score, with
+ * the source ID breaking ties. */
+static int CompareVoices(const ALsource *src1, const ALsource *src2)
+{
+    if(src1->Params.Virtual != src2->Params.Virtual)
+        return (src1->Params.Virtual ? 1 : -1);
+    if(src1->Params.Score != src2->Params.Score)
+        return ((src1->Params.Score > src2->Params.Score) ? -1 : 1);
+    if(src1->source != src2->source)
+        return ((src1->source < src2->source) ? -1 : 1);
+    return 0;
+}
+
+/* Partially orders the voices so that the first count are the best ones by
+ * CompareVoices, in no particular order, like nth_element. */
+static void SelectVoices(ALsource **Voices, ALuint total, ALuint count)
+{
+    ALuint lo = 0, hi = total;
+    ALsource *temp;
+    ALuint i, store;
+
+    while(hi-lo > 1)
+    {
+        temp = Voices[lo + (hi-lo)/2];
+        Voices[lo + (hi-lo)/2] = Voices[hi-1];
+        Voices[hi-1] = temp;
+
+        store = lo;
+        for(i = lo;i < hi-1;i++)
+        {
+            if(CompareVoices(Voices[i], Voices[hi-1]) < 0)
+            {
+                temp = Voices[i];
+                Voices[i] = Voices[store];
+                Voices[store++] = temp;
+            }
+        }
+        temp = Voices[hi-1];
+        Voices[hi-1] = Voices[store];
+        Voices[store] = temp;
+
+        if(store == count)
+            break;
+        if(count < store)
+            hi = store;
+        else
+            lo = store+1;
+    }
+}
+
+/* Ranks the playing sources of all the device's contexts, marking all but
+ * the MaxVoices highest scoring audible ones as stolen, and returns how many
+ * were. */
+static ALuint StealVoices(ALCdevice *device)
+{
+    ALuint total = 0;
+    ALuint Stolen = 0;
+    ALCcontext *ctx;
+    ALsizei s;
+    ALuint i;
+
+    for(ctx = device->ContextList;ctx;ctx = ctx->next)
+    {
+        for(s = 0;s < ctx->ActiveSourceCount;s++)
+            ctx->ActiveSources[s]->Params.Stolen = AL_FALSE;
+        total += ctx->ActiveSourceCount;
+    }
+    if(device->MaxVoices == 0 || total <= device->MaxVoices)
+        return 0;
+
+    if(total > device->VoiceRanksSize)
+    {
+        void *temp = realloc(device->VoiceRanks, total*sizeof(*device->VoiceRanks));
+        if(!temp)
+        {
+            ERR("Failed to allocate %u voice ranks\n", total);
+            return 0;
+        }
+        device->VoiceRanks = temp;
+        device->VoiceRanksSize = total;
+    }
+
+    i = 0;
+    for(ctx = device->ContextList;ctx;ctx = ctx->next)
+    {
+        for(s = 0;s < ctx->ActiveSourceCount;s++)
+            device->VoiceRanks[i++] = ctx->ActiveSources[s];
+    }
+
+    SelectVoices(device->VoiceRanks, total, device->MaxVoices);
+    for(i = device->MaxVoices;i < total;i++)
+    {
+        if(device->VoiceRanks[i]->Params.Virtual)
+            continue;
+        device->VoiceRanks[i]->Params.Stolen = AL_TRUE;
+        Stolen++;
+    }
+    return Stolen;
+}
+
+/* Input below this level (-120dB) counts as silence for sleeping effect
+ * slots. */
+#define SLOT_SILENCE_THRESHOLD (0.000001f)
+
+/* Finds the peak input level, stopping early once it isn't silent. */
+static ALfloat SlotInputPeak(const ALfloat *data, ALuint SamplesToDo)
+{
+    ALfloat peak = 0.0f;
+    ALuint i;
+
+    for(i = 0;i < SamplesToDo && peak < SLOT_SILENCE_THRESHOLD;i++)
+        peak = maxf(peak, aluFabs(data[i]));
+    return peak;
+}
+
+static ALvoid ProcessEffectSlot(ALeffectslot *slot, ALCdevice *device, ALuint SamplesToDo, ALboolean update)
+{
+    ALuint tail;
+    ALfloat peak;
+    ALuint i;
+
+    if(slot->ClickRemoval[0] != 0.0f)
+    {
+        for(i = 0;i < SamplesToDo;i++)
+        {
+            slot->WetBuffer[i] += slot->ClickRemoval[0];
+            slot->ClickRemoval[0] -= slot->ClickRemoval[0] * (1.0f/256.0f);
+        }
+    }
+    slot->ClickRemoval[0] += slot->PendingClicks[0];
+    slot->PendingClicks[0] = 0.0f;
+
+    if(update && ExchangeInt(&slot->NeedsUpdate, AL_FALSE))
+        ALeffectState_Update(slot->EffectState, device, slot);
+
+    /* Once the input has been silent for longer than the effect's tail, the
+     * output has decayed too, and the slot sleeps until input comes back. */
+    tail = slot->EffectState->TailLength;
+    peak = SlotInputPeak(slot->WetBuffer, SamplesToDo);
+    if(peak >= SLOT_SILENCE_THRESHOLD)
+        slot->SilentSamples = 0;
+    else if(slot->SilentSamples < tail)
+        slot->SilentSamples += minu(SamplesToDo, tail-slot->SilentSamples);
+    else
+    {
+        if(peak > 0.0f)
+        {
+            for(i = 0;i < SamplesToDo;i++)
+                slot->WetBuffer[i] = 0.0f;
+        }
+        if(aluFabs(slot->ClickRemoval[0]) < SLOT_SILENCE_THRESHOLD)
+            slot->ClickRemoval[0] = 0.0f;
+        return;
+    }
+
+    ALeffectState_Process(slot->EffectState, device, SamplesToDo,
+                          slot->WetBuffer, device->DryBuffer);
+
+    for(i = 0;i < SamplesToDo;i++)
+        slot->WetBuffer[i] = 0.0f;
+}
+
 ALvoid aluMixData(ALCdevice *device, ALvoid *buffer, ALsizei size)
 {
+    const ALuint NumChannels = DryPlanesFromDevice(device);
     ALuint SamplesToDo;
     ALeffectslot **slot, **slot_end;
     ALsource **src, **src_end;
+    ALenum RankVoices;
     ALCcontext *ctx;
+    MixBus Bus;
     int fpuState;
     ALuint i, c;
 
     fpuState = SetMixerFPUMode();
 
+    Bus.DryBuffer = device->DryBuffer;
+    Bus.ClickRemoval = device->ClickRemoval;
+    Bus.PendingClicks = device->PendingClicks;
+    Bus.WetBuffer = NULL;
+    Bus.WetClickRemoval = NULL;
+    Bus.WetPendingClicks = NULL;
+    Bus.Log = NULL;
+
     while(size > 0)
     {
         /* Setup variables */
         SamplesToDo = minu(size, BUFFERSIZE);
 
         /* Clear mixing buffer */
-        memset(device->DryBuffer, 0, SamplesToDo*MAXCHANNELS*sizeof(ALfloat));
+        for(c = 0;c < NumChannels;c++)
+            memset(device->DryBuffer[c], 0, SamplesToDo*sizeof(ALfloat));
 
         LockDevice(device);
+        RankVoices = ExchangeInt(&device->RankVoices, AL_FALSE);
         ctx = device->ContextList;
         while(ctx)
         {
             ALenum DeferUpdates = ctx->DeferUpdates;
             ALenum UpdateSources = AL_FALSE;
 
+            /* Every listener change sets UpdateSources after it's written. If
+             * the listener is being changed again, the sources use the last
+             * copy of it and catch up next time. */
             if(!DeferUpdates)
+            {
                 UpdateSources = ExchangeInt(&ctx->UpdateSources, AL_FALSE);
+                if(UpdateSources && !CalcListenerParams(ctx))
+                    ctx->UpdateSources = AL_TRUE;
+            }
 
             src = ctx->ActiveSources;
             src_end = src + ctx->ActiveSourceCount;
@@ -948,114 +1338,85 @@ ALvoid aluMixData(ALCdevice *device, ALvoid *buffer, ALsizei size)
                 {
                     --(ctx->ActiveSourceCount);
                     *src = *(--src_end);
+                    RankVoices = AL_TRUE;
                     continue;
                 }
 
                 if(!DeferUpdates && (ExchangeInt(&(*src)->NeedsUpdate, AL_FALSE) ||
                                      UpdateSources))
-                    ALsource_Update(*src, ctx);
-
-                MixSource(*src, device, SamplesToDo);
-                src++;
-            }
-
-            /* effect slot processing */
-            slot = ctx->ActiveEffectSlots;
-            slot_end = slot + ctx->ActiveEffectSlotCount;
-            while(slot != slot_end)
-            {
-                for(c = 0;c < SamplesToDo;c++)
                 {
-                    (*slot)->WetBuffer[c] += (*slot)->ClickRemoval[0];
-                    (*slot)->ClickRemoval[0] -= (*slot)->ClickRemoval[0] * (1.0f/256.0f);
+                    UpdateSourceParams(*src, ctx);
+                    RankVoices = AL_TRUE;
                 }
-                (*slot)->ClickRemoval[0] += (*slot)->PendingClicks[0];
-                (*slot)->PendingClicks[0] = 0.0f;
-
-                if(!DeferUpdates && ExchangeInt(&(*slot)->NeedsUpdate, AL_FALSE))
-                    ALeffectState_Update((*slot)->EffectState, device, *slot);
-
-                ALeffectState_Process((*slot)->EffectState, SamplesToDo,
-                                      (*slot)->WetBuffer, device->DryBuffer);
-
-                for(i = 0;i < SamplesToDo;i++)
-                    (*slot)->WetBuffer[i] = 0.0f;
-
-                slot++;
+                src++;
             }
 
             ctx = ctx->next;
         }
 
-        slot = &device->DefaultSlot;
-        if(*slot != NULL)
+        /* The voice budget covers all contexts, and the ranking only changes
+         * along with the playing sources or their scores */
+        if(RankVoices)
+            device->StolenVoices = StealVoices(device);
+
+        ctx = device->ContextList;
+        while(ctx)
         {
-            for(c = 0;c < SamplesToDo;c++)
+            if(device->MixPool)
+                MixSourcesThreaded(device->MixPool, device, ctx, SamplesToDo);
+            else
             {
-                (*slot)->WetBuffer[c] += (*slot)->ClickRemoval[0];
-                (*slot)->ClickRemoval[0] -= (*slot)->ClickRemoval[0] * (1.0f/256.0f);
+                src = ctx->ActiveSources;
+                src_end = src + ctx->ActiveSourceCount;
+                while(src != src_end)
+                    MixSource(*src++, device, &Bus, SamplesToDo);
             }
-            (*slot)->ClickRemoval[0] += (*slot)->PendingClicks[0];
-            (*slot)->PendingClicks[0] = 0.0f;
-
-            if(ExchangeInt(&(*slot)->NeedsUpdate, AL_FALSE))
-                ALeffectState_Update((*slot)->EffectState, device, *slot);
 
-            ALeffectState_Process((*slot)->EffectState, SamplesToDo,
-                                  (*slot)->WetBuffer, device->DryBuffer);
+            /* effect slot processing */
+            slot = ctx->ActiveEffectSlots;
+            slot_end = slot + ctx->ActiveEffectSlotCount;
+            while(slot != slot_end)
+                ProcessEffectSlot(*slot++, device, SamplesToDo, !ctx->DeferUpdates);
 
-            for(i = 0;i < SamplesToDo;i++)
-                (*slot)->WetBuffer[i] = 0.0f;
+            ctx = ctx->next;
         }
+
+        if(device->DefaultSlot != NULL)
+            ProcessEffectSlot(device->DefaultSlot, device, SamplesToDo, AL_TRUE);
         UnlockDevice(device);
 
         //Post processing loop
-        if(device->FmtChans == DevFmtMono)
+        for(c = 0;c < NumChannels;c++)
         {
+            ALfloat *RESTRICT DryBuffer = device->DryBuffer[c];
+            ALfloat ClickRemoval = device->ClickRemoval[c];
+
             for(i = 0;i < SamplesToDo;i++)
             {
-                device->DryBuffer[i][FRONT_CENTER] += device->ClickRemoval[FRONT_CENTER];
-                device->ClickRemoval[FRONT_CENTER] -= device->ClickRemoval[FRONT_CENTER] * (1.0f/256.0f);
+                DryBuffer[i] += ClickRemoval;
+                ClickRemoval -= ClickRemoval * (1.0f/256.0f);
             }
-            device->ClickRemoval[FRONT_CENTER] += device->PendingClicks[FRONT_CENTER];
-            device->PendingClicks[FRONT_CENTER] = 0.0f;
+            device->ClickRemoval[c] = ClickRemoval + device->PendingClicks[c];
+            device->PendingClicks[c] = 0.0f;
         }
-        else if(device->FmtChans == DevFmtStereo)
+        if(device->HrtfBed)
         {
             /* Assumes the first two channels are FRONT_LEFT and FRONT_RIGHT */
-            for(i = 0;i < SamplesToDo;i++)
-            {
-                for(c = 0;c < 2;c++)
-                {
-                    device->DryBuffer[i][c] += device->ClickRemoval[c];
-                    device->ClickRemoval[c] -= device->ClickRemoval[c] * (1.0f/256.0f);
-                }
-            }
-            for(c = 0;c < 2;c++)
-            {
-                device->ClickRemoval[c] += device->PendingClicks[c];
-                device->PendingClicks[c] = 0.0f;
-            }
-            if(device->Bs2b)
-            {
-                for(i = 0;i < SamplesToDo;i++)
-                    bs2b_cross_feed(device->Bs2b, &device->DryBuffer[i][0]);
-            }
+            MixHrtfBed(device->HrtfBed,
+                       &device->DryBuffer[ChannelsFromDevFmt(device->FmtChans)],
+                       device->DryBuffer, SamplesToDo);
         }
-        else
+        if(device->FmtChans == DevFmtStereo && device->Bs2b)
         {
+            /* Assumes the first two channels are FRONT_LEFT and FRONT_RIGHT */
+            ALfloat samples[2];
             for(i = 0;i < SamplesToDo;i++)
             {
-                for(c = 0;c < MAXCHANNELS;c++)
-                {
-                    device->DryBuffer[i][c] += device->ClickRemoval[c];
-                    device->ClickRemoval[c] -= device->ClickRemoval[c] * (1.0f/256.0f);
-                }
-            }
-            for(c = 0;c < MAXCHANNELS;c++)
-            {
-                device->ClickRemoval[c] += device->PendingClicks[c];
-                device->PendingClicks[c] = 0.0f;
+                samples[0] = device->DryBuffer[0][i];
+                samples[1] = device->DryBuffer[1][i];
+                bs2b_cross_feed(device->Bs2b, samples);
+                device->DryBuffer[0][i] = samples[0];
+                device->DryBuffer[1][i] = samples[1];
             }
         }
 
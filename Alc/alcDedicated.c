@@ -74,19 +74,18 @@ static ALvoid DedicatedUpdate(ALeffectState *effect, ALCdevice *device, const AL
         state->gains[LFE] = Gain;
 }
 
-static ALvoid DedicatedProcess(ALeffectState *effect, ALuint SamplesToDo, const ALfloat *SamplesIn, ALfloat (*SamplesOut)[MAXCHANNELS])
+static ALvoid DedicatedProcess(ALeffectState *effect, const ALCdevice *Device, ALuint SamplesToDo, const ALfloat *SamplesIn, ALfloat (*SamplesOut)[BUFFERSIZE])
 {
     ALdedicatedState *state = (ALdedicatedState*)effect;
-    const ALfloat *gains = state->gains;
+    const ALuint NumChannels = ChannelsFromDevFmt(Device->FmtChans);
     ALuint i, s;
 
-    for(i = 0;i < SamplesToDo;i++)
+    for(s = 0;s < NumChannels;s++)
     {
-        ALfloat sample;
+        const ALfloat gain = state->gains[Device->DevChannels[s]];
 
-        sample = SamplesIn[i];
-        for(s = 0;s < MAXCHANNELS;s++)
-            SamplesOut[i][s] = sample * gains[s];
+        for(i = 0;i < SamplesToDo;i++)
+            SamplesOut[s][i] += SamplesIn[i] * gain;
     }
 }
 
@@ -103,6 +102,7 @@ ALeffectState *DedicatedCreate(void)
     state->state.DeviceUpdate = DedicatedDeviceUpdate;
     state->state.Update = DedicatedUpdate;
     state->state.Process = DedicatedProcess;
+    state->state.TailLength = 0;
 
     for(s = 0;s < MAXCHANNELS;s++)
         state->gains[s] = 0.0f;
@@ -96,7 +96,7 @@ static ALvoid EchoUpdate(ALeffectState *effect, ALCdevice *Device, const ALeffec
     ALuint frequency = Device->Frequency;
     ALfloat dirGain, ambientGain;
     const ALfloat *ChannelGain;
-    ALfloat lrpan, cw, g, gain;
+    ALfloat lrpan, cw, g, gain, length;
     ALuint i, pos;
 
     state->Tap[0].delay = fastf2u(Slot->effect.Echo.Delay * frequency) + 1;
@@ -107,6 +107,20 @@ static ALvoid EchoUpdate(ALeffectState *effect, ALCdevice *Device, const ALeffec
 
     state->FeedGain = Slot->effect.Echo.Feedback;
 
+    /* The tail lasts until the fed back taps decay by 120dB. Full feedback
+     * never decays. */
+    length = 0.0f;
+    if(state->FeedGain < 1.0f)
+    {
+        length = (ALfloat)state->Tap[1].delay;
+        if(state->FeedGain > 0.0f)
+            length += length * aluLog10(0.000001f) / aluLog10(state->FeedGain);
+    }
+    if(length > 0.0f && length < 2147483647.0f)
+        state->state.TailLength = fastf2u(length);
+    else
+        state->state.TailLength = ~0u;
+
     cw = aluCos(F_PI*2.0f * LOWPASSFREQREF / frequency);
     g = 1.0f - Slot->effect.Echo.Damping;
     state->iirFilter.coeff = lpCoeffCalc(g, cw);
@@ -142,27 +156,35 @@ static ALvoid EchoUpdate(ALeffectState *effect, ALCdevice *Device, const ALeffec
     }
 }
 
-static ALvoid EchoProcess(ALeffectState *effect, ALuint SamplesToDo, const ALfloat *SamplesIn, ALfloat (*SamplesOut)[MAXCHANNELS])
+static ALvoid EchoProcess(ALeffectState *effect, const ALCdevice *Device, ALuint SamplesToDo, const ALfloat *SamplesIn, ALfloat (*SamplesOut)[BUFFERSIZE])
 {
     ALechoState *state = (ALechoState*)effect;
+    const ALuint NumChannels = ChannelsFromDevFmt(Device->FmtChans);
     const ALuint mask = state->BufferLength-1;
     const ALuint tap1 = state->Tap[0].delay;
     const ALuint tap2 = state->Tap[1].delay;
     ALuint offset = state->Offset;
+    ALfloat gain[2][MAXCHANNELS];
     ALfloat smp;
     ALuint i, k;
 
+    for(k = 0;k < NumChannels;k++)
+    {
+        gain[0][k] = state->Gain[0][Device->DevChannels[k]];
+        gain[1][k] = state->Gain[1][Device->DevChannels[k]];
+    }
+
     for(i = 0;i < SamplesToDo;i++,offset++)
     {
         /* First tap */
         smp = state->SampleBuffer[(offset-tap1) & mask];
-        for(k = 0;k < MAXCHANNELS;k++)
-            SamplesOut[i][k] += smp * state->Gain[0][k];
+        for(k = 0;k < NumChannels;k++)
+            SamplesOut[k][i] += smp * gain[0][k];
 
         /* Second tap */
         smp = state->SampleBuffer[(offset-tap2) & mask];
-        for(k = 0;k < MAXCHANNELS;k++)
-            SamplesOut[i][k] += smp * state->Gain[1][k];
+        for(k = 0;k < NumChannels;k++)
+            SamplesOut[k][i] += smp * gain[1][k];
 
         // Apply damping and feedback gain to the second tap, and mix in the
         // new sample
@@ -184,6 +206,7 @@ ALeffectState *EchoCreate(void)
     state->state.DeviceUpdate = EchoDeviceUpdate;
     state->state.Update = EchoUpdate;
     state->state.Process = EchoProcess;
+    state->state.TailLength = 0;
 
     state->BufferLength = 0;
     state->SampleBuffer = NULL;
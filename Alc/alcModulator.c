@@ -83,14 +83,20 @@ static __inline ALfloat hpFilter1P(FILTER *iir, ALuint offset, ALfloat input)
 
 
 #define DECL_TEMPLATE(func)                                                   \
-static void Process##func(ALmodulatorState *state, ALuint SamplesToDo,        \
-  const ALfloat *SamplesIn, ALfloat (*SamplesOut)[MAXCHANNELS])               \
+static void Process##func(ALmodulatorState *state, const ALCdevice *Device,   \
+  ALuint SamplesToDo, const ALfloat *SamplesIn,                               \
+  ALfloat (*SamplesOut)[BUFFERSIZE])                                          \
 {                                                                             \
+    const ALuint NumChannels = ChannelsFromDevFmt(Device->FmtChans);          \
     const ALuint step = state->step;                                          \
     ALuint index = state->index;                                              \
+    ALfloat gain[MAXCHANNELS];                                                \
     ALfloat samp;                                                             \
     ALuint i, k;                                                              \
                                                                               \
+    for(k = 0;k < NumChannels;k++)                                            \
+        gain[k] = state->Gain[Device->DevChannels[k]];                        \
+                                                                              \
     for(i = 0;i < SamplesToDo;i++)                                            \
     {                                                                         \
         samp = SamplesIn[i];                                                  \
@@ -101,8 +107,8 @@ static void Process##func(ALmodulatorState *state, ALuint SamplesToDo,        \
                                                                               \
         samp = hpFilter1P(&state->iirFilter, 0, samp);                        \
                                                                               \
-        for(k = 0;k < MAXCHANNELS;k++)                                        \
-            SamplesOut[i][k] += state->Gain[k] * samp;                        \
+        for(k = 0;k < NumChannels;k++)                                        \
+            SamplesOut[k][i] += gain[k] * samp;                               \
     }                                                                         \
     state->index = index;                                                     \
 }
@@ -160,22 +166,22 @@ static ALvoid ModulatorUpdate(ALeffectState *effect, ALCdevice *Device, const AL
     }
 }
 
-static ALvoid ModulatorProcess(ALeffectState *effect, ALuint SamplesToDo, const ALfloat *SamplesIn, ALfloat (*SamplesOut)[MAXCHANNELS])
+static ALvoid ModulatorProcess(ALeffectState *effect, const ALCdevice *Device, ALuint SamplesToDo, const ALfloat *SamplesIn, ALfloat (*SamplesOut)[BUFFERSIZE])
 {
     ALmodulatorState *state = (ALmodulatorState*)effect;
 
     switch(state->Waveform)
     {
         case SINUSOID:
-            ProcessSin(state, SamplesToDo, SamplesIn, SamplesOut);
+            ProcessSin(state, Device, SamplesToDo, SamplesIn, SamplesOut);
             break;
 
         case SAWTOOTH:
-            ProcessSaw(state, SamplesToDo, SamplesIn, SamplesOut);
+            ProcessSaw(state, Device, SamplesToDo, SamplesIn, SamplesOut);
             break;
 
         case SQUARE:
-            ProcessSquare(state, SamplesToDo, SamplesIn, SamplesOut);
+            ProcessSquare(state, Device, SamplesToDo, SamplesIn, SamplesOut);
             break;
     }
 }
@@ -192,6 +198,7 @@ ALeffectState *ModulatorCreate(void)
     state->state.DeviceUpdate = ModulatorDeviceUpdate;
     state->state.Update = ModulatorUpdate;
     state->state.Process = ModulatorProcess;
+    state->state.TailLength = 0;
 
     state->index = 0;
     state->step = 1;
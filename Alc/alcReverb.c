@@ -22,6 +22,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #include "AL/al.h"
@@ -40,6 +41,71 @@ typedef struct DelayLine
     ALfloat *Line;
 } DelayLine;
 
+/* The reverb coefficients that are interpolated when they change.  They're
+ * only floats, so the fading code can step them as an array.
+ */
+typedef struct VerbCoeffs {
+    // Master effect low-pass filter coefficient.
+    ALfloat   LpCoeff;
+
+    struct {
+        // Output gain for early reflections.
+        ALfloat   Gain;
+
+        // Early reflection delay line coefficients.
+        ALfloat   Coeff[4];
+
+        // The gain for each output channel based on 3D panning (only for the
+        // EAX path).
+        ALfloat   PanGain[MAXCHANNELS];
+    } Early;
+
+    struct {
+        // Output gain for late reverb.
+        ALfloat   Gain;
+
+        // Attenuation to compensate for the modal density and decay rate of
+        // the late lines.
+        ALfloat   DensityGain;
+
+        // The feed-back and feed-forward all-pass coefficient.
+        ALfloat   ApFeedCoeff;
+
+        // Mixing matrix coefficient.
+        ALfloat   MixCoeff;
+
+        // All-pass and cyclical delay line coefficients.
+        ALfloat   ApCoeff[4];
+        ALfloat   Coeff[4];
+
+        // The cyclical delay lines' low-pass filter coefficients.
+        ALfloat   LpCoeff[4];
+
+        // The gain for each output channel based on 3D panning (the non-EAX
+        // path uses it for its plain channel gains).
+        ALfloat   PanGain[MAXCHANNELS];
+    } Late;
+
+    struct {
+        // Attenuation to compensate for the modal density and decay rate of
+        // the echo line.
+        ALfloat   DensityGain;
+
+        // Echo delay and all-pass line coefficients.
+        ALfloat   Coeff;
+        ALfloat   ApFeedCoeff;
+        ALfloat   ApCoeff;
+
+        // The echo line's low-pass filter coefficient.
+        ALfloat   LpCoeff;
+
+        // Echo mixing coefficients.
+        ALfloat   MixCoeff[2];
+    } Echo;
+} VerbCoeffs;
+
+#define VERB_COEFF_COUNT (sizeof(VerbCoeffs)/sizeof(ALfloat))
+
 typedef struct ALverbState {
     // Must be first in all effects!
     ALeffectState state;
@@ -75,17 +141,9 @@ typedef struct ALverbState {
     ALuint    DelayTap[2];
 
     struct {
-        // Output gain for early reflections.
-        ALfloat   Gain;
-
         // Early reflections are done with 4 delay lines.
-        ALfloat   Coeff[4];
         DelayLine Delay[4];
         ALuint    Offset[4];
-
-        // The gain for each output channel based on 3D panning (only for the
-        // EAX path).
-        ALfloat   PanGain[MAXCHANNELS];
     } Early;
 
     // Decorrelator delay line.
@@ -95,68 +153,68 @@ typedef struct ALverbState {
     ALuint    DecoTap[3];
 
     struct {
-        // Output gain for late reverb.
-        ALfloat   Gain;
-
-        // Attenuation to compensate for the modal density and decay rate of
-        // the late lines.
-        ALfloat   DensityGain;
-
-        // The feed-back and feed-forward all-pass coefficient.
-        ALfloat   ApFeedCoeff;
-
-        // Mixing matrix coefficient.
-        ALfloat   MixCoeff;
-
         // Late reverb has 4 parallel all-pass filters.
-        ALfloat   ApCoeff[4];
         DelayLine ApDelay[4];
         ALuint    ApOffset[4];
 
         // In addition to 4 cyclical delay lines.
-        ALfloat   Coeff[4];
         DelayLine Delay[4];
         ALuint    Offset[4];
 
         // The cyclical delay lines are 1-pole low-pass filtered.
-        ALfloat   LpCoeff[4];
         ALfloat   LpSample[4];
-
-        // The gain for each output channel based on 3D panning (only for the
-        // EAX path).
-        ALfloat   PanGain[MAXCHANNELS];
     } Late;
 
     struct {
-        // Attenuation to compensate for the modal density and decay rate of
-        // the echo line.
-        ALfloat   DensityGain;
-
         // Echo delay and all-pass lines.
         DelayLine Delay;
         DelayLine ApDelay;
 
-        ALfloat   Coeff;
-        ALfloat   ApFeedCoeff;
-        ALfloat   ApCoeff;
-
         ALuint    Offset;
         ALuint    ApOffset;
 
         // The echo line is 1-pole low-pass filtered.
-        ALfloat   LpCoeff;
         ALfloat   LpSample;
-
-        // Echo mixing coefficients.
-        ALfloat   MixCoeff[2];
     } Echo;
 
+    // The coefficients being processed with, and the ones set by the last
+    // update.  When they differ, processing fades to the new ones over the
+    // next mix, with the per-sample steps held in Step.
+    VerbCoeffs Coeffs;
+    VerbCoeffs Target;
+    VerbCoeffs Step;
+    ALboolean  Fading;
+
+    // The properties the coefficients were last calculated from, so an
+    // update only has to recalculate the stages whose properties changed.
+    // A full update is needed after the device changes.
+    struct ALreverbProps Props;
+    ALfloat    SlotGain;
+    ALboolean  IsEAX;
+    ALboolean  FullUpdate;
+
+    // The late reverb and echo lines run at the output rate divided by this.
+    // Their input is decimated by averaging each group of samples, and their
+    // output is linearly interpolated back up to the output rate.
+    ALuint Decimation;
+
+    struct {
+        // The sum of the input so far in the current group of samples, and
+        // how many samples it holds.
+        ALfloat Sum;
+        ALuint  Count;
+
+        // The last two decimated late reverb outputs, which are being
+        // interpolated between.
+        ALfloat Last[4];
+        ALfloat Next[4];
+    } Decim;
+
     // The current read offset for all delay lines.
     ALuint Offset;
-
-    // The gain for each output channel (non-EAX path only; aliased from
-    // Late.PanGain)
-    ALfloat *Gain;
+    // The current read offset for the late reverb and echo lines, which only
+    // advances once per group of samples when decimating.
+    ALuint LateOffset;
 } ALverbState;
 
 /* This is a user config option for modifying the overall output of the reverb
@@ -167,6 +225,10 @@ ALfloat ReverbBoost = 1.0f;
 /* Specifies whether to use a standard reverb effect in place of EAX reverb */
 ALboolean EmulateEAXReverb = AL_FALSE;
 
+/* The factor to divide the output rate by for the late reverb and echo (1, 2,
+ * or 4) */
+ALuint ReverbDecimation = 1;
+
 /* This coefficient is used to define the maximum frequency range controlled
  * by the modulation depth.  The current value of 0.1 will allow it to swing
  * from 0.9x to 1.1x.  This value must be below 1.  At 1 it will cause the
@@ -252,10 +314,10 @@ static __inline ALfloat AllpassInOut(DelayLine *Delay, ALuint outOffset, ALuint
 
 // Given an input sample, this function produces modulation for the late
 // reverb.
-static __inline ALfloat EAXModulation(ALverbState *State, ALfloat in)
+static __inline ALfloat EAXModulation(ALverbState *State, ALuint offset, ALfloat in)
 {
     ALfloat sinus, frac;
-    ALuint offset;
+    ALuint delay;
     ALfloat out0, out1;
 
     // Calculate the sinus rythm (dependent on modulation time and the
@@ -270,15 +332,15 @@ static __inline ALfloat EAXModulation(ALverbState *State, ALfloat in)
                              State->Mod.Coeff);
 
     // Calculate the read offset and fraction between it and the next sample.
-    frac   = (1.0f + (State->Mod.Filter * sinus));
-    offset = fastf2u(frac);
-    frac  -= offset;
+    frac  = (1.0f + (State->Mod.Filter * sinus));
+    delay = fastf2u(frac);
+    frac -= delay;
 
     // Get the two samples crossed by the offset, and feed the delay line
     // with the next input sample.
-    out0 = DelayLineOut(&State->Mod.Delay, State->Offset - offset);
-    out1 = DelayLineOut(&State->Mod.Delay, State->Offset - offset - 1);
-    DelayLineIn(&State->Mod.Delay, State->Offset, in);
+    out0 = DelayLineOut(&State->Mod.Delay, offset - delay);
+    out1 = DelayLineOut(&State->Mod.Delay, offset - delay - 1);
+    DelayLineIn(&State->Mod.Delay, offset, in);
 
     // Step the modulation index forward, keeping it bound to its range.
     State->Mod.Index = (State->Mod.Index + 1) % State->Mod.Range;
@@ -288,305 +350,540 @@ static __inline ALfloat EAXModulation(ALverbState *State, ALfloat in)
     return lerp(out0, out1, frac);
 }
 
-// Delay line output routine for early reflections.
-static __inline ALfloat EarlyDelayLineOut(ALverbState *State, ALuint index)
-{
-    return AttenuatedDelayLineOut(&State->Early.Delay[index],
-                                  State->Offset - State->Early.Offset[index],
-                                  State->Early.Coeff[index]);
-}
+/* The reverb is processed in blocks of up to this many samples, running each
+ * stage over the whole block before moving to the next.  The stages only
+ * share the initial delay line, which is given this many samples of extra
+ * room so a whole block can be fed in before the taps read from it, and every
+ * stage still sees the same samples it would processing one sample at a time.
+ */
+#define REVERB_BLOCK_SIZE 256
 
-// Given an input sample, this function produces four-channel output for the
-// early reflections.
-static __inline ALvoid EarlyReflection(ALverbState *State, ALfloat in, ALfloat *out)
+// Sets up the per-sample steps to fade the coefficients to their targets over
+// a mix of the given length.
+static ALvoid StartCoeffFade(ALverbState *State, ALuint SamplesToDo)
 {
-    ALfloat d[4], v, f[4];
-
-    // Obtain the decayed results of each early delay line.
-    d[0] = EarlyDelayLineOut(State, 0);
-    d[1] = EarlyDelayLineOut(State, 1);
-    d[2] = EarlyDelayLineOut(State, 2);
-    d[3] = EarlyDelayLineOut(State, 3);
-
-    /* The following uses a lossless scattering junction from waveguide
-     * theory.  It actually amounts to a householder mixing matrix, which
-     * will produce a maximally diffuse response, and means this can probably
-     * be considered a simple feed-back delay network (FDN).
-     *          N
-     *         ---
-     *         \
-     * v = 2/N /   d_i
-     *         ---
-     *         i=1
-     */
-    v = (d[0] + d[1] + d[2] + d[3]) * 0.5f;
-    // The junction is loaded with the input here.
-    v += in;
-
-    // Calculate the feed values for the delay lines.
-    f[0] = v - d[0];
-    f[1] = v - d[1];
-    f[2] = v - d[2];
-    f[3] = v - d[3];
-
-    // Re-feed the delay lines.
-    DelayLineIn(&State->Early.Delay[0], State->Offset, f[0]);
-    DelayLineIn(&State->Early.Delay[1], State->Offset, f[1]);
-    DelayLineIn(&State->Early.Delay[2], State->Offset, f[2]);
-    DelayLineIn(&State->Early.Delay[3], State->Offset, f[3]);
-
-    // Output the results of the junction for all four channels.
-    out[0] = State->Early.Gain * f[0];
-    out[1] = State->Early.Gain * f[1];
-    out[2] = State->Early.Gain * f[2];
-    out[3] = State->Early.Gain * f[3];
+    const ALfloat *target = (const ALfloat*)&State->Target;
+    const ALfloat *coeffs = (const ALfloat*)&State->Coeffs;
+    ALfloat *step = (ALfloat*)&State->Step;
+    const ALfloat scale = 1.0f / SamplesToDo;
+    ALuint i;
+
+    for(i = 0;i < VERB_COEFF_COUNT;i++)
+        step[i] = (target[i] - coeffs[i]) * scale;
 }
 
-// All-pass input/output routine for late reverb.
-static __inline ALfloat LateAllPassInOut(ALverbState *State, ALuint index, ALfloat in)
+// Lands the coefficients exactly on their targets at the end of a fade.
+static ALvoid EndCoeffFade(ALverbState *State)
 {
-    return AllpassInOut(&State->Late.ApDelay[index],
-                        State->Offset - State->Late.ApOffset[index],
-                        State->Offset, in, State->Late.ApFeedCoeff,
-                        State->Late.ApCoeff[index]);
+    State->Coeffs = State->Target;
+    memset(&State->Step, 0, sizeof(State->Step));
+    State->Fading = AL_FALSE;
 }
 
-// Delay line output routine for late reverb.
-static __inline ALfloat LateDelayLineOut(ALverbState *State, ALuint index)
+// Low-pass filters a block of input samples and feeds them to the initial
+// delay line, modulating them first for EAX reverb.
+static ALvoid FeedInitialDelay(ALverbState *State, const ALfloat *in, ALuint todo, ALboolean modulate)
 {
-    return AttenuatedDelayLineOut(&State->Late.Delay[index],
-                                  State->Offset - State->Late.Offset[index],
-                                  State->Late.Coeff[index]);
-}
+    ALfloat coeff = State->Coeffs.LpCoeff;
+    const ALfloat step = State->Step.LpCoeff;
+    ALfloat sample;
+    ALuint i;
 
-// Low-pass filter input/output routine for late reverb.
-static __inline ALfloat LateLowPassInOut(ALverbState *State, ALuint index, ALfloat in)
-{
-    in = lerp(in, State->Late.LpSample[index], State->Late.LpCoeff[index]);
-    State->Late.LpSample[index] = in;
-    return in;
+    for(i = 0;i < todo;i++)
+    {
+        State->LpFilter.coeff = coeff;
+        coeff += step;
+
+        sample = lpFilter2P(&State->LpFilter, 0, in[i]);
+        if(modulate)
+            sample = EAXModulation(State, State->Offset+i, sample);
+        DelayLineIn(&State->Delay, State->Offset+i, sample);
+    }
+    State->Coeffs.LpCoeff = coeff;
 }
 
-// Given four decorrelated input samples, this function produces four-channel
-// output for the late reverb.
-static __inline ALvoid LateReverb(ALverbState *State, ALfloat *in, ALfloat *out)
+// Produces a block of four-channel output for the early reflections, fed
+// from the first initial delay tap.  The four delay lines are handled as
+// lanes, so only the line reads and writes are done one line at a time.
+static ALvoid EarlyReflectionBlock(ALverbState *State, ALuint todo, ALfloat (*RESTRICT out)[4])
 {
-    ALfloat d[4], f[4];
+    ALfloat gain = State->Coeffs.Early.Gain;
+    const ALfloat gainStep = State->Step.Early.Gain;
+    ALfloat coeff[4], coeffStep[4], d[4], f[4], v;
+    ALuint offset, i, j;
 
-    // Obtain the decayed results of the cyclical delay lines, and add the
-    // corresponding input channels.  Then pass the results through the
-    // low-pass filters.
+    for(j = 0;j < 4;j++)
+    {
+        coeff[j] = State->Coeffs.Early.Coeff[j];
+        coeffStep[j] = State->Step.Early.Coeff[j];
+    }
 
-    // This is where the feed-back cycles from line 0 to 1 to 3 to 2 and back
-    // to 0.
-    d[0] = LateLowPassInOut(State, 2, in[2] + LateDelayLineOut(State, 2));
-    d[1] = LateLowPassInOut(State, 0, in[0] + LateDelayLineOut(State, 0));
-    d[2] = LateLowPassInOut(State, 3, in[3] + LateDelayLineOut(State, 3));
-    d[3] = LateLowPassInOut(State, 1, in[1] + LateDelayLineOut(State, 1));
-
-    // To help increase diffusion, run each line through an all-pass filter.
-    // When there is no diffusion, the shortest all-pass filter will feed the
-    // shortest delay line.
-    d[0] = LateAllPassInOut(State, 0, d[0]);
-    d[1] = LateAllPassInOut(State, 1, d[1]);
-    d[2] = LateAllPassInOut(State, 2, d[2]);
-    d[3] = LateAllPassInOut(State, 3, d[3]);
-
-    /* Late reverb is done with a modified feed-back delay network (FDN)
-     * topology.  Four input lines are each fed through their own all-pass
-     * filter and then into the mixing matrix.  The four outputs of the
-     * mixing matrix are then cycled back to the inputs.  Each output feeds
-     * a different input to form a circlular feed cycle.
-     *
-     * The mixing matrix used is a 4D skew-symmetric rotation matrix derived
-     * using a single unitary rotational parameter:
-     *
-     *  [  d,  a,  b,  c ]          1 = a^2 + b^2 + c^2 + d^2
-     *  [ -a,  d,  c, -b ]
-     *  [ -b, -c,  d,  a ]
-     *  [ -c,  b, -a,  d ]
-     *
-     * The rotation is constructed from the effect's diffusion parameter,
-     * yielding:  1 = x^2 + 3 y^2; where a, b, and c are the coefficient y
-     * with differing signs, and d is the coefficient x.  The matrix is thus:
-     *
-     *  [  x,  y, -y,  y ]          n = sqrt(matrix_order - 1)
-     *  [ -y,  x,  y,  y ]          t = diffusion_parameter * atan(n)
-     *  [  y, -y,  x,  y ]          x = cos(t)
-     *  [ -y, -y, -y,  x ]          y = sin(t) / n
-     *
-     * To reduce the number of multiplies, the x coefficient is applied with
-     * the cyclical delay line coefficients.  Thus only the y coefficient is
-     * applied when mixing, and is modified to be:  y / x.
-     */
-    f[0] = d[0] + (State->Late.MixCoeff * (         d[1] + -d[2] + d[3]));
-    f[1] = d[1] + (State->Late.MixCoeff * (-d[0]         +  d[2] + d[3]));
-    f[2] = d[2] + (State->Late.MixCoeff * ( d[0] + -d[1]         + d[3]));
-    f[3] = d[3] + (State->Late.MixCoeff * (-d[0] + -d[1] + -d[2]       ));
-
-    // Output the results of the matrix for all four channels, attenuated by
-    // the late reverb gain (which is attenuated by the 'x' mix coefficient).
-    out[0] = State->Late.Gain * f[0];
-    out[1] = State->Late.Gain * f[1];
-    out[2] = State->Late.Gain * f[2];
-    out[3] = State->Late.Gain * f[3];
-
-    // Re-feed the cyclical delay lines.
-    DelayLineIn(&State->Late.Delay[0], State->Offset, f[0]);
-    DelayLineIn(&State->Late.Delay[1], State->Offset, f[1]);
-    DelayLineIn(&State->Late.Delay[2], State->Offset, f[2]);
-    DelayLineIn(&State->Late.Delay[3], State->Offset, f[3]);
+    for(i = 0;i < todo;i++)
+    {
+        offset = State->Offset + i;
+
+        // Obtain the decayed results of each early delay line.
+        for(j = 0;j < 4;j++)
+            d[j] = DelayLineOut(&State->Early.Delay[j],
+                                offset - State->Early.Offset[j]);
+        for(j = 0;j < 4;j++)
+            d[j] *= coeff[j];
+
+        /* The following uses a lossless scattering junction from waveguide
+         * theory.  It actually amounts to a householder mixing matrix, which
+         * will produce a maximally diffuse response, and means this can
+         * probably be considered a simple feed-back delay network (FDN).
+         *          N
+         *         ---
+         *         \
+         * v = 2/N /   d_i
+         *         ---
+         *         i=1
+         */
+        v = (d[0] + d[1] + d[2] + d[3]) * 0.5f;
+        // The junction is loaded with the input here.
+        v += DelayLineOut(&State->Delay, offset - State->DelayTap[0]);
+
+        // Calculate the feed values for the delay lines.
+        for(j = 0;j < 4;j++)
+            f[j] = v - d[j];
+
+        // Re-feed the delay lines.
+        for(j = 0;j < 4;j++)
+            DelayLineIn(&State->Early.Delay[j], offset, f[j]);
+
+        // Output the results of the junction for all four channels.
+        for(j = 0;j < 4;j++)
+            out[i][j] = gain * f[j];
+
+        // Step the coefficients toward any new targets.
+        for(j = 0;j < 4;j++)
+            coeff[j] += coeffStep[j];
+        gain += gainStep;
+    }
+
+    for(j = 0;j < 4;j++)
+        State->Coeffs.Early.Coeff[j] = coeff[j];
+    State->Coeffs.Early.Gain = gain;
 }
 
-// Given an input sample, this function mixes echo into the four-channel late
-// reverb.
-static __inline ALvoid EAXEcho(ALverbState *State, ALfloat in, ALfloat *late)
+// Produces a block of four-channel output for the late reverb, fed from the
+// decorrelated input.  As with the early reflections, the four lines are
+// handled as lanes.
+static ALvoid LateReverbBlock(ALverbState *State, ALuint todo, const ALfloat *RESTRICT in, ALfloat (*RESTRICT out)[4])
 {
-    ALfloat out, feed;
+    // This is where the feed-back cycles from line 0 to 1 to 3 to 2 and back
+    // to 0.  Each lane is fed by this cyclical line (and input channel).
+    static const ALuint Feed[4] = { 2, 0, 3, 1 };
+    // The coefficients step once per decimated sample, so they reach their
+    // targets over the same time as the full-rate ones.
+    const ALfloat stepScale = (ALfloat)State->Decimation;
+    ALfloat gain = State->Coeffs.Late.Gain;
+    ALfloat densityGain = State->Coeffs.Late.DensityGain;
+    ALfloat mixCoeff = State->Coeffs.Late.MixCoeff;
+    ALfloat apFeedCoeff = State->Coeffs.Late.ApFeedCoeff;
+    const ALfloat gainStep = State->Step.Late.Gain * stepScale;
+    const ALfloat densityGainStep = State->Step.Late.DensityGain * stepScale;
+    const ALfloat mixCoeffStep = State->Step.Late.MixCoeff * stepScale;
+    const ALfloat apFeedCoeffStep = State->Step.Late.ApFeedCoeff * stepScale;
+    ALfloat coeff[4], lpCoeff[4], lpSample[4], apCoeff[4];
+    ALfloat coeffStep[4], lpCoeffStep[4], apCoeffStep[4];
+    ALfloat taps[4], d[4], f[4], ap[4], feed[4];
+    ALuint offset, i, j;
+
+    for(j = 0;j < 4;j++)
+    {
+        coeff[j] = State->Coeffs.Late.Coeff[Feed[j]];
+        lpCoeff[j] = State->Coeffs.Late.LpCoeff[Feed[j]];
+        lpSample[j] = State->Late.LpSample[Feed[j]];
+        apCoeff[j] = State->Coeffs.Late.ApCoeff[j];
+
+        coeffStep[j] = State->Step.Late.Coeff[Feed[j]] * stepScale;
+        lpCoeffStep[j] = State->Step.Late.LpCoeff[Feed[j]] * stepScale;
+        apCoeffStep[j] = State->Step.Late.ApCoeff[j] * stepScale;
+    }
+
+    for(i = 0;i < todo;i++)
+    {
+        offset = State->LateOffset + i;
+
+        // Feed the decorrelator from the energy-attenuated input, and get the
+        // decorrelated input channels from its taps.
+        taps[0] = in[i] * densityGain;
+        DelayLineIn(&State->Decorrelator, offset, taps[0]);
+        taps[1] = DelayLineOut(&State->Decorrelator, offset - State->DecoTap[0]);
+        taps[2] = DelayLineOut(&State->Decorrelator, offset - State->DecoTap[1]);
+        taps[3] = DelayLineOut(&State->Decorrelator, offset - State->DecoTap[2]);
+
+        // Obtain the decayed results of the cyclical delay lines, and add
+        // the corresponding input channels.  Then pass the results through
+        // the low-pass filters.
+        for(j = 0;j < 4;j++)
+            d[j] = DelayLineOut(&State->Late.Delay[Feed[j]],
+                                offset - State->Late.Offset[Feed[j]]);
+        for(j = 0;j < 4;j++)
+            d[j] = taps[Feed[j]] + (coeff[j] * d[j]);
+        for(j = 0;j < 4;j++)
+        {
+            d[j] = lerp(d[j], lpSample[j], lpCoeff[j]);
+            lpSample[j] = d[j];
+        }
+
+        // To help increase diffusion, run each line through an all-pass
+        // filter.  When there is no diffusion, the shortest all-pass filter
+        // will feed the shortest delay line.  The time-based attenuation is
+        // only applied to the delay output to keep it from affecting the
+        // feed-back path.
+        for(j = 0;j < 4;j++)
+            ap[j] = DelayLineOut(&State->Late.ApDelay[j],
+                                 offset - State->Late.ApOffset[j]);
+        for(j = 0;j < 4;j++)
+        {
+            feed[j] = apFeedCoeff * d[j];
+            f[j] = (apFeedCoeff * (ap[j] - feed[j])) + d[j];
+            d[j] = (apCoeff[j] * ap[j]) - feed[j];
+        }
+        for(j = 0;j < 4;j++)
+            DelayLineIn(&State->Late.ApDelay[j], offset, f[j]);
+
+        /* Late reverb is done with a modified feed-back delay network (FDN)
+         * topology.  Four input lines are each fed through their own
+         * all-pass filter and then into the mixing matrix.  The four outputs
+         * of the mixing matrix are then cycled back to the inputs.  Each
+         * output feeds a different input to form a circlular feed cycle.
+         *
+         * The mixing matrix used is a 4D skew-symmetric rotation matrix
+         * derived using a single unitary rotational parameter:
+         *
+         *  [  d,  a,  b,  c ]          1 = a^2 + b^2 + c^2 + d^2
+         *  [ -a,  d,  c, -b ]
+         *  [ -b, -c,  d,  a ]
+         *  [ -c,  b, -a,  d ]
+         *
+         * The rotation is constructed from the effect's diffusion parameter,
+         * yielding:  1 = x^2 + 3 y^2; where a, b, and c are the coefficient
+         * y with differing signs, and d is the coefficient x.  The matrix is
+         * thus:
+         *
+         *  [  x,  y, -y,  y ]          n = sqrt(matrix_order - 1)
+         *  [ -y,  x,  y,  y ]          t = diffusion_parameter * atan(n)
+         *  [  y, -y,  x,  y ]          x = cos(t)
+         *  [ -y, -y, -y,  x ]          y = sin(t) / n
+         *
+         * To reduce the number of multiplies, the x coefficient is applied
+         * with the cyclical delay line coefficients.  Thus only the y
+         * coefficient is applied when mixing, and is modified to be:  y / x.
+         */
+        f[0] = d[0] + (mixCoeff * (         d[1] + -d[2] + d[3]));
+        f[1] = d[1] + (mixCoeff * (-d[0]         +  d[2] + d[3]));
+        f[2] = d[2] + (mixCoeff * ( d[0] + -d[1]         + d[3]));
+        f[3] = d[3] + (mixCoeff * (-d[0] + -d[1] + -d[2]       ));
+
+        // Output the results of the matrix for all four channels, attenuated
+        // by the late reverb gain (which is attenuated by the 'x' mix
+        // coefficient).
+        for(j = 0;j < 4;j++)
+            out[i][j] = gain * f[j];
+
+        // Re-feed the cyclical delay lines.
+        for(j = 0;j < 4;j++)
+            DelayLineIn(&State->Late.Delay[j], offset, f[j]);
+
+        // Step the coefficients toward any new targets.
+        for(j = 0;j < 4;j++)
+        {
+            coeff[j] += coeffStep[j];
+            lpCoeff[j] += lpCoeffStep[j];
+            apCoeff[j] += apCoeffStep[j];
+        }
+        gain += gainStep;
+        densityGain += densityGainStep;
+        mixCoeff += mixCoeffStep;
+        apFeedCoeff += apFeedCoeffStep;
+    }
 
-    // Get the latest attenuated echo sample for output.
-    feed = AttenuatedDelayLineOut(&State->Echo.Delay,
-                                  State->Offset - State->Echo.Offset,
-                                  State->Echo.Coeff);
-
-    // Mix the output into the late reverb channels.
-    out = State->Echo.MixCoeff[0] * feed;
-    late[0] = (State->Echo.MixCoeff[1] * late[0]) + out;
-    late[1] = (State->Echo.MixCoeff[1] * late[1]) + out;
-    late[2] = (State->Echo.MixCoeff[1] * late[2]) + out;
-    late[3] = (State->Echo.MixCoeff[1] * late[3]) + out;
-
-    // Mix the energy-attenuated input with the output and pass it through
-    // the echo low-pass filter.
-    feed += State->Echo.DensityGain * in;
-    feed = lerp(feed, State->Echo.LpSample, State->Echo.LpCoeff);
-    State->Echo.LpSample = feed;
-
-    // Then the echo all-pass filter.
-    feed = AllpassInOut(&State->Echo.ApDelay,
-                        State->Offset - State->Echo.ApOffset,
-                        State->Offset, feed, State->Echo.ApFeedCoeff,
-                        State->Echo.ApCoeff);
-
-    // Feed the delay with the mixed and filtered sample.
-    DelayLineIn(&State->Echo.Delay, State->Offset, feed);
+    for(j = 0;j < 4;j++)
+    {
+        State->Late.LpSample[Feed[j]] = lpSample[j];
+        State->Coeffs.Late.Coeff[Feed[j]] = coeff[j];
+        State->Coeffs.Late.LpCoeff[Feed[j]] = lpCoeff[j];
+        State->Coeffs.Late.ApCoeff[j] = apCoeff[j];
+    }
+    State->Coeffs.Late.Gain = gain;
+    State->Coeffs.Late.DensityGain = densityGain;
+    State->Coeffs.Late.MixCoeff = mixCoeff;
+    State->Coeffs.Late.ApFeedCoeff = apFeedCoeff;
 }
 
-// Perform the non-EAX reverb pass on a given input sample, resulting in
-// four-channel output.
-static __inline ALvoid VerbPass(ALverbState *State, ALfloat in, ALfloat *early, ALfloat *late)
+// Mixes a block of echo into the four-channel late reverb, fed from the same
+// input.
+static ALvoid EAXEchoBlock(ALverbState *State, ALuint todo, const ALfloat *RESTRICT in, ALfloat (*RESTRICT late)[4])
 {
-    ALfloat feed, taps[4];
-
-    // Low-pass filter the incoming sample.
-    in = lpFilter2P(&State->LpFilter, 0, in);
+    const ALfloat stepScale = (ALfloat)State->Decimation;
+    ALfloat coeff = State->Coeffs.Echo.Coeff;
+    ALfloat densityGain = State->Coeffs.Echo.DensityGain;
+    ALfloat lpCoeff = State->Coeffs.Echo.LpCoeff;
+    ALfloat apFeedCoeff = State->Coeffs.Echo.ApFeedCoeff;
+    ALfloat apCoeff = State->Coeffs.Echo.ApCoeff;
+    ALfloat mixCoeff[2] = { State->Coeffs.Echo.MixCoeff[0],
+                            State->Coeffs.Echo.MixCoeff[1] };
+    const ALfloat coeffStep = State->Step.Echo.Coeff * stepScale;
+    const ALfloat densityGainStep = State->Step.Echo.DensityGain * stepScale;
+    const ALfloat lpCoeffStep = State->Step.Echo.LpCoeff * stepScale;
+    const ALfloat apFeedCoeffStep = State->Step.Echo.ApFeedCoeff * stepScale;
+    const ALfloat apCoeffStep = State->Step.Echo.ApCoeff * stepScale;
+    const ALfloat mixCoeffStep[2] = { State->Step.Echo.MixCoeff[0] * stepScale,
+                                      State->Step.Echo.MixCoeff[1] * stepScale };
+    ALfloat out, feed;
+    ALuint offset, i, j;
 
-    // Feed the initial delay line.
-    DelayLineIn(&State->Delay, State->Offset, in);
+    for(i = 0;i < todo;i++)
+    {
+        offset = State->LateOffset + i;
+
+        // Get the latest attenuated echo sample for output.
+        feed = AttenuatedDelayLineOut(&State->Echo.Delay,
+                                      offset - State->Echo.Offset, coeff);
+
+        // Mix the output into the late reverb channels.
+        out = mixCoeff[0] * feed;
+        for(j = 0;j < 4;j++)
+            late[i][j] = (mixCoeff[1] * late[i][j]) + out;
+
+        // Mix the energy-attenuated input with the output and pass it
+        // through the echo low-pass filter.
+        feed += densityGain * in[i];
+        feed = lerp(feed, State->Echo.LpSample, lpCoeff);
+        State->Echo.LpSample = feed;
+
+        // Then the echo all-pass filter.
+        feed = AllpassInOut(&State->Echo.ApDelay,
+                            offset - State->Echo.ApOffset,
+                            offset, feed, apFeedCoeff, apCoeff);
+
+        // Feed the delay with the mixed and filtered sample.
+        DelayLineIn(&State->Echo.Delay, offset, feed);
+
+        // Step the coefficients toward any new targets.
+        coeff += coeffStep;
+        densityGain += densityGainStep;
+        lpCoeff += lpCoeffStep;
+        apFeedCoeff += apFeedCoeffStep;
+        apCoeff += apCoeffStep;
+        mixCoeff[0] += mixCoeffStep[0];
+        mixCoeff[1] += mixCoeffStep[1];
+    }
 
-    // Calculate the early reflection from the first delay tap.
-    in = DelayLineOut(&State->Delay, State->Offset - State->DelayTap[0]);
-    EarlyReflection(State, in, early);
+    State->Coeffs.Echo.Coeff = coeff;
+    State->Coeffs.Echo.DensityGain = densityGain;
+    State->Coeffs.Echo.LpCoeff = lpCoeff;
+    State->Coeffs.Echo.ApFeedCoeff = apFeedCoeff;
+    State->Coeffs.Echo.ApCoeff = apCoeff;
+    State->Coeffs.Echo.MixCoeff[0] = mixCoeff[0];
+    State->Coeffs.Echo.MixCoeff[1] = mixCoeff[1];
+}
 
-    // Feed the decorrelator from the energy-attenuated output of the second
-    // delay tap.
-    in = DelayLineOut(&State->Delay, State->Offset - State->DelayTap[1]);
-    feed = in * State->Late.DensityGain;
-    DelayLineIn(&State->Decorrelator, State->Offset, feed);
+// Averages each group of samples from the second initial delay tap into the
+// decimated late reverb input, returning how many groups were completed.
+static ALuint DecimateLateInput(ALverbState *State, ALuint todo, ALfloat *RESTRICT out)
+{
+    const ALuint decimation = State->Decimation;
+    const ALfloat scale = 1.0f / decimation;
+    ALfloat sum = State->Decim.Sum;
+    ALuint count = State->Decim.Count;
+    ALuint total = 0, i;
 
-    // Calculate the late reverb from the decorrelator taps.
-    taps[0] = feed;
-    taps[1] = DelayLineOut(&State->Decorrelator, State->Offset - State->DecoTap[0]);
-    taps[2] = DelayLineOut(&State->Decorrelator, State->Offset - State->DecoTap[1]);
-    taps[3] = DelayLineOut(&State->Decorrelator, State->Offset - State->DecoTap[2]);
-    LateReverb(State, taps, late);
+    for(i = 0;i < todo;i++)
+    {
+        sum += DelayLineOut(&State->Delay, State->Offset+i - State->DelayTap[1]);
+        if(++count == decimation)
+        {
+            out[total++] = sum * scale;
+            sum = 0.0f;
+            count = 0;
+        }
+    }
+    State->Decim.Sum = sum;
+    State->Decim.Count = count;
 
-    // Step all delays forward one sample.
-    State->Offset++;
+    return total;
 }
 
-// Perform the EAX reverb pass on a given input sample, resulting in four-
-// channel output.
-static __inline ALvoid EAXVerbPass(ALverbState *State, ALfloat in, ALfloat *early, ALfloat *late)
+// Linearly interpolates the decimated late reverb output back up to the
+// output rate, starting the given number of samples into a group.  Each
+// decimated sample is fully reached at the end of the group after the one it
+// was made from.
+static ALvoid InterpolateLateOutput(ALverbState *State, ALuint todo, ALuint count, ALfloat (*RESTRICT in)[4], ALfloat (*RESTRICT out)[4])
 {
-    ALfloat feed, taps[4];
+    const ALuint decimation = State->Decimation;
+    const ALfloat scale = 1.0f / decimation;
+    ALfloat frac;
+    ALuint i, j;
 
-    // Low-pass filter the incoming sample.
-    in = lpFilter2P(&State->LpFilter, 0, in);
-
-    // Perform any modulation on the input.
-    in = EAXModulation(State, in);
+    for(i = 0;i < todo;i++)
+    {
+        frac = (count+1) * scale;
+        for(j = 0;j < 4;j++)
+            out[i][j] = lerp(State->Decim.Last[j], State->Decim.Next[j], frac);
 
-    // Feed the initial delay line.
-    DelayLineIn(&State->Delay, State->Offset, in);
+        if(++count == decimation)
+        {
+            for(j = 0;j < 4;j++)
+            {
+                State->Decim.Last[j] = State->Decim.Next[j];
+                State->Decim.Next[j] = (*in)[j];
+            }
+            in++;
+            count = 0;
+        }
+    }
+}
 
-    // Calculate the early reflection from the first delay tap.
-    in = DelayLineOut(&State->Delay, State->Offset - State->DelayTap[0]);
-    EarlyReflection(State, in, early);
+// Produces a block of four-channel late reverb, with any echo mixed in.  When
+// decimating, the late lines run over fewer samples than the block holds.
+static ALvoid LateBlock(ALverbState *State, ALuint todo, ALboolean echo, ALfloat (*RESTRICT late)[4])
+{
+    ALfloat decimated[REVERB_BLOCK_SIZE][4];
+    ALfloat in[REVERB_BLOCK_SIZE];
+    ALuint count, total, i;
 
-    // Feed the decorrelator from the energy-attenuated output of the second
-    // delay tap.
-    in = DelayLineOut(&State->Delay, State->Offset - State->DelayTap[1]);
-    feed = in * State->Late.DensityGain;
-    DelayLineIn(&State->Decorrelator, State->Offset, feed);
+    if(State->Decimation == 1)
+    {
+        for(i = 0;i < todo;i++)
+            in[i] = DelayLineOut(&State->Delay,
+                                 State->Offset+i - State->DelayTap[1]);
+
+        LateReverbBlock(State, todo, in, late);
+        if(echo) EAXEchoBlock(State, todo, in, late);
+        State->LateOffset += todo;
+        return;
+    }
 
-    // Calculate the late reverb from the decorrelator taps.
-    taps[0] = feed;
-    taps[1] = DelayLineOut(&State->Decorrelator, State->Offset - State->DecoTap[0]);
-    taps[2] = DelayLineOut(&State->Decorrelator, State->Offset - State->DecoTap[1]);
-    taps[3] = DelayLineOut(&State->Decorrelator, State->Offset - State->DecoTap[2]);
-    LateReverb(State, taps, late);
+    count = State->Decim.Count;
+    total = DecimateLateInput(State, todo, in);
 
-    // Calculate and mix in any echo.
-    EAXEcho(State, in, late);
+    LateReverbBlock(State, total, in, decimated);
+    if(echo) EAXEchoBlock(State, total, in, decimated);
+    State->LateOffset += total;
 
-    // Step all delays forward one sample.
-    State->Offset++;
+    InterpolateLateOutput(State, todo, count, decimated, late);
 }
 
 // This processes the reverb state, given the input samples and an output
 // buffer.
-static ALvoid VerbProcess(ALeffectState *effect, ALuint SamplesToDo, const ALfloat *SamplesIn, ALfloat (*SamplesOut)[MAXCHANNELS])
+static ALvoid VerbProcess(ALeffectState *effect, const ALCdevice *Device, ALuint SamplesToDo, const ALfloat *SamplesIn, ALfloat (*SamplesOut)[BUFFERSIZE])
 {
     ALverbState *State = (ALverbState*)effect;
-    ALuint index, c;
-    ALfloat early[4], late[4], out[4];
-    const ALfloat *panGain = State->Gain;
+    const ALuint NumChannels = ChannelsFromDevFmt(Device->FmtChans);
+    ALfloat early[REVERB_BLOCK_SIZE][4], late[REVERB_BLOCK_SIZE][4];
+    ALfloat panGain[MAXCHANNELS], panStep[MAXCHANNELS];
+    ALuint line[MAXCHANNELS];
+    ALuint base, todo, index, c;
 
-    for(index = 0;index < SamplesToDo;index++)
+    if(State->Fading)
+        StartCoeffFade(State, SamplesToDo);
+
+    // Map the output planes to their gains and reverb lines.
+    for(c = 0;c < NumChannels;c++)
     {
-        // Process reverb for this sample.
-        VerbPass(State, SamplesIn[index], early, late);
-
-        // Mix early reflections and late reverb.
-        out[0] = (early[0] + late[0]);
-        out[1] = (early[1] + late[1]);
-        out[2] = (early[2] + late[2]);
-        out[3] = (early[3] + late[3]);
-
-        // Output the results.
-        for(c = 0;c < MAXCHANNELS;c++)
-            SamplesOut[index][c] += panGain[c] * out[c&3];
+        panGain[c] = State->Coeffs.Late.PanGain[Device->DevChannels[c]];
+        panStep[c] = State->Step.Late.PanGain[Device->DevChannels[c]];
+        line[c] = Device->DevChannels[c]&3;
     }
+
+    for(base = 0;base < SamplesToDo;base += todo)
+    {
+        todo = minu(SamplesToDo-base, REVERB_BLOCK_SIZE);
+
+        // Process reverb for this block.
+        FeedInitialDelay(State, &SamplesIn[base], todo, AL_FALSE);
+        EarlyReflectionBlock(State, todo, early);
+        LateBlock(State, todo, AL_FALSE, late);
+
+        // Step all delays forward.
+        State->Offset += todo;
+
+        // Mix early reflections and late reverb, and output the results.
+        for(c = 0;c < NumChannels;c++)
+        {
+            ALfloat *RESTRICT out = &SamplesOut[c][base];
+            const ALfloat step = panStep[c];
+            const ALuint l = line[c];
+            ALfloat gain = panGain[c];
+
+            for(index = 0;index < todo;index++)
+            {
+                out[index] += gain * (early[index][l] + late[index][l]);
+                gain += step;
+            }
+            panGain[c] = gain;
+        }
+    }
+
+    if(State->Fading)
+        EndCoeffFade(State);
 }
 
 // This processes the EAX reverb state, given the input samples and an output
 // buffer.
-static ALvoid EAXVerbProcess(ALeffectState *effect, ALuint SamplesToDo, const ALfloat *SamplesIn, ALfloat (*SamplesOut)[MAXCHANNELS])
+static ALvoid EAXVerbProcess(ALeffectState *effect, const ALCdevice *Device, ALuint SamplesToDo, const ALfloat *SamplesIn, ALfloat (*SamplesOut)[BUFFERSIZE])
 {
     ALverbState *State = (ALverbState*)effect;
-    ALuint index, c;
-    ALfloat early[4], late[4];
+    const ALuint NumChannels = ChannelsFromDevFmt(Device->FmtChans);
+    ALfloat early[REVERB_BLOCK_SIZE][4], late[REVERB_BLOCK_SIZE][4];
+    ALfloat earlyGain[MAXCHANNELS], lateGain[MAXCHANNELS];
+    ALfloat earlyStep[MAXCHANNELS], lateStep[MAXCHANNELS];
+    ALuint line[MAXCHANNELS];
+    ALuint base, todo, index, c;
+
+    if(State->Fading)
+        StartCoeffFade(State, SamplesToDo);
+
+    // Map the output planes to their gains and reverb lines.
+    for(c = 0;c < NumChannels;c++)
+    {
+        earlyGain[c] = State->Coeffs.Early.PanGain[Device->DevChannels[c]];
+        lateGain[c] = State->Coeffs.Late.PanGain[Device->DevChannels[c]];
+        earlyStep[c] = State->Step.Early.PanGain[Device->DevChannels[c]];
+        lateStep[c] = State->Step.Late.PanGain[Device->DevChannels[c]];
+        line[c] = Device->DevChannels[c]&3;
+    }
 
-    for(index = 0;index < SamplesToDo;index++)
+    for(base = 0;base < SamplesToDo;base += todo)
     {
-        // Process reverb for this sample.
-        EAXVerbPass(State, SamplesIn[index], early, late);
+        todo = minu(SamplesToDo-base, REVERB_BLOCK_SIZE);
+
+        // Process reverb for this block, and mix in any echo.
+        FeedInitialDelay(State, &SamplesIn[base], todo, AL_TRUE);
+        EarlyReflectionBlock(State, todo, early);
+        LateBlock(State, todo, AL_TRUE, late);
 
-        for(c = 0;c < MAXCHANNELS;c++)
-            SamplesOut[index][c] += State->Early.PanGain[c]*early[c&3] +
-                                    State->Late.PanGain[c]*late[c&3];
+        // Step all delays forward.
+        State->Offset += todo;
+
+        // Pan the early reflections and late reverb to the output.
+        for(c = 0;c < NumChannels;c++)
+        {
+            ALfloat *RESTRICT out = &SamplesOut[c][base];
+            const ALfloat es = earlyStep[c];
+            const ALfloat ls = lateStep[c];
+            const ALuint l = line[c];
+            ALfloat eg = earlyGain[c];
+            ALfloat lg = lateGain[c];
+
+            for(index = 0;index < todo;index++)
+            {
+                out[index] += eg*early[index][l] + lg*late[index][l];
+                eg += es;
+                lg += ls;
+            }
+            earlyGain[c] = eg;
+            lateGain[c] = lg;
+        }
     }
+
+    if(State->Fading)
+        EndCoeffFade(State);
 }
 
 
@@ -613,11 +910,13 @@ static ALuint CalcLineLength(ALfloat length, ALintptrEXT offset, ALuint frequenc
 }
 
 /* Calculates the delay line metrics and allocates the shared sample buffer
- * for all lines given the sample rate (frequency).  If an allocation failure
- * occurs, it returns AL_FALSE.
+ * for all lines given the sample rate (frequency).  The late reverb and echo
+ * lines are sized for the decimated rate.  If an allocation failure occurs,
+ * it returns AL_FALSE.
  */
 static ALboolean AllocLines(ALuint frequency, ALverbState *State)
 {
+    const ALuint lateFrequency = frequency / State->Decimation;
     ALuint totalSamples, index;
     ALfloat length;
     ALfloat *newBuffer = NULL;
@@ -637,9 +936,10 @@ static ALboolean AllocLines(ALuint frequency, ALverbState *State)
                                    &State->Mod.Delay);
 
     // The initial delay is the sum of the reflections and late reverb
-    // delays.
+    // delays, plus room for a block to be written ahead of the taps.
     length = AL_EAXREVERB_MAX_REFLECTIONS_DELAY +
-             AL_EAXREVERB_MAX_LATE_REVERB_DELAY;
+             AL_EAXREVERB_MAX_LATE_REVERB_DELAY +
+             ((ALfloat)REVERB_BLOCK_SIZE / frequency);
     totalSamples += CalcLineLength(length, totalSamples, frequency,
                                    &State->Delay);
 
@@ -652,27 +952,27 @@ static ALboolean AllocLines(ALuint frequency, ALverbState *State)
     // parameter value of 1).
     length = (DECO_FRACTION * DECO_MULTIPLIER * DECO_MULTIPLIER) *
              LATE_LINE_LENGTH[0] * (1.0f + LATE_LINE_MULTIPLIER);
-    totalSamples += CalcLineLength(length, totalSamples, frequency,
+    totalSamples += CalcLineLength(length, totalSamples, lateFrequency,
                                    &State->Decorrelator);
 
     // The late all-pass lines.
     for(index = 0;index < 4;index++)
         totalSamples += CalcLineLength(ALLPASS_LINE_LENGTH[index], totalSamples,
-                                       frequency, &State->Late.ApDelay[index]);
+                                       lateFrequency, &State->Late.ApDelay[index]);
 
     // The late delay lines are calculated from the lowest reverb density.
     for(index = 0;index < 4;index++)
     {
         length = LATE_LINE_LENGTH[index] * (1.0f + LATE_LINE_MULTIPLIER);
-        totalSamples += CalcLineLength(length, totalSamples, frequency,
+        totalSamples += CalcLineLength(length, totalSamples, lateFrequency,
                                        &State->Late.Delay[index]);
     }
 
     // The echo all-pass and delay lines.
     totalSamples += CalcLineLength(ECHO_ALLPASS_LENGTH, totalSamples,
-                                   frequency, &State->Echo.ApDelay);
+                                   lateFrequency, &State->Echo.ApDelay);
     totalSamples += CalcLineLength(AL_EAXREVERB_MAX_ECHO_TIME, totalSamples,
-                                   frequency, &State->Echo.Delay);
+                                   lateFrequency, &State->Echo.Delay);
 
     if(totalSamples != State->TotalSamples)
     {
@@ -710,11 +1010,25 @@ static ALboolean AllocLines(ALuint frequency, ALverbState *State)
 static ALboolean ReverbDeviceUpdate(ALeffectState *effect, ALCdevice *Device)
 {
     ALverbState *State = (ALverbState*)effect;
-    ALuint frequency = Device->Frequency, index;
+    ALuint frequency = Device->Frequency, lateFrequency, index;
 
     // Allocate the delay lines.
+    State->Decimation = ReverbDecimation;
     if(!AllocLines(frequency, State))
         return AL_FALSE;
+    lateFrequency = frequency / State->Decimation;
+
+    // The cleared lines need all coefficients recalculated, with no fading.
+    State->FullUpdate = AL_TRUE;
+
+    // The cleared lines start the decimator over.
+    State->Decim.Sum = 0.0f;
+    State->Decim.Count = 0;
+    for(index = 0;index < 4;index++)
+    {
+        State->Decim.Last[index] = 0.0f;
+        State->Decim.Next[index] = 0.0f;
+    }
 
     // Calculate the modulation filter coefficient.  Notice that the exponent
     // is calculated given the current sample rate.  This ensures that the
@@ -730,12 +1044,12 @@ static ALboolean ReverbDeviceUpdate(ALeffectState *effect, ALCdevice *Device)
         State->Early.Offset[index] = fastf2u(EARLY_LINE_LENGTH[index] *
                                              frequency);
         State->Late.ApOffset[index] = fastf2u(ALLPASS_LINE_LENGTH[index] *
-                                              frequency);
+                                              lateFrequency);
     }
 
     // The echo all-pass filter line length is static, so its offset only
     // needs to be calculated once.
-    State->Echo.ApOffset = fastf2u(ECHO_ALLPASS_LENGTH * frequency);
+    State->Echo.ApOffset = fastf2u(ECHO_ALLPASS_LENGTH * lateFrequency);
 
     return AL_TRUE;
 }
@@ -879,6 +1193,11 @@ static ALvoid UpdateDelayLine(ALfloat earlyDelay, ALfloat lateDelay, ALuint freq
     // Calculate the initial delay taps.
     State->DelayTap[0] = fastf2u(earlyDelay * frequency);
     State->DelayTap[1] = fastf2u((earlyDelay + lateDelay) * frequency);
+
+    // Interpolating the decimated late reverb delays it by one group of
+    // samples, so tap it that much earlier.
+    if(State->Decimation > 1)
+        State->DelayTap[1] -= minu(State->DelayTap[1], State->Decimation);
 }
 
 // Update the early reflections gain and line coefficients.
@@ -888,14 +1207,14 @@ static ALvoid UpdateEarlyLines(ALfloat reverbGain, ALfloat earlyGain, ALfloat la
 
     // Calculate the early reflections gain (from the master effect gain, and
     // reflections gain parameters) with a constant attenuation of 0.5.
-    State->Early.Gain = 0.5f * reverbGain * earlyGain;
+    State->Target.Early.Gain = 0.5f * reverbGain * earlyGain;
 
     // Calculate the gain (coefficient) for each early delay line using the
     // late delay time.  This expands the early reflections to the start of
     // the late reverb.
     for(index = 0;index < 4;index++)
-        State->Early.Coeff[index] = CalcDecayCoeff(EARLY_LINE_LENGTH[index],
-                                                   lateDelay);
+        State->Target.Early.Coeff[index] = CalcDecayCoeff(EARLY_LINE_LENGTH[index],
+                                                          lateDelay);
 }
 
 // Update the offsets for the decorrelator line.
@@ -919,18 +1238,22 @@ static ALvoid UpdateDecorrelator(ALfloat density, ALuint frequency, ALverbState
     }
 }
 
-// Update the late reverb gains, line lengths, and line coefficients.
-static ALvoid UpdateLateLines(ALfloat reverbGain, ALfloat lateGain, ALfloat xMix, ALfloat density, ALfloat decayTime, ALfloat diffusion, ALfloat hfRatio, ALfloat cw, ALuint frequency, ALverbState *State)
+// Update the late reverb gain.
+static ALvoid UpdateLateGain(ALfloat reverbGain, ALfloat lateGain, ALfloat xMix, ALverbState *State)
 {
-    ALfloat length;
-    ALuint index;
-
     /* Calculate the late reverb gain (from the master effect gain, and late
      * reverb gain parameters).  Since the output is tapped prior to the
      * application of the next delay line coefficients, this gain needs to be
      * attenuated by the 'x' mixing matrix coefficient as well.
      */
-    State->Late.Gain = reverbGain * lateGain * xMix;
+    State->Target.Late.Gain = reverbGain * lateGain * xMix;
+}
+
+// Update the late reverb line lengths and line coefficients.
+static ALvoid UpdateLateLines(ALfloat xMix, ALfloat density, ALfloat decayTime, ALfloat diffusion, ALfloat hfRatio, ALfloat cw, ALuint frequency, ALverbState *State)
+{
+    ALfloat length;
+    ALuint index;
 
     /* To compensate for changes in modal density and decay time of the late
      * reverb signal, the input is attenuated based on the maximal energy of
@@ -943,17 +1266,17 @@ static ALvoid UpdateLateLines(ALfloat reverbGain, ALfloat lateGain, ALfloat xMix
     length = (LATE_LINE_LENGTH[0] + LATE_LINE_LENGTH[1] +
               LATE_LINE_LENGTH[2] + LATE_LINE_LENGTH[3]) / 4.0f;
     length *= 1.0f + (density * LATE_LINE_MULTIPLIER);
-    State->Late.DensityGain = CalcDensityGain(CalcDecayCoeff(length,
-                                                             decayTime));
+    State->Target.Late.DensityGain = CalcDensityGain(CalcDecayCoeff(length,
+                                                                    decayTime));
 
     // Calculate the all-pass feed-back and feed-forward coefficient.
-    State->Late.ApFeedCoeff = 0.5f * aluPow(diffusion, 2.0f);
+    State->Target.Late.ApFeedCoeff = 0.5f * aluPow(diffusion, 2.0f);
 
     for(index = 0;index < 4;index++)
     {
         // Calculate the gain (coefficient) for each all-pass line.
-        State->Late.ApCoeff[index] = CalcDecayCoeff(ALLPASS_LINE_LENGTH[index],
-                                                    decayTime);
+        State->Target.Late.ApCoeff[index] = CalcDecayCoeff(ALLPASS_LINE_LENGTH[index],
+                                                           decayTime);
 
         // Calculate the length (in seconds) of each cyclical delay line.
         length = LATE_LINE_LENGTH[index] * (1.0f + (density *
@@ -963,50 +1286,53 @@ static ALvoid UpdateLateLines(ALfloat reverbGain, ALfloat lateGain, ALfloat xMix
         State->Late.Offset[index] = fastf2u(length * frequency);
 
         // Calculate the gain (coefficient) for each cyclical line.
-        State->Late.Coeff[index] = CalcDecayCoeff(length, decayTime);
+        State->Target.Late.Coeff[index] = CalcDecayCoeff(length, decayTime);
 
         // Calculate the damping coefficient for each low-pass filter.
-        State->Late.LpCoeff[index] =
+        State->Target.Late.LpCoeff[index] =
             CalcDampingCoeff(hfRatio, length, decayTime,
-                             State->Late.Coeff[index], cw);
+                             State->Target.Late.Coeff[index], cw);
 
         // Attenuate the cyclical line coefficients by the mixing coefficient
         // (x).
-        State->Late.Coeff[index] *= xMix;
+        State->Target.Late.Coeff[index] *= xMix;
     }
 }
 
-// Update the echo gain, line offset, line coefficients, and mixing
-// coefficients.
-static ALvoid UpdateEchoLine(ALfloat reverbGain, ALfloat lateGain, ALfloat echoTime, ALfloat decayTime, ALfloat diffusion, ALfloat echoDepth, ALfloat hfRatio, ALfloat cw, ALuint frequency, ALverbState *State)
+// Update the echo line offset and line coefficients.
+static ALvoid UpdateEchoLine(ALfloat echoTime, ALfloat decayTime, ALfloat diffusion, ALfloat hfRatio, ALfloat cw, ALuint frequency, ALverbState *State)
 {
     // Update the offset and coefficient for the echo delay line.
     State->Echo.Offset = fastf2u(echoTime * frequency);
 
     // Calculate the decay coefficient for the echo line.
-    State->Echo.Coeff = CalcDecayCoeff(echoTime, decayTime);
+    State->Target.Echo.Coeff = CalcDecayCoeff(echoTime, decayTime);
 
     // Calculate the energy-based attenuation coefficient for the echo delay
     // line.
-    State->Echo.DensityGain = CalcDensityGain(State->Echo.Coeff);
+    State->Target.Echo.DensityGain = CalcDensityGain(State->Target.Echo.Coeff);
 
     // Calculate the echo all-pass feed coefficient.
-    State->Echo.ApFeedCoeff = 0.5f * aluPow(diffusion, 2.0f);
+    State->Target.Echo.ApFeedCoeff = 0.5f * aluPow(diffusion, 2.0f);
 
     // Calculate the echo all-pass attenuation coefficient.
-    State->Echo.ApCoeff = CalcDecayCoeff(ECHO_ALLPASS_LENGTH, decayTime);
+    State->Target.Echo.ApCoeff = CalcDecayCoeff(ECHO_ALLPASS_LENGTH, decayTime);
 
     // Calculate the damping coefficient for each low-pass filter.
-    State->Echo.LpCoeff = CalcDampingCoeff(hfRatio, echoTime, decayTime,
-                                           State->Echo.Coeff, cw);
+    State->Target.Echo.LpCoeff = CalcDampingCoeff(hfRatio, echoTime, decayTime,
+                                                  State->Target.Echo.Coeff, cw);
+}
 
+// Update the echo mixing coefficients.
+static ALvoid UpdateEchoGain(ALfloat reverbGain, ALfloat lateGain, ALfloat diffusion, ALfloat echoDepth, ALverbState *State)
+{
     /* Calculate the echo mixing coefficients.  The first is applied to the
      * echo itself.  The second is used to attenuate the late reverb when
      * echo depth is high and diffusion is low, so the echo is slightly
      * stronger than the decorrelated echos in the reverb tail.
      */
-    State->Echo.MixCoeff[0] = reverbGain * lateGain * echoDepth;
-    State->Echo.MixCoeff[1] = 1.0f - (echoDepth * 0.5f * (1.0f - diffusion));
+    State->Target.Echo.MixCoeff[0] = reverbGain * lateGain * echoDepth;
+    State->Target.Echo.MixCoeff[1] = 1.0f - (echoDepth * 0.5f * (1.0f - diffusion));
 }
 
 // Update the early and late 3D panning gains.
@@ -1058,11 +1384,11 @@ static ALvoid Update3DPanning(const ALCdevice *Device, const ALfloat *Reflection
     dirGain = aluSqrt((earlyPan[0] * earlyPan[0]) + (earlyPan[2] * earlyPan[2]));
 
     for(index = 0;index < MAXCHANNELS;index++)
-        State->Early.PanGain[index] = 0.0f;
+        State->Target.Early.PanGain[index] = 0.0f;
     for(index = 0;index < Device->NumChan;index++)
     {
         enum Channel chan = Device->Speaker2Chan[index];
-        State->Early.PanGain[chan] = lerp(ambientGain, ChannelGain[chan], dirGain) * Gain;
+        State->Target.Early.PanGain[chan] = lerp(ambientGain, ChannelGain[chan], dirGain) * Gain;
     }
 
 
@@ -1071,11 +1397,11 @@ static ALvoid Update3DPanning(const ALCdevice *Device, const ALfloat *Reflection
     dirGain = aluSqrt((latePan[0] * latePan[0]) + (latePan[2] * latePan[2]));
 
     for(index = 0;index < MAXCHANNELS;index++)
-         State->Late.PanGain[index] = 0.0f;
+         State->Target.Late.PanGain[index] = 0.0f;
     for(index = 0;index < Device->NumChan;index++)
     {
         enum Channel chan = Device->Speaker2Chan[index];
-        State->Late.PanGain[chan] = lerp(ambientGain, ChannelGain[chan], dirGain) * Gain;
+        State->Target.Late.PanGain[chan] = lerp(ambientGain, ChannelGain[chan], dirGain) * Gain;
     }
 }
 
@@ -1084,9 +1410,13 @@ static ALvoid Update3DPanning(const ALCdevice *Device, const ALfloat *Reflection
 static ALvoid ReverbUpdate(ALeffectState *effect, ALCdevice *Device, const ALeffectslot *Slot)
 {
     ALverbState *State = (ALverbState*)effect;
+    const struct ALreverbProps *props = &Slot->effect.Reverb;
+    const struct ALreverbProps *last = &State->Props;
     ALuint frequency = Device->Frequency;
+    ALuint lateFrequency = frequency / State->Decimation;
     ALboolean isEAX = AL_FALSE;
-    ALfloat cw, x, y, hfRatio;
+    ALboolean full, hfChanged, lateChanged, echoChanged;
+    ALfloat cw, lateCw, hfRef, x, y, hfRatio, length;
 
     if(Slot->effect.type == AL_EFFECT_EAXREVERB && !EmulateEAXReverb)
     {
@@ -1099,65 +1429,114 @@ static ALvoid ReverbUpdate(ALeffectState *effect, ALCdevice *Device, const ALeff
         isEAX = AL_FALSE;
     }
 
+    /* Only the stages with changed properties are recalculated, unless the
+     * device changed or the reverb type switched.
+     */
+    full = State->FullUpdate || isEAX != State->IsEAX;
+#define CHANGED(x) (full || props->x != last->x)
+
+    if(isEAX) hfRef = props->HFReference;
+    else hfRef = LOWPASSFREQREF;
+    cw = CalcI3DL2HFreq(hfRef, frequency);
+
     // Calculate the master low-pass filter (from the master effect HF gain).
-    if(isEAX) cw = CalcI3DL2HFreq(Slot->effect.Reverb.HFReference, frequency);
-    else cw = CalcI3DL2HFreq(LOWPASSFREQREF, frequency);
-    // This is done with 2 chained 1-pole filters, so no need to square g.
-    State->LpFilter.coeff = lpCoeffCalc(Slot->effect.Reverb.GainHF, cw);
+    if(CHANGED(GainHF) || CHANGED(HFReference))
+    {
+        // This is done with 2 chained 1-pole filters, so no need to square g.
+        State->Target.LpCoeff = lpCoeffCalc(props->GainHF, cw);
+    }
 
-    if(isEAX)
+    if(isEAX && (CHANGED(ModulationTime) || CHANGED(ModulationDepth)))
     {
         // Update the modulator line.
-        UpdateModulator(Slot->effect.Reverb.ModulationTime,
-                        Slot->effect.Reverb.ModulationDepth,
+        UpdateModulator(props->ModulationTime, props->ModulationDepth,
                         frequency, State);
     }
 
     // Update the initial effect delay.
-    UpdateDelayLine(Slot->effect.Reverb.ReflectionsDelay,
-                    Slot->effect.Reverb.LateReverbDelay,
-                    frequency, State);
+    if(CHANGED(ReflectionsDelay) || CHANGED(LateReverbDelay))
+        UpdateDelayLine(props->ReflectionsDelay, props->LateReverbDelay,
+                        frequency, State);
 
     // Update the early lines.
-    UpdateEarlyLines(Slot->effect.Reverb.Gain,
-                     Slot->effect.Reverb.ReflectionsGain,
-                     Slot->effect.Reverb.LateReverbDelay, State);
+    if(CHANGED(Gain) || CHANGED(ReflectionsGain) || CHANGED(LateReverbDelay))
+        UpdateEarlyLines(props->Gain, props->ReflectionsGain,
+                         props->LateReverbDelay, State);
+
+    // The tail lasts through the initial delay and echo, until the reverb
+    // decays by 120dB (twice the decay time).
+    length = props->ReflectionsDelay + props->LateReverbDelay +
+             props->DecayTime*2.0f;
+    if(isEAX)
+        length += props->EchoTime;
+    State->state.TailLength = fastf2u(length * frequency);
 
     // Update the decorrelator.
-    UpdateDecorrelator(Slot->effect.Reverb.Density, frequency, State);
-
-    // Get the mixing matrix coefficients (x and y).
-    CalcMatrixCoeffs(Slot->effect.Reverb.Diffusion, &x, &y);
-    // Then divide x into y to simplify the matrix calculation.
-    State->Late.MixCoeff = y / x;
-
-    // If the HF limit parameter is flagged, calculate an appropriate limit
-    // based on the air absorption parameter.
-    hfRatio = Slot->effect.Reverb.DecayHFRatio;
-    if(Slot->effect.Reverb.DecayHFLimit &&
-       Slot->effect.Reverb.AirAbsorptionGainHF < 1.0f)
-        hfRatio = CalcLimitedHfRatio(hfRatio,
-                                     Slot->effect.Reverb.AirAbsorptionGainHF,
-                                     Slot->effect.Reverb.DecayTime);
-
-    // Update the late lines.
-    UpdateLateLines(Slot->effect.Reverb.Gain, Slot->effect.Reverb.LateReverbGain,
-                    x, Slot->effect.Reverb.Density, Slot->effect.Reverb.DecayTime,
-                    Slot->effect.Reverb.Diffusion, hfRatio, cw, frequency, State);
+    if(CHANGED(Density))
+        UpdateDecorrelator(props->Density, lateFrequency, State);
+
+    // The late lines and echo depend on these for their damping, along with
+    // their own properties.
+    hfChanged = CHANGED(DecayTime) || CHANGED(DecayHFRatio) ||
+                CHANGED(DecayHFLimit) || CHANGED(AirAbsorptionGainHF) ||
+                CHANGED(HFReference);
+    lateChanged = hfChanged || CHANGED(Density) || CHANGED(Diffusion);
+    echoChanged = isEAX && (hfChanged || CHANGED(EchoTime) ||
+                            CHANGED(Diffusion));
+
+    hfRatio = props->DecayHFRatio;
+    lateCw = cw;
+    if(lateChanged || echoChanged)
+    {
+        // If the HF limit parameter is flagged, calculate an appropriate
+        // limit based on the air absorption parameter.
+        if(props->DecayHFLimit && props->AirAbsorptionGainHF < 1.0f)
+            hfRatio = CalcLimitedHfRatio(hfRatio, props->AirAbsorptionGainHF,
+                                         props->DecayTime);
+
+        // The late reverb and echo damping filters run at the decimated
+        // rate, which may not reach the HF reference.
+        if(State->Decimation > 1)
+            lateCw = CalcI3DL2HFreq(minf(hfRef, lateFrequency*0.5f),
+                                    lateFrequency);
+    }
+
+    if(lateChanged || CHANGED(Gain) || CHANGED(LateReverbGain))
+    {
+        // Get the mixing matrix coefficients (x and y).
+        CalcMatrixCoeffs(props->Diffusion, &x, &y);
+        // Then divide x into y to simplify the matrix calculation.
+        State->Target.Late.MixCoeff = y / x;
+
+        // Update the late gain and lines.
+        UpdateLateGain(props->Gain, props->LateReverbGain, x, State);
+        if(lateChanged)
+            UpdateLateLines(x, props->Density, props->DecayTime,
+                            props->Diffusion, hfRatio, lateCw, lateFrequency,
+                            State);
+    }
 
     if(isEAX)
     {
-        // Update the echo line.
-        UpdateEchoLine(Slot->effect.Reverb.Gain, Slot->effect.Reverb.LateReverbGain,
-                       Slot->effect.Reverb.EchoTime, Slot->effect.Reverb.DecayTime,
-                       Slot->effect.Reverb.Diffusion, Slot->effect.Reverb.EchoDepth,
-                       hfRatio, cw, frequency, State);
+        // Update the echo line and its mixing.
+        if(echoChanged)
+            UpdateEchoLine(props->EchoTime, props->DecayTime,
+                           props->Diffusion, hfRatio, lateCw, lateFrequency,
+                           State);
+        if(CHANGED(Gain) || CHANGED(LateReverbGain) || CHANGED(Diffusion) ||
+           CHANGED(EchoDepth))
+            UpdateEchoGain(props->Gain, props->LateReverbGain,
+                           props->Diffusion, props->EchoDepth, State);
 
         // Update early and late 3D panning.
-        Update3DPanning(Device, Slot->effect.Reverb.ReflectionsPan,
-                        Slot->effect.Reverb.LateReverbPan, Slot->Gain, State);
+        if(full || Slot->Gain != State->SlotGain ||
+           CHANGED(ReflectionsPan[0]) || CHANGED(ReflectionsPan[1]) ||
+           CHANGED(ReflectionsPan[2]) || CHANGED(LateReverbPan[0]) ||
+           CHANGED(LateReverbPan[1]) || CHANGED(LateReverbPan[2]))
+            Update3DPanning(Device, props->ReflectionsPan,
+                            props->LateReverbPan, Slot->Gain, State);
     }
-    else
+    else if(full || Slot->Gain != State->SlotGain)
     {
         ALfloat gain = Slot->Gain;
         ALuint index;
@@ -1165,13 +1544,32 @@ static ALvoid ReverbUpdate(ALeffectState *effect, ALCdevice *Device, const ALeff
         /* Update channel gains */
         gain *= aluSqrt(2.0f/Device->NumChan) * ReverbBoost;
         for(index = 0;index < MAXCHANNELS;index++)
-             State->Gain[index] = 0.0f;
+             State->Target.Late.PanGain[index] = 0.0f;
         for(index = 0;index < Device->NumChan;index++)
         {
             enum Channel chan = Device->Speaker2Chan[index];
-            State->Gain[chan] = gain;
+            State->Target.Late.PanGain[chan] = gain;
         }
     }
+#undef CHANGED
+
+    State->Props = *props;
+    State->SlotGain = Slot->Gain;
+    State->IsEAX = isEAX;
+
+    /* Freshly cleared lines take the new coefficients right away.  Otherwise
+     * the next mix fades to them.
+     */
+    if(State->FullUpdate)
+    {
+        State->Coeffs = State->Target;
+        memset(&State->Step, 0, sizeof(State->Step));
+        State->Fading = AL_FALSE;
+        State->FullUpdate = AL_FALSE;
+    }
+    else
+        State->Fading = (memcmp(&State->Coeffs, &State->Target,
+                                sizeof(State->Target)) != 0);
 }
 
 // This destroys the reverb state.  It should be called only when the effect
@@ -1202,6 +1600,7 @@ ALeffectState *ReverbCreate(void)
     State->state.DeviceUpdate = ReverbDeviceUpdate;
     State->state.Update = ReverbUpdate;
     State->state.Process = VerbProcess;
+    State->state.TailLength = 0;
 
     State->TotalSamples = 0;
     State->SampleBuffer = NULL;
@@ -1223,10 +1622,8 @@ ALeffectState *ReverbCreate(void)
     State->DelayTap[0] = 0;
     State->DelayTap[1] = 0;
 
-    State->Early.Gain = 0.0f;
     for(index = 0;index < 4;index++)
     {
-        State->Early.Coeff[index] = 0.0f;
         State->Early.Delay[index].Mask = 0;
         State->Early.Delay[index].Line = NULL;
         State->Early.Offset[index] = 0;
@@ -1238,50 +1635,48 @@ ALeffectState *ReverbCreate(void)
     State->DecoTap[1] = 0;
     State->DecoTap[2] = 0;
 
-    State->Late.Gain = 0.0f;
-    State->Late.DensityGain = 0.0f;
-    State->Late.ApFeedCoeff = 0.0f;
-    State->Late.MixCoeff = 0.0f;
     for(index = 0;index < 4;index++)
     {
-        State->Late.ApCoeff[index] = 0.0f;
         State->Late.ApDelay[index].Mask = 0;
         State->Late.ApDelay[index].Line = NULL;
         State->Late.ApOffset[index] = 0;
 
-        State->Late.Coeff[index] = 0.0f;
         State->Late.Delay[index].Mask = 0;
         State->Late.Delay[index].Line = NULL;
         State->Late.Offset[index] = 0;
 
-        State->Late.LpCoeff[index] = 0.0f;
         State->Late.LpSample[index] = 0.0f;
     }
 
-    for(index = 0;index < MAXCHANNELS;index++)
-    {
-        State->Early.PanGain[index] = 0.0f;
-        State->Late.PanGain[index] = 0.0f;
-    }
-
-    State->Echo.DensityGain = 0.0f;
     State->Echo.Delay.Mask = 0;
     State->Echo.Delay.Line = NULL;
     State->Echo.ApDelay.Mask = 0;
     State->Echo.ApDelay.Line = NULL;
-    State->Echo.Coeff = 0.0f;
-    State->Echo.ApFeedCoeff = 0.0f;
-    State->Echo.ApCoeff = 0.0f;
     State->Echo.Offset = 0;
     State->Echo.ApOffset = 0;
-    State->Echo.LpCoeff = 0.0f;
     State->Echo.LpSample = 0.0f;
-    State->Echo.MixCoeff[0] = 0.0f;
-    State->Echo.MixCoeff[1] = 0.0f;
 
-    State->Offset = 0;
+    memset(&State->Coeffs, 0, sizeof(State->Coeffs));
+    memset(&State->Target, 0, sizeof(State->Target));
+    memset(&State->Step, 0, sizeof(State->Step));
+    State->Fading = AL_FALSE;
 
-    State->Gain = State->Late.PanGain;
+    memset(&State->Props, 0, sizeof(State->Props));
+    State->SlotGain = 0.0f;
+    State->IsEAX = AL_FALSE;
+    State->FullUpdate = AL_TRUE;
+
+    State->Decimation = 1;
+    State->Decim.Sum = 0.0f;
+    State->Decim.Count = 0;
+    for(index = 0;index < 4;index++)
+    {
+        State->Decim.Last[index] = 0.0f;
+        State->Decim.Next[index] = 0.0f;
+    }
+
+    State->Offset = 0;
+    State->LateOffset = 0;
 
     return &State->state;
 }
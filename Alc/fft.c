@@ -0,0 +1,155 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 1999-2007 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ *  Boston, MA  02111-1307, USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include <math.h>
+
+#include "alMain.h"
+#include "alu.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+
+/* Twiddle factors for each pass, forward and inverse. The pass combining
+ * pairs of half-length transforms keeps its half twiddles contiguous at
+ * [half, 2*half). */
+static ALcomplex FFTTwiddles[2][MAX_FFT_SIZE];
+/* Bit-reversed indices for the largest size. Smaller sizes shift them down. */
+static ALushort FFTReversed[MAX_FFT_SIZE];
+
+
+ALvoid aluInitFFT(void)
+{
+    ALuint half, i, j, bit;
+
+    for(half = 1;half < MAX_FFT_SIZE;half <<= 1)
+    {
+        for(i = 0;i < half;i++)
+        {
+            FFTTwiddles[0][half+i].Real = (ALfloat)cos(M_PI * i / half);
+            FFTTwiddles[0][half+i].Imag = (ALfloat)-sin(M_PI * i / half);
+            FFTTwiddles[1][half+i].Real = FFTTwiddles[0][half+i].Real;
+            FFTTwiddles[1][half+i].Imag = -FFTTwiddles[0][half+i].Imag;
+        }
+    }
+    for(i = 0;i < MAX_FFT_SIZE;i++)
+    {
+        j = 0;
+        for(bit = 1;bit < MAX_FFT_SIZE;bit <<= 1)
+            j = (j<<1) | ((i/bit)&1);
+        FFTReversed[i] = (ALushort)j;
+    }
+}
+
+#if defined(__SSE__) && defined(HAVE_XMMINTRIN_H)
+#include <xmmintrin.h>
+
+/* Combines two half-length transforms, two butterflies at a time. */
+static __inline void FFTPass(ALcomplex *RESTRICT a, ALcomplex *RESTRICT b,
+                             const ALcomplex *RESTRICT w, ALuint half)
+{
+    const __m128 negreal = _mm_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f);
+    ALuint k;
+
+    for(k = 0;k < half;k += 2)
+    {
+        __m128 va = _mm_loadu_ps(&a[k].Real);
+        __m128 vb = _mm_loadu_ps(&b[k].Real);
+        __m128 vw = _mm_loadu_ps(&w[k].Real);
+        __m128 br = _mm_shuffle_ps(vb, vb, _MM_SHUFFLE(2,2,0,0));
+        __m128 bi = _mm_shuffle_ps(vb, vb, _MM_SHUFFLE(3,3,1,1));
+        __m128 ws = _mm_shuffle_ps(vw, vw, _MM_SHUFFLE(2,3,0,1));
+        __m128 t = _mm_add_ps(_mm_mul_ps(br, vw),
+                              _mm_mul_ps(_mm_mul_ps(bi, ws), negreal));
+
+        _mm_storeu_ps(&b[k].Real, _mm_sub_ps(va, t));
+        _mm_storeu_ps(&a[k].Real, _mm_add_ps(va, t));
+    }
+}
+
+#else
+
+static __inline void FFTPass(ALcomplex *RESTRICT a, ALcomplex *RESTRICT b,
+                             const ALcomplex *RESTRICT w, ALuint half)
+{
+    ALuint k;
+
+    for(k = 0;k < half;k++)
+    {
+        ALfloat tr = b[k].Real*w[k].Real - b[k].Imag*w[k].Imag;
+        ALfloat ti = b[k].Real*w[k].Imag + b[k].Imag*w[k].Real;
+
+        b[k].Real = a[k].Real - tr;
+        b[k].Imag = a[k].Imag - ti;
+        a[k].Real += tr;
+        a[k].Imag += ti;
+    }
+}
+
+#endif
+
+/* In-place radix-2 FFT of size samples, which must be a power of 2 from 4 to
+ * MAX_FFT_SIZE. The inverse transform is not scaled. The first two passes
+ * only need additions, so they're done together as one radix-4 pass. */
+ALvoid aluFFT(ALcomplex *buffer, ALuint size, ALboolean inverse)
+{
+    const ALcomplex *twiddles = FFTTwiddles[inverse ? 1 : 0];
+    ALuint shift = 0;
+    ALuint i, j, half;
+
+    while((ALuint)(MAX_FFT_SIZE>>shift) > size)
+        shift++;
+    for(i = 1;i < size;i++)
+    {
+        j = FFTReversed[i] >> shift;
+        if(i < j)
+        {
+            ALcomplex temp = buffer[i];
+            buffer[i] = buffer[j];
+            buffer[j] = temp;
+        }
+    }
+
+    for(i = 0;i < size;i += 4)
+    {
+        ALcomplex *RESTRICT x = &buffer[i];
+        ALfloat s0r = x[0].Real + x[1].Real, s0i = x[0].Imag + x[1].Imag;
+        ALfloat d0r = x[0].Real - x[1].Real, d0i = x[0].Imag - x[1].Imag;
+        ALfloat s1r = x[2].Real + x[3].Real, s1i = x[2].Imag + x[3].Imag;
+        ALfloat d1r = x[2].Real - x[3].Real, d1i = x[2].Imag - x[3].Imag;
+        /* d1 times -i, or i for the inverse */
+        ALfloat tr = (inverse ? -d1i : d1i);
+        ALfloat ti = (inverse ? d1r : -d1r);
+
+        x[0].Real = s0r + s1r;  x[0].Imag = s0i + s1i;
+        x[2].Real = s0r - s1r;  x[2].Imag = s0i - s1i;
+        x[1].Real = d0r + tr;   x[1].Imag = d0i + ti;
+        x[3].Real = d0r - tr;   x[3].Imag = d0i - ti;
+    }
+
+    for(half = 4;half < size;half <<= 1)
+    {
+        for(i = 0;i < size;i += half*2)
+            FFTPass(&buffer[i], &buffer[i+half], &twiddles[half], half);
+    }
+}
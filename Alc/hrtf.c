@@ -22,34 +22,79 @@
 
 #include <stdlib.h>
 #include <ctype.h>
+#include <math.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include "AL/al.h"
 #include "AL/alc.h"
 #include "alMain.h"
 #include "alSource.h"
 
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
 
-static const ALchar magicMarker[8] = "MinPHR00";
+static const ALchar magicMarker00[8] = "MinPHR00";
+static const ALchar magicMarker01[8] = "MinPHR01";
 
 #define HRIR_COUNT 828
 #define ELEV_COUNT 19
+#define DEFAULT_HRIR_LENGTH 32
 
 static const ALushort evOffset[ELEV_COUNT] = { 0, 1, 13, 37, 73, 118, 174, 234, 306, 378, 450, 522, 594, 654, 710, 755, 791, 815, 827 };
 static const ALubyte azCount[ELEV_COUNT] = { 1, 12, 24, 36, 45, 56, 60, 72, 72, 72, 72, 72, 60, 56, 45, 36, 24, 12, 1 };
 
 
-static const struct Hrtf {
+/* A data set. The coefficients (irSize for each HRIR) and delays point into
+ * storage owned by the set's source (the built-in tables, a loaded file, or
+ * the resampled copy). */
+struct Hrtf {
     ALuint sampleRate;
-    ALshort coeffs[HRIR_COUNT][HRIR_LENGTH];
+    ALuint irSize;
+    const ALshort *coeffs;
+    const ALubyte *delays;
+};
+
+static const struct {
+    ALshort coeffs[HRIR_COUNT][DEFAULT_HRIR_LENGTH];
     ALubyte delays[HRIR_COUNT];
-} DefaultHrtf = {
-    44100,
+} DefaultHrtfData = {
 #include "hrtf_tables.inc"
 };
 
+static const struct Hrtf DefaultHrtf = {
+    44100, DEFAULT_HRIR_LENGTH, &DefaultHrtfData.coeffs[0][0], DefaultHrtfData.delays
+};
+
+/* Memory holding the data of the loaded sets. Files are mapped read-only
+ * where possible, so processes using the same file share its pages. */
+struct HrtfStorage {
+    void *data;
+    size_t size;
+    ALboolean mapped;
+};
+
+static struct HrtfStorage *HrtfStorages = NULL;
+static ALuint NumHrtfStorages = 0;
+
 static struct Hrtf *LoadedHrtfs = NULL;
 static ALuint NumLoadedHrtfs = 0;
+static ALboolean LoadedHrtfTables = AL_FALSE;
+
+/* Data sets resampled to device rates nothing else matched, or cut to a
+ * shorter HRIR length. These are only added to (with the list lock held) and
+ * are kept until FreeHrtf, since devices hold on to them. */
+static struct Hrtf **ResampledHrtfs = NULL;
+static ALuint NumResampledHrtfs = 0;
 
+/* Number of zero crossings on each side of the resampling filter's center */
+#define HRTF_RESAMPLE_ZERO_CROSSINGS (8)
 
 // Calculate the elevation indices given the polar elevation in radians.
 // This will return two indices between 0 and (ELEV_COUNT-1) and an
@@ -106,11 +151,10 @@ ALfloat CalcHrtfDelta(ALfloat oldGain, ALfloat newGain, const ALfloat olddir[3],
     return minf(change, 1.0f);
 }
 
-// Calculates static HRIR coefficients and delays for the given polar
-// elevation and azimuth in radians.  Linear interpolation is used to
-// increase the apparent resolution of the HRIR dataset.  The coefficients
-// are also normalized and attenuated by the specified gain.
-void GetLerpedHrtfCoeffs(const struct Hrtf *Hrtf, ALfloat elevation, ALfloat azimuth, ALfloat gain, ALfloat (*coeffs)[2], ALuint *delays)
+// Calculates the normalized HRIR coefficients and delays (in samples) for
+// the given polar elevation and azimuth in radians.  Linear interpolation is
+// used to increase the apparent resolution of the HRIR dataset.
+static void CalcHrtfTarget(const struct Hrtf *Hrtf, ALfloat elevation, ALfloat azimuth, ALfloat (*coeffs)[2], ALfloat *delays)
 {
     ALuint evidx[2], azidx[2];
     ALfloat mu[3];
@@ -142,135 +186,210 @@ void GetLerpedHrtfCoeffs(const struct Hrtf *Hrtf, ALfloat elevation, ALfloat azi
     ridx[2] = evOffset[evidx[1]] + ((azCount[evidx[1]]-azidx[0]) % azCount[evidx[1]]);
     ridx[3] = evOffset[evidx[1]] + ((azCount[evidx[1]]-azidx[1]) % azCount[evidx[1]]);
 
-    // Calculate the normalized and attenuated HRIR coefficients using linear
-    // interpolation when there is enough gain to warrant it.  Zero the
-    // coefficients if gain is too low.
+    // Calculate the HRIR delays using linear interpolation.
+    delays[0] = lerp(lerp(Hrtf->delays[lidx[0]], Hrtf->delays[lidx[1]], mu[0]),
+                     lerp(Hrtf->delays[lidx[2]], Hrtf->delays[lidx[3]], mu[1]),
+                     mu[2]);
+    delays[1] = lerp(lerp(Hrtf->delays[ridx[0]], Hrtf->delays[ridx[1]], mu[0]),
+                     lerp(Hrtf->delays[ridx[2]], Hrtf->delays[ridx[3]], mu[1]),
+                     mu[2]);
+
+    // Calculate the normalized HRIR coefficients using linear interpolation.
+    for(i = 0;i < 4;i++)
+    {
+        lidx[i] *= Hrtf->irSize;
+        ridx[i] *= Hrtf->irSize;
+    }
+    for(i = 0;i < Hrtf->irSize;i++)
+    {
+        coeffs[i][0] = lerp(lerp(Hrtf->coeffs[lidx[0]+i], Hrtf->coeffs[lidx[1]+i], mu[0]),
+                            lerp(Hrtf->coeffs[lidx[2]+i], Hrtf->coeffs[lidx[3]+i], mu[1]),
+                            mu[2]) * (1.0f/32767.0f);
+        coeffs[i][1] = lerp(lerp(Hrtf->coeffs[ridx[0]+i], Hrtf->coeffs[ridx[1]+i], mu[0]),
+                            lerp(Hrtf->coeffs[ridx[2]+i], Hrtf->coeffs[ridx[3]+i], mu[1]),
+                            mu[2]) * (1.0f/32767.0f);
+    }
+}
+
+
+// Directions are cached at this many steps per radian, a bit under 1 degree.
+#define CACHE_STEPS_PER_RADIAN 64.0f
+#define CACHE_AZ_STEPS ((ALuint)(F_PI*2.0f*CACHE_STEPS_PER_RADIAN + 0.5f))
+
+typedef struct HrtfCacheEntry {
+    // Quantized direction, plus one so zero marks an unused entry
+    ALuint Key;
+    ALfloat Coeffs[MAX_HRIR_LENGTH][2];
+    ALfloat Delays[2];
+} HrtfCacheEntry;
+
+struct HrtfCache {
+    const struct Hrtf *Hrtf;
+    ALuint Mask;
+    ALuint Hits;
+    ALuint Misses;
+    HrtfCacheEntry Entries[1];
+};
+
+// Creates a cache holding the interpolated HRIRs for up to the given number
+// of directions, rounded up to a power of 2.
+struct HrtfCache *CreateHrtfCache(ALuint size)
+{
+    struct HrtfCache *cache;
+    ALuint count = 1;
+
+    while(count < size)
+        count <<= 1;
+    cache = calloc(1, sizeof(*cache) + sizeof(cache->Entries[0])*(count-1));
+    if(!cache)
+        return NULL;
+    cache->Hrtf = NULL;
+    cache->Mask = count-1;
+    return cache;
+}
+
+// Sets the HRTF the cache holds HRIRs for, dropping the cached entries when
+// it changes.
+void ResetHrtfCache(struct HrtfCache *cache, const struct Hrtf *Hrtf)
+{
+    ALuint i;
+
+    if(cache->Hrtf == Hrtf)
+        return;
+    cache->Hrtf = Hrtf;
+    for(i = 0;i <= cache->Mask;i++)
+        cache->Entries[i].Key = 0;
+}
+
+void GetHrtfCacheStats(const struct HrtfCache *cache, ALuint *hits, ALuint *misses)
+{
+    *hits = cache->Hits;
+    *misses = cache->Misses;
+}
+
+// Gets the normalized HRIR coefficients and delays for the given direction,
+// from the cache if one's given.  Cached HRIRs are calculated for the
+// direction rounded to the cache's resolution, so every source near it
+// shares the same one.
+static void GetHrtfTarget(const struct Hrtf *Hrtf, struct HrtfCache *cache, ALfloat elevation, ALfloat azimuth, ALfloat (*coeffs)[2], ALfloat *delays)
+{
+    HrtfCacheEntry *entry;
+    ALuint evstep, azstep;
+    ALuint key, i;
+
+    if(!cache)
+    {
+        CalcHrtfTarget(Hrtf, elevation, azimuth, coeffs, delays);
+        return;
+    }
+
+    evstep = fastf2u((elevation + F_PI*0.5f) * CACHE_STEPS_PER_RADIAN + 0.5f);
+    if(azimuth < 0.0f)
+        azimuth += F_PI*2.0f;
+    azstep = fastf2u(azimuth * CACHE_STEPS_PER_RADIAN + 0.5f) % CACHE_AZ_STEPS;
+    key = evstep*CACHE_AZ_STEPS + azstep + 1;
+
+    entry = &cache->Entries[(key*2654435761u >> 16) & cache->Mask];
+    if(entry->Key == key)
+        cache->Hits++;
+    else
+    {
+        cache->Misses++;
+        entry->Key = key;
+        CalcHrtfTarget(Hrtf, evstep/CACHE_STEPS_PER_RADIAN - F_PI*0.5f,
+                       azstep/CACHE_STEPS_PER_RADIAN, entry->Coeffs,
+                       entry->Delays);
+    }
+
+    for(i = 0;i < Hrtf->irSize;i++)
+    {
+        coeffs[i][0] = entry->Coeffs[i][0];
+        coeffs[i][1] = entry->Coeffs[i][1];
+    }
+    delays[0] = entry->Delays[0];
+    delays[1] = entry->Delays[1];
+}
+
+
+// Calculates static HRIR coefficients and delays for the given polar
+// elevation and azimuth in radians.  The coefficients are normalized and
+// attenuated by the specified gain.  The optional cache is used to look up
+// the interpolated HRIR.
+void GetLerpedHrtfCoeffs(const struct Hrtf *Hrtf, struct HrtfCache *cache, ALfloat elevation, ALfloat azimuth, ALfloat gain, ALfloat (*coeffs)[2], ALuint *delays)
+{
+    ALfloat target[2];
+    ALuint i;
+
+    GetHrtfTarget(Hrtf, cache, elevation, azimuth, coeffs, target);
+
+    // Attenuate the HRIR coefficients when there is enough gain to warrant
+    // it.  Zero the coefficients if gain is too low.
     if(gain > 0.0001f)
     {
-        gain *= 1.0f/32767.0f;
-        for(i = 0;i < HRIR_LENGTH;i++)
+        for(i = 0;i < Hrtf->irSize;i++)
         {
-            coeffs[i][0] = lerp(lerp(Hrtf->coeffs[lidx[0]][i], Hrtf->coeffs[lidx[1]][i], mu[0]),
-                                lerp(Hrtf->coeffs[lidx[2]][i], Hrtf->coeffs[lidx[3]][i], mu[1]),
-                                mu[2]) * gain;
-            coeffs[i][1] = lerp(lerp(Hrtf->coeffs[ridx[0]][i], Hrtf->coeffs[ridx[1]][i], mu[0]),
-                                lerp(Hrtf->coeffs[ridx[2]][i], Hrtf->coeffs[ridx[3]][i], mu[1]),
-                                mu[2]) * gain;
+            coeffs[i][0] *= gain;
+            coeffs[i][1] *= gain;
         }
     }
     else
     {
-        for(i = 0;i < HRIR_LENGTH;i++)
+        for(i = 0;i < Hrtf->irSize;i++)
         {
             coeffs[i][0] = 0.0f;
             coeffs[i][1] = 0.0f;
         }
     }
 
-    // Calculate the HRIR delays using linear interpolation.
-    delays[0] = fastf2u(lerp(lerp(Hrtf->delays[lidx[0]], Hrtf->delays[lidx[1]], mu[0]),
-                             lerp(Hrtf->delays[lidx[2]], Hrtf->delays[lidx[3]], mu[1]),
-                             mu[2]) * 65536.0f);
-    delays[1] = fastf2u(lerp(lerp(Hrtf->delays[ridx[0]], Hrtf->delays[ridx[1]], mu[0]),
-                             lerp(Hrtf->delays[ridx[2]], Hrtf->delays[ridx[3]], mu[1]),
-                             mu[2]) * 65536.0f);
+    delays[0] = fastf2u(target[0] * 65536.0f);
+    delays[1] = fastf2u(target[1] * 65536.0f);
 }
 
 // Calculates the moving HRIR target coefficients, target delays, and
 // stepping values for the given polar elevation and azimuth in radians.
-// Linear interpolation is used to increase the apparent resolution of the
-// HRIR dataset.  The coefficients are also normalized and attenuated by the
-// specified gain.  Stepping resolution and count is determined using the
-// given delta factor between 0.0 and 1.0.
-ALuint GetMovingHrtfCoeffs(const struct Hrtf *Hrtf, ALfloat elevation, ALfloat azimuth, ALfloat gain, ALfloat delta, ALint counter, ALfloat (*coeffs)[2], ALuint *delays, ALfloat (*coeffStep)[2], ALint *delayStep)
+// The coefficients are normalized and attenuated by the specified gain.
+// Stepping resolution and count is determined using the given delta factor
+// between 0.0 and 1.0.  The optional cache is used to look up the
+// interpolated HRIR.
+ALuint GetMovingHrtfCoeffs(const struct Hrtf *Hrtf, struct HrtfCache *cache, ALfloat elevation, ALfloat azimuth, ALfloat gain, ALfloat delta, ALint counter, ALfloat (*coeffs)[2], ALuint *delays, ALfloat (*coeffStep)[2], ALint *delayStep)
 {
-    ALuint evidx[2], azidx[2];
-    ALuint lidx[4], ridx[4];
+    ALfloat targetCoeffs[MAX_HRIR_LENGTH][2];
+    ALfloat target[2];
     ALfloat left, right;
-    ALfloat mu[3];
     ALfloat step;
     ALuint i;
 
-    // Claculate elevation indices and interpolation factor.
-    CalcEvIndices(elevation, evidx, &mu[2]);
-
-    // Calculate azimuth indices and interpolation factor for the first
-    // elevation.
-    CalcAzIndices(evidx[0], azimuth, azidx, &mu[0]);
-
-    // Calculate the first set of linear HRIR indices for left and right
-    // channels.
-    lidx[0] = evOffset[evidx[0]] + azidx[0];
-    lidx[1] = evOffset[evidx[0]] + azidx[1];
-    ridx[0] = evOffset[evidx[0]] + ((azCount[evidx[0]]-azidx[0]) % azCount[evidx[0]]);
-    ridx[1] = evOffset[evidx[0]] + ((azCount[evidx[0]]-azidx[1]) % azCount[evidx[0]]);
-
-    // Calculate azimuth indices and interpolation factor for the second
-    // elevation.
-    CalcAzIndices(evidx[1], azimuth, azidx, &mu[1]);
-
-    // Calculate the second set of linear HRIR indices for left and right
-    // channels.
-    lidx[2] = evOffset[evidx[1]] + azidx[0];
-    lidx[3] = evOffset[evidx[1]] + azidx[1];
-    ridx[2] = evOffset[evidx[1]] + ((azCount[evidx[1]]-azidx[0]) % azCount[evidx[1]]);
-    ridx[3] = evOffset[evidx[1]] + ((azCount[evidx[1]]-azidx[1]) % azCount[evidx[1]]);
+    GetHrtfTarget(Hrtf, cache, elevation, azimuth, targetCoeffs, target);
 
     // Calculate the stepping parameters.
     delta = maxf(aluFloor(delta*(Hrtf->sampleRate*0.015f) + 0.5f), 1.0f);
     step = 1.0f / delta;
 
-    // Calculate the normalized and attenuated target HRIR coefficients using
-    // linear interpolation when there is enough gain to warrant it.  Zero
-    // the target coefficients if gain is too low.  Then calculate the
-    // coefficient stepping values using the target and previous running
-    // coefficients.
-    if(gain > 0.0001f)
+    // Calculate the attenuated target HRIR coefficients when there is enough
+    // gain to warrant it.  Zero the target coefficients if gain is too low.
+    // Then calculate the coefficient stepping values using the target and
+    // previous running coefficients.
+    if(!(gain > 0.0001f))
+        gain = 0.0f;
+    for(i = 0;i < Hrtf->irSize;i++)
     {
-        gain *= 1.0f/32767.0f;
-        for(i = 0;i < HRIR_LENGTH;i++)
-        {
-            left = coeffs[i][0] - (coeffStep[i][0] * counter);
-            right = coeffs[i][1] - (coeffStep[i][1] * counter);
-
-            coeffs[i][0] = lerp(lerp(Hrtf->coeffs[lidx[0]][i], Hrtf->coeffs[lidx[1]][i], mu[0]),
-                                lerp(Hrtf->coeffs[lidx[2]][i], Hrtf->coeffs[lidx[3]][i], mu[1]),
-                                mu[2]) * gain;
-            coeffs[i][1] = lerp(lerp(Hrtf->coeffs[ridx[0]][i], Hrtf->coeffs[ridx[1]][i], mu[0]),
-                                lerp(Hrtf->coeffs[ridx[2]][i], Hrtf->coeffs[ridx[3]][i], mu[1]),
-                                mu[2]) * gain;
-
-            coeffStep[i][0] = step * (coeffs[i][0] - left);
-            coeffStep[i][1] = step * (coeffs[i][1] - right);
-        }
-    }
-    else
-    {
-        for(i = 0;i < HRIR_LENGTH;i++)
-        {
-            left = coeffs[i][0] - (coeffStep[i][0] * counter);
-            right = coeffs[i][1] - (coeffStep[i][1] * counter);
+        left = coeffs[i][0] - (coeffStep[i][0] * counter);
+        right = coeffs[i][1] - (coeffStep[i][1] * counter);
 
-            coeffs[i][0] = 0.0f;
-            coeffs[i][1] = 0.0f;
+        coeffs[i][0] = targetCoeffs[i][0] * gain;
+        coeffs[i][1] = targetCoeffs[i][1] * gain;
 
-            coeffStep[i][0] = step * -left;
-            coeffStep[i][1] = step * -right;
-        }
+        coeffStep[i][0] = step * (coeffs[i][0] - left);
+        coeffStep[i][1] = step * (coeffs[i][1] - right);
     }
 
-    // Calculate the HRIR delays using linear interpolation.  Then calculate
-    // the delay stepping values using the target and previous running
-    // delays.
+    // Calculate the HRIR delay stepping values using the target and previous
+    // running delays.
     left = (ALfloat)(delays[0] - (delayStep[0] * counter));
     right = (ALfloat)(delays[1] - (delayStep[1] * counter));
 
-    delays[0] = fastf2u(lerp(lerp(Hrtf->delays[lidx[0]], Hrtf->delays[lidx[1]], mu[0]),
-                             lerp(Hrtf->delays[lidx[2]], Hrtf->delays[lidx[3]], mu[1]),
-                             mu[2]) * 65536.0f);
-    delays[1] = fastf2u(lerp(lerp(Hrtf->delays[ridx[0]], Hrtf->delays[ridx[1]], mu[0]),
-                             lerp(Hrtf->delays[ridx[2]], Hrtf->delays[ridx[3]], mu[1]),
-                             mu[2]) * 65536.0f);
+    delays[0] = fastf2u(target[0] * 65536.0f);
+    delays[1] = fastf2u(target[1] * 65536.0f);
 
     delayStep[0] = fastf2i(step * (delays[0] - left));
     delayStep[1] = fastf2i(step * (delays[1] - right));
@@ -281,25 +400,636 @@ ALuint GetMovingHrtfCoeffs(const struct Hrtf *Hrtf, ALfloat elevation, ALfloat a
     return fastf2u(delta);
 }
 
-const struct Hrtf *GetHrtf(ALCdevice *device)
+// Makes sure the given HRTF state can hold the given number of channels and
+// HRIR length, reallocating it if not.  A new state starts out silent.
+// Returns NULL (and frees the old state) if allocation fails.
+struct HrtfState *ResizeHrtfState(struct HrtfState *state, ALuint numChannels, ALuint irSize)
 {
-    if(device->FmtChans == DevFmtStereo)
+    size_t size;
+
+    if(state && state->NumChannels == numChannels && state->IrSize == irSize)
+        return state;
+    free(state);
+
+    size = sizeof(*state) + sizeof(ALfloat[2])*(2*numChannels+1)*irSize;
+    state = calloc(1, size);
+    if(!state)
+        return NULL;
+
+    state->IrSize = irSize;
+    state->NumChannels = numChannels;
+    state->Coeffs = (ALfloat(*)[2])(state+1);
+    state->CoeffStep = state->Coeffs + numChannels*irSize;
+    state->Values = state->CoeffStep + irSize;
+    return state;
+}
+
+// Silences the time-domain convolution output carried over from previous
+// mixes, for when a source (re)starts playback.
+void ClearHrtfState(struct HrtfState *state)
+{
+    ALuint i;
+
+    if(!state)
+        return;
+    for(i = 0;i < state->NumChannels*state->IrSize;i++)
+    {
+        state->Values[i][0] = 0.0f;
+        state->Values[i][1] = 0.0f;
+    }
+}
+
+// Makes sure the given FFT convolution state can hold the given number of
+// channels and HRIR length, reallocating it if not.  A new state starts out
+// silent.  Returns NULL (and frees the old state) if allocation fails.
+struct HrtfFftState *ResizeHrtfFftState(struct HrtfFftState *state, ALuint numChannels, ALuint irSize)
+{
+    ALuint fftSize;
+    size_t size;
+
+    if(state && state->NumChannels == numChannels && state->IrSize == irSize)
+        return state;
+    free(state);
+
+    // Use an FFT size of at least four times the HRIR length, so each block
+    // of input produces a decent number of samples.
+    fftSize = 1;
+    while(fftSize < irSize*4)
+        fftSize <<= 1;
+    if(fftSize > MAX_FFT_SIZE)
+    {
+        ERR("HRIR length %u too long for FFT convolution\n", irSize);
+        return NULL;
+    }
+
+    size = sizeof(*state) + sizeof(ALcomplex)*numChannels*4*fftSize +
+           sizeof(ALfloat)*numChannels*2*(irSize-1);
+    state = calloc(1, size);
+    if(!state)
+        return NULL;
+
+    state->FftSize = fftSize;
+    state->IrSize = irSize;
+    state->NumChannels = numChannels;
+    state->FadeLength = 0;
+    state->Filters = (ALcomplex*)(state+1);
+    state->Tails = (ALfloat*)(state->Filters + numChannels*4*fftSize);
+    return state;
+}
+
+// Silences the convolution state's output carried over from previous
+// blocks, for when a source (re)starts playback.
+void ClearHrtfFftState(struct HrtfFftState *state)
+{
+    ALuint i;
+
+    if(!state)
+        return;
+    for(i = 0;i < state->NumChannels*2*(state->IrSize-1);i++)
+        state->Tails[i] = 0.0f;
+}
+
+// Sets the HRIR coefficients and delays (16.16 fixed point) used for the
+// given channel's FFT convolution.  The previous filter is kept so the mixer
+// can crossfade from it over fadeLength samples, with 0 switching to the new
+// filter immediately.
+void SetHrtfFftFilter(struct HrtfFftState *state, ALuint chan, const ALfloat (*coeffs)[2], const ALuint *delays, ALuint fadeLength)
+{
+    const ALuint fftSize = state->FftSize;
+    const ALfloat scale = 0.25f / fftSize;
+    ALcomplex *RESTRICT filter = &state->Filters[chan*4*fftSize];
+    ALcomplex *RESTRICT sum = &filter[0];
+    ALcomplex *RESTRICT diff = &filter[fftSize];
+    ALuint i;
+
+    // Move the current filter to the old one.
+    for(i = 0;i < 2*fftSize;i++)
+        filter[2*fftSize + i] = filter[i];
+    state->OldDelay[chan][0] = state->Delay[chan][0];
+    state->OldDelay[chan][1] = state->Delay[chan][1];
+
+    // Transform both ears' responses at once, with the left in the real
+    // part and the right in the imaginary part.
+    for(i = 0;i < state->IrSize;i++)
+    {
+        sum[i].Real = coeffs[i][0];
+        sum[i].Imag = coeffs[i][1];
+    }
+    for(;i < fftSize;i++)
+    {
+        sum[i].Real = 0.0f;
+        sum[i].Imag = 0.0f;
+    }
+    aluFFT(sum, fftSize, AL_FALSE);
+
+    // Split it into the halved sum and difference of the ears' spectra,
+    // which is what the mixer needs to filter two real signals packed in
+    // one complex transform. The inverse transform's scaling is folded in
+    // here too.
+    for(i = 0;i <= fftSize/2;i++)
+    {
+        const ALuint j = (fftSize-i) & (fftSize-1);
+        ALcomplex z = sum[i], zc = sum[j];
+        ALcomplex left, right;
+
+        // Twice the ears' spectra, as Z[i] + conj(Z[N-i]) for the left and
+        // (Z[i] - conj(Z[N-i]))/i for the right.
+        left.Real = (z.Real + zc.Real);
+        left.Imag = (z.Imag - zc.Imag);
+        right.Real = (z.Imag + zc.Imag);
+        right.Imag = (zc.Real - z.Real);
+
+        sum[i].Real = (left.Real + right.Real) * scale;
+        sum[i].Imag = (left.Imag + right.Imag) * scale;
+        diff[i].Real = (left.Real - right.Real) * scale;
+        diff[i].Imag = (left.Imag - right.Imag) * scale;
+
+        // The ears' spectra are conjugate symmetric, being real responses.
+        sum[j].Real = (left.Real + right.Real) * scale;
+        sum[j].Imag = -(left.Imag + right.Imag) * scale;
+        diff[j].Real = (left.Real - right.Real) * scale;
+        diff[j].Imag = -(left.Imag - right.Imag) * scale;
+    }
+
+    state->Delay[chan][0] = (delays[0]+32768) >> 16;
+    state->Delay[chan][1] = (delays[1]+32768) >> 16;
+    state->FadeLength = fadeLength;
+}
+
+// The HRTF bed holds first-order B-format (W, X, Y, Z), which gets decoded
+// to a cube of virtual speakers that are each filtered with a fixed HRIR.
+#define BED_SPEAKERS 8
+
+struct HrtfBed {
+    ALfloat Decoder[BED_SPEAKERS][HRTF_BED_CHANNELS];
+    ALfloat Coeffs[BED_SPEAKERS][MAX_HRIR_LENGTH][2];
+    ALuint Delay[BED_SPEAKERS][2];
+    ALuint IrSize;
+
+    ALfloat History[BED_SPEAKERS][SRC_HISTORY_LENGTH];
+    ALfloat Values[BED_SPEAKERS][MAX_HRIR_LENGTH][2];
+    ALuint Offset;
+};
+
+// Calculates the B-format gains for panning a sound from the given polar
+// elevation and azimuth in radians into the HRTF bed.
+void GetHrtfBedGains(ALfloat elevation, ALfloat azimuth, ALfloat gain, ALfloat *gains)
+{
+    gains[0] = gain;
+    gains[1] = gain * aluCos(elevation) * aluCos(azimuth);
+    gains[2] = gain * aluCos(elevation) * aluSin(azimuth);
+    gains[3] = gain * aluSin(elevation);
+}
+
+// Creates an HRTF bed with its virtual speakers' HRIRs taken from the given
+// HRTF.  Returns NULL if allocation fails.
+struct HrtfBed *CreateHrtfBed(const struct Hrtf *Hrtf)
+{
+    // The speakers sit at the corners of a cube around the listener.
+    static const ALfloat SpeakerEv = 0.61547971f; // atan(1/sqrt(2))
+    static const ALfloat SpeakerAz[BED_SPEAKERS/2] = {
+        -F_PI*0.25f, F_PI*0.25f, F_PI*0.75f, -F_PI*0.75f
+    };
+    struct HrtfBed *bed;
+    ALfloat dir[HRTF_BED_CHANNELS];
+    ALfloat ev;
+    ALuint s, c;
+
+    bed = calloc(1, sizeof(*bed));
+    if(!bed)
+        return NULL;
+    bed->IrSize = Hrtf->irSize;
+
+    for(s = 0;s < BED_SPEAKERS;s++)
     {
-        ALuint i;
-        for(i = 0;i < NumLoadedHrtfs;i++)
+        ev = (s < BED_SPEAKERS/2) ? SpeakerEv : -SpeakerEv;
+        GetLerpedHrtfCoeffs(Hrtf, NULL, ev, SpeakerAz[s%(BED_SPEAKERS/2)], 1.0f,
+                            bed->Coeffs[s], bed->Delay[s]);
+        bed->Delay[s][0] = (bed->Delay[s][0]+32768) >> 16;
+        bed->Delay[s][1] = (bed->Delay[s][1]+32768) >> 16;
+
+        // Each speaker gets an equal share of W, and of the directional
+        // components projected onto its direction.  The directional part is
+        // weighted to keep the energy focused toward the sound.
+        GetHrtfBedGains(ev, SpeakerAz[s%(BED_SPEAKERS/2)], 1.0f, dir);
+        bed->Decoder[s][0] = 1.0f / BED_SPEAKERS;
+        for(c = 1;c < HRTF_BED_CHANNELS;c++)
+            bed->Decoder[s][c] = dir[c] * aluSqrt(3.0f) / BED_SPEAKERS;
+    }
+
+    return bed;
+}
+
+// Decodes the HRTF bed to its virtual speakers and adds each of them to the
+// stereo output through its HRIR.
+void MixHrtfBed(struct HrtfBed *Bed, ALfloat (*BedBuffer)[BUFFERSIZE], ALfloat (*OutBuffer)[BUFFERSIZE], ALuint SamplesToDo)
+{
+    ALfloat *RESTRICT History;
+    ALfloat (*RESTRICT Values)[2];
+    ALfloat (*RESTRICT Coeffs)[2];
+    const ALfloat *Decoder;
+    const ALuint IrMask = Bed->IrSize-1;
+    ALfloat value, left, right;
+    ALuint Offset;
+    ALuint s, i, c;
+
+    for(s = 0;s < BED_SPEAKERS;s++)
+    {
+        History = Bed->History[s];
+        Values = Bed->Values[s];
+        Coeffs = Bed->Coeffs[s];
+        Decoder = Bed->Decoder[s];
+        Offset = Bed->Offset;
+
+        for(i = 0;i < SamplesToDo;i++)
         {
-            if(device->Frequency == LoadedHrtfs[i].sampleRate)
-                return &LoadedHrtfs[i];
+            value = BedBuffer[0][i]*Decoder[0] + BedBuffer[1][i]*Decoder[1] +
+                    BedBuffer[2][i]*Decoder[2] + BedBuffer[3][i]*Decoder[3];
+
+            History[Offset&SRC_HISTORY_MASK] = value;
+            left = History[(Offset-Bed->Delay[s][0])&SRC_HISTORY_MASK];
+            right = History[(Offset-Bed->Delay[s][1])&SRC_HISTORY_MASK];
+
+            Values[Offset&IrMask][0] = 0.0f;
+            Values[Offset&IrMask][1] = 0.0f;
+            Offset++;
+
+            for(c = 0;c < Bed->IrSize;c++)
+            {
+                const ALuint off = (Offset+c)&IrMask;
+                Values[off][0] += Coeffs[c][0] * left;
+                Values[off][1] += Coeffs[c][1] * right;
+            }
+
+            OutBuffer[FRONT_LEFT][i]  += Values[Offset&IrMask][0];
+            OutBuffer[FRONT_RIGHT][i] += Values[Offset&IrMask][1];
         }
-        if(device->Frequency == DefaultHrtf.sampleRate)
-            return &DefaultHrtf;
     }
-    ERR("Incompatible format: %s %uhz\n",
-        DevFmtChannelsString(device->FmtChans), device->Frequency);
-    return NULL;
+    Bed->Offset += SamplesToDo;
+}
+
+static __inline ALuint RateDiff(ALuint a, ALuint b)
+{ return ((a > b) ? (a-b) : (b-a)); }
+
+static __inline ALdouble Sinc(ALdouble x)
+{
+    if(fabs(x) < 1e-9)
+        return 1.0;
+    return sin(M_PI*x) / (M_PI*x);
 }
 
-void InitHrtf(void)
+/* Creates a copy of the given data set at the new sample rate and HRIR
+ * length. Each HRIR is resampled with a Blackman-windowed sinc filter,
+ * low-passed to the lower of the two Nyquist frequencies, and cut to irSize.
+ * The onset delays are scaled to the new rate, failing if any of them no
+ * longer fit in the source history. */
+static struct Hrtf *ResampleHrtf(const struct Hrtf *src, ALuint rate, ALuint irSize)
+{
+    const ALdouble ratio = (ALdouble)src->sampleRate / rate;
+    const ALdouble cutoff = ((rate < src->sampleRate) ? (ALdouble)rate/src->sampleRate : 1.0);
+    const ALdouble width = HRTF_RESAMPLE_ZERO_CROSSINGS / cutoff;
+    ALshort *coeffs;
+    ALubyte *delays;
+    struct Hrtf *hrtf;
+    ALuint i, j, k;
+
+    hrtf = malloc(sizeof(*hrtf) + sizeof(coeffs[0])*HRIR_COUNT*irSize +
+                  sizeof(delays[0])*HRIR_COUNT);
+    if(!hrtf)
+        return NULL;
+    coeffs = (ALshort*)(hrtf+1);
+    delays = (ALubyte*)(coeffs + HRIR_COUNT*irSize);
+
+    hrtf->sampleRate = rate;
+    hrtf->irSize = irSize;
+    hrtf->coeffs = coeffs;
+    hrtf->delays = delays;
+
+    if(rate == src->sampleRate)
+    {
+        /* Only the length changes */
+        for(i = 0;i < HRIR_COUNT;i++)
+        {
+            for(j = 0;j < irSize;j++)
+                coeffs[i*irSize + j] = ((j < src->irSize) ?
+                                        src->coeffs[i*src->irSize + j] : 0);
+        }
+        memcpy(delays, src->delays, HRIR_COUNT);
+        return hrtf;
+    }
+
+    for(i = 0;i < HRIR_COUNT;i++)
+    {
+        const ALshort *srccoeffs = &src->coeffs[i*src->irSize];
+
+        for(j = 0;j < irSize;j++)
+        {
+            const ALdouble pos = j * ratio;
+            ALdouble sum = 0.0;
+            ALint val;
+
+            for(k = 0;k < src->irSize;k++)
+            {
+                const ALdouble x = pos - k;
+                ALdouble w;
+
+                if(fabs(x) >= width)
+                    continue;
+                w = 0.42 + 0.5*cos(M_PI*x/width) + 0.08*cos(2.0*M_PI*x/width);
+                sum += srccoeffs[k] * cutoff * Sinc(cutoff*x) * w;
+            }
+            /* The new rate has ratio times as many samples over the same
+             * span, so scale them to keep the same overall gain */
+            sum *= ratio;
+
+            val = (ALint)floor(sum + 0.5);
+            coeffs[i*irSize + j] = (ALshort)((val > 32767) ? 32767 :
+                                             ((val < -32768) ? -32768 : val));
+        }
+
+        k = (ALuint)floor(src->delays[i]/ratio + 0.5);
+        if(k > SRC_HISTORY_LENGTH-1)
+        {
+            WARN("Delay[%u] %u too long at %uhz (max %d)\n", i, k, rate,
+                 SRC_HISTORY_LENGTH-1);
+            free(hrtf);
+            return NULL;
+        }
+        delays[i] = (ALubyte)k;
+    }
+
+    return hrtf;
+}
+
+static __inline ALuint ReadLE(const ALubyte *data, ALuint bytes)
+{
+    ALuint ret = 0;
+    while(bytes > 0)
+    {
+        bytes--;
+        ret = (ret<<8) | data[bytes];
+    }
+    return ret;
+}
+
+/* Gets the whole file in memory, mapping it if the data can be used as-is
+ * (which needs a little-endian host). Otherwise, it's read in one go. */
+static ALboolean ReadHrtfFile(const char *fname, struct HrtfStorage *storage)
+{
+    long size;
+    FILE *f;
+
+#ifdef HAVE_SYS_MMAN_H
+    if(IS_LITTLE_ENDIAN)
+    {
+        struct stat st;
+        int fd;
+
+        fd = open(fname, O_RDONLY);
+        if(fd >= 0)
+        {
+            if(fstat(fd, &st) == 0 && st.st_size > 0)
+            {
+                void *ptr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+                if(ptr != MAP_FAILED)
+                {
+                    close(fd);
+                    storage->data = ptr;
+                    storage->size = st.st_size;
+                    storage->mapped = AL_TRUE;
+                    return AL_TRUE;
+                }
+            }
+            close(fd);
+        }
+    }
+#endif
+
+    f = fopen(fname, "rb");
+    if(f == NULL)
+    {
+        ERR("Could not open %s\n", fname);
+        return AL_FALSE;
+    }
+
+    storage->data = NULL;
+    storage->size = 0;
+    storage->mapped = AL_FALSE;
+    if(fseek(f, 0, SEEK_END) == 0 && (size=ftell(f)) > 0 && fseek(f, 0, SEEK_SET) == 0)
+    {
+        storage->data = malloc(size);
+        if(storage->data && fread(storage->data, 1, size, f) == (size_t)size)
+            storage->size = size;
+        else
+        {
+            free(storage->data);
+            storage->data = NULL;
+        }
+    }
+    fclose(f);
+
+    if(!storage->data)
+    {
+        ERR("Failed to read %s\n", fname);
+        return AL_FALSE;
+    }
+    return AL_TRUE;
+}
+
+static void ReleaseHrtfStorage(struct HrtfStorage *storage)
+{
+#ifdef HAVE_SYS_MMAN_H
+    if(storage->mapped)
+        munmap(storage->data, storage->size);
+    else
+#endif
+        free(storage->data);
+    storage->data = NULL;
+    storage->size = 0;
+}
+
+static ALboolean IsValidHrirSize(ALuint hrirSize)
+{
+    ALuint size;
+    for(size = MIN_HRIR_LENGTH;size <= MAX_HRIR_LENGTH;size <<= 1)
+    {
+        if(hrirSize == size)
+            return AL_TRUE;
+    }
+    return AL_FALSE;
+}
+
+static ALboolean CheckHrtfLayout(ALuint hrirCount, ALuint hrirSize, ALuint evCount)
+{
+    if(hrirCount != HRIR_COUNT || !IsValidHrirSize(hrirSize) || evCount != ELEV_COUNT)
+    {
+        ERR("Unsupported value: hrirCount=%d (%d), hrirSize=%d (%d to %d), evCount=%d (%d)\n",
+            hrirCount, HRIR_COUNT, hrirSize, MIN_HRIR_LENGTH, MAX_HRIR_LENGTH,
+            evCount, ELEV_COUNT);
+        return AL_FALSE;
+    }
+    return AL_TRUE;
+}
+
+static ALboolean CheckHrtfOffsets(const ALubyte *offsets)
+{
+    ALboolean failed = AL_FALSE;
+    ALuint i;
+
+    for(i = 0;i < ELEV_COUNT;i++)
+    {
+        ALushort offset = ReadLE(&offsets[i*2], 2);
+        if(offset != evOffset[i])
+        {
+            ERR("Unsupported evOffset[%d] value: %d (%d)\n", i, offset, evOffset[i]);
+            failed = AL_TRUE;
+        }
+    }
+    return !failed;
+}
+
+static ALboolean CheckHrtfDelays(const ALubyte *delays)
+{
+    const ALubyte maxDelay = SRC_HISTORY_LENGTH-1;
+    ALboolean failed = AL_FALSE;
+    ALuint i;
+
+    for(i = 0;i < HRIR_COUNT;i++)
+    {
+        if(delays[i] > maxDelay)
+        {
+            ERR("Invalid delay[%d]: %d (%d)\n", i, delays[i], maxDelay);
+            failed = AL_TRUE;
+        }
+    }
+    return !failed;
+}
+
+static ALboolean AddLoadedHrtf(ALuint rate, ALuint irSize, const ALshort *coeffs, const ALubyte *delays)
+{
+    void *temp = realloc(LoadedHrtfs, (NumLoadedHrtfs+1)*sizeof(LoadedHrtfs[0]));
+    if(temp == NULL)
+        return AL_FALSE;
+
+    LoadedHrtfs = temp;
+    LoadedHrtfs[NumLoadedHrtfs].sampleRate = rate;
+    LoadedHrtfs[NumLoadedHrtfs].irSize = irSize;
+    LoadedHrtfs[NumLoadedHrtfs].coeffs = coeffs;
+    LoadedHrtfs[NumLoadedHrtfs].delays = delays;
+    NumLoadedHrtfs++;
+
+    TRACE("Loaded HRTF support for format: %s %uhz, %u samples\n",
+          DevFmtChannelsString(DevFmtStereo), rate, irSize);
+    return AL_TRUE;
+}
+
+/* Loads a "MinPHR00" file, holding a single set. Its data isn't aligned, so
+ * it's converted into new storage. */
+static ALboolean LoadHrtf00(const ALubyte *data, size_t size, struct HrtfStorage *storage)
+{
+    const size_t headerSize = 8 + 4 + 2 + 2 + 1 + ELEV_COUNT*2;
+    ALuint rate, irSize, i;
+    ALshort *coeffs;
+    ALubyte *delays;
+
+    if(size < 8+4+2+2+1)
+    {
+        ERR("Premature end of data\n");
+        return AL_FALSE;
+    }
+    rate = ReadLE(&data[8], 4);
+    irSize = ReadLE(&data[14], 2);
+    if(!CheckHrtfLayout(ReadLE(&data[12], 2), irSize, data[16]))
+        return AL_FALSE;
+    if(size < headerSize + HRIR_COUNT*irSize*2 + HRIR_COUNT)
+    {
+        ERR("Premature end of data\n");
+        return AL_FALSE;
+    }
+    if(!CheckHrtfOffsets(&data[17]))
+        return AL_FALSE;
+    data += headerSize;
+
+    storage->size = sizeof(coeffs[0])*HRIR_COUNT*irSize + sizeof(delays[0])*HRIR_COUNT;
+    storage->data = malloc(storage->size);
+    storage->mapped = AL_FALSE;
+    if(!storage->data)
+        return AL_FALSE;
+    coeffs = storage->data;
+    delays = (ALubyte*)(coeffs + HRIR_COUNT*irSize);
+
+    for(i = 0;i < HRIR_COUNT*irSize;i++)
+    {
+        coeffs[i] = (ALshort)ReadLE(data, 2);
+        data += 2;
+    }
+    memcpy(delays, data, HRIR_COUNT);
+
+    if(!CheckHrtfDelays(delays) || !AddLoadedHrtf(rate, irSize, coeffs, delays))
+    {
+        ReleaseHrtfStorage(storage);
+        return AL_FALSE;
+    }
+    return AL_TRUE;
+}
+
+/* Loads a "MinPHR01" file, holding sets for one or more sample rates. The
+ * data is laid out so the sets can be used directly from the file's storage,
+ * once swapped to the host's byte order. */
+static ALboolean LoadHrtf01(ALubyte *data, size_t size)
+{
+    ALuint rateCount, irSize, i, j;
+    size_t headerSize, setSize;
+    const ALubyte *rates;
+
+    if(size < 8+2+2+1+1)
+    {
+        ERR("Premature end of data\n");
+        return AL_FALSE;
+    }
+    irSize = ReadLE(&data[10], 2);
+    if(!CheckHrtfLayout(ReadLE(&data[8], 2), irSize, data[12]))
+        return AL_FALSE;
+    setSize = HRIR_COUNT*irSize*2 + HRIR_COUNT;
+    rateCount = data[13];
+    if(rateCount == 0)
+    {
+        ERR("No sample rates\n");
+        return AL_FALSE;
+    }
+    headerSize = 8+2+2+1+1 + ELEV_COUNT*2 + rateCount*4;
+    if(size < headerSize + setSize*rateCount)
+    {
+        ERR("Premature end of data\n");
+        return AL_FALSE;
+    }
+    if(!CheckHrtfOffsets(&data[14]))
+        return AL_FALSE;
+    rates = &data[14 + ELEV_COUNT*2];
+
+    for(i = 0;i < rateCount;i++)
+    {
+        ALubyte *set = &data[headerSize + setSize*i];
+        if(!IS_LITTLE_ENDIAN)
+        {
+            ALshort *coeffs = (ALshort*)set;
+            for(j = 0;j < HRIR_COUNT*irSize;j++)
+                coeffs[j] = (ALshort)ReadLE(&set[j*2], 2);
+        }
+        if(!CheckHrtfDelays(&set[HRIR_COUNT*irSize*2]))
+            return AL_FALSE;
+    }
+
+    for(i = 0;i < rateCount;i++)
+    {
+        const ALubyte *set = &data[headerSize + setSize*i];
+        AddLoadedHrtf(ReadLE(&rates[i*4], 4), irSize, (const ALshort*)set,
+                      &set[HRIR_COUNT*irSize*2]);
+    }
+    return AL_TRUE;
+}
+
+static void LoadHrtfTables(void)
 {
     char *fnamelist=NULL, *next=NULL;
     const char *val;
@@ -308,27 +1038,19 @@ void InitHrtf(void)
         next = fnamelist = strdup(val);
     while(next && *next)
     {
-        const ALubyte maxDelay = SRC_HISTORY_LENGTH-1;
-        struct Hrtf newdata;
+        struct HrtfStorage storage, converted;
         ALboolean failed;
-        ALchar magic[9];
-        ALsizei i, j;
         char *fname;
-        FILE *f;
+        void *temp;
 
         fname = next;
         next = strchr(fname, ',');
         if(next)
         {
-            while(next != fname)
-            {
-                next--;
-                if(!isspace(*next))
-                {
-                    *(next++) = '\0';
-                    break;
-                }
-            }
+            char *end = next++;
+            while(end != fname && isspace(*(end-1)))
+                end--;
+            *end = '\0';
             while(isspace(*next) || *next == ',')
                 next++;
         }
@@ -336,122 +1058,172 @@ void InitHrtf(void)
         if(!fname[0])
             continue;
         TRACE("Loading %s\n", fname);
-        f = fopen(fname, "rb");
-        if(f == NULL)
+        if(!ReadHrtfFile(fname, &storage))
+            continue;
+
+        temp = realloc(HrtfStorages, (NumHrtfStorages+1)*sizeof(HrtfStorages[0]));
+        if(temp == NULL)
         {
-            ERR("Could not open %s\n", fname);
+            ReleaseHrtfStorage(&storage);
             continue;
         }
+        HrtfStorages = temp;
 
-        failed = AL_FALSE;
-        if(fread(magic, 1, sizeof(magicMarker), f) != sizeof(magicMarker))
-        {
+        failed = AL_TRUE;
+        if(storage.size < sizeof(magicMarker00))
             ERR("Failed to read magic marker\n");
-            failed = AL_TRUE;
+        else if(memcmp(storage.data, magicMarker00, sizeof(magicMarker00)) == 0)
+        {
+            if(LoadHrtf00(storage.data, storage.size, &converted))
+            {
+                ReleaseHrtfStorage(&storage);
+                storage = converted;
+                failed = AL_FALSE;
+            }
         }
-        else if(memcmp(magic, magicMarker, sizeof(magicMarker)) != 0)
+        else if(memcmp(storage.data, magicMarker01, sizeof(magicMarker01)) == 0)
+            failed = !LoadHrtf01(storage.data, storage.size);
+        else
         {
+            ALchar magic[9];
+            memcpy(magic, storage.data, 8);
             magic[8] = 0;
             ERR("Invalid magic marker: \"%s\"\n", magic);
-            failed = AL_TRUE;
         }
 
-        if(!failed)
+        if(failed)
         {
-            ALushort hrirCount, hrirSize;
-            ALubyte  evCount;
-
-            newdata.sampleRate  = fgetc(f);
-            newdata.sampleRate |= fgetc(f)<<8;
-            newdata.sampleRate |= fgetc(f)<<16;
-            newdata.sampleRate |= fgetc(f)<<24;
-
-            hrirCount  = fgetc(f);
-            hrirCount |= fgetc(f)<<8;
+            ReleaseHrtfStorage(&storage);
+            ERR("Failed to load %s\n", fname);
+            continue;
+        }
+        HrtfStorages[NumHrtfStorages++] = storage;
+    }
+    free(fnamelist);
+    fnamelist = NULL;
+}
 
-            hrirSize  = fgetc(f);
-            hrirSize |= fgetc(f)<<8;
+const struct Hrtf *GetHrtf(ALCdevice *device)
+{
+    if(device->FmtChans == DevFmtStereo)
+    {
+        ALuint maxSize = MAX_HRIR_LENGTH;
+        const struct Hrtf *src = NULL;
+        struct Hrtf *hrtf;
+        ALuint irSize, diff, i;
 
-            evCount = fgetc(f);
+        if(!LoadedHrtfTables)
+        {
+            LoadHrtfTables();
+            LoadedHrtfTables = AL_TRUE;
+        }
 
-            if(hrirCount != HRIR_COUNT || hrirSize != HRIR_LENGTH || evCount != ELEV_COUNT)
-            {
-                ERR("Unsupported value: hrirCount=%d (%d), hrirSize=%d (%d), evCount=%d (%d)\n",
-                    hrirCount, HRIR_COUNT, hrirSize, HRIR_LENGTH, evCount, ELEV_COUNT);
-                failed = AL_TRUE;
-            }
+        if(ConfigValueUInt(NULL, "hrtf_size", &maxSize) && !IsValidHrirSize(maxSize))
+        {
+            WARN("Invalid HRIR size: %u\n", maxSize);
+            maxSize = MAX_HRIR_LENGTH;
         }
 
-        if(!failed)
+        for(i = 0;i < NumLoadedHrtfs && !src;i++)
         {
-            for(i = 0;i < ELEV_COUNT;i++)
-            {
-                ALushort offset;
-                offset  = fgetc(f);
-                offset |= fgetc(f)<<8;
-                if(offset != evOffset[i])
-                {
-                    ERR("Unsupported evOffset[%d] value: %d (%d)\n", i, offset, evOffset[i]);
-                    failed = AL_TRUE;
-                }
-            }
+            if(device->Frequency == LoadedHrtfs[i].sampleRate)
+                src = &LoadedHrtfs[i];
         }
+        if(!src && device->Frequency == DefaultHrtf.sampleRate)
+            src = &DefaultHrtf;
+        if(src && src->irSize <= maxSize)
+            return src;
 
-        if(!failed)
+        if(!src)
         {
-            for(i = 0;i < HRIR_COUNT;i++)
-            {
-                for(j = 0;j < HRIR_LENGTH;j++)
-                {
-                    ALshort coeff;
-                    coeff  = fgetc(f);
-                    coeff |= fgetc(f)<<8;
-                    newdata.coeffs[i][j] = coeff;
-                }
-            }
-            for(i = 0;i < HRIR_COUNT;i++)
+            if(!GetConfigValueBool(NULL, "hrtf_resample", AL_TRUE))
+                goto incompatible;
+
+            /* Nothing matches the device rate, so resample the set with the
+             * closest rate to it. Loaded sets take precedence over the
+             * default one when equally close. */
+            src = &DefaultHrtf;
+            diff = RateDiff(DefaultHrtf.sampleRate, device->Frequency);
+            for(i = 0;i < NumLoadedHrtfs;i++)
             {
-                ALubyte delay;
-                delay = fgetc(f);
-                newdata.delays[i] = delay;
-                if(delay > maxDelay)
+                ALuint d = RateDiff(LoadedHrtfs[i].sampleRate, device->Frequency);
+                if(d < diff || (d == diff && src == &DefaultHrtf))
                 {
-                    ERR("Invalid delay[%d]: %d (%d)\n", i, delay, maxDelay);
-                    failed = AL_TRUE;
+                    src = &LoadedHrtfs[i];
+                    diff = d;
                 }
             }
-
-            if(feof(f))
-            {
-                ERR("Premature end of data\n");
-                failed = AL_TRUE;
-            }
+        }
+        if(src->sampleRate == device->Frequency)
+            irSize = minu(src->irSize, maxSize);
+        else
+        {
+            /* Keep the same span of the response at the new rate, rounded up
+             * to the next supported length. */
+            ALuint64 len = ((ALuint64)src->irSize*device->Frequency +
+                            src->sampleRate-1) / src->sampleRate;
+            irSize = MIN_HRIR_LENGTH;
+            while(irSize < len && irSize < MAX_HRIR_LENGTH)
+                irSize <<= 1;
+            irSize = minu(irSize, maxSize);
         }
 
-        fclose(f);
-        f = NULL;
+        for(i = 0;i < NumResampledHrtfs;i++)
+        {
+            if(device->Frequency == ResampledHrtfs[i]->sampleRate &&
+               irSize == ResampledHrtfs[i]->irSize)
+                return ResampledHrtfs[i];
+        }
 
-        if(!failed)
+        hrtf = ResampleHrtf(src, device->Frequency, irSize);
+        if(hrtf)
         {
-            void *temp = realloc(LoadedHrtfs, (NumLoadedHrtfs+1)*sizeof(LoadedHrtfs[0]));
-            if(temp != NULL)
+            void *temp = realloc(ResampledHrtfs, (NumResampledHrtfs+1) *
+                                                 sizeof(ResampledHrtfs[0]));
+            if(temp)
             {
-                LoadedHrtfs = temp;
-                TRACE("Loaded HRTF support for format: %s %uhz\n",
-                      DevFmtChannelsString(DevFmtStereo), newdata.sampleRate);
-                LoadedHrtfs[NumLoadedHrtfs++] = newdata;
+                ResampledHrtfs = temp;
+                ResampledHrtfs[NumResampledHrtfs++] = hrtf;
+                TRACE("Converted HRTF from %uhz, %u samples to %uhz, %u samples\n",
+                      src->sampleRate, src->irSize, device->Frequency, irSize);
+                return hrtf;
             }
+            free(hrtf);
         }
-        else
-            ERR("Failed to load %s\n", fname);
+        ERR("Failed to convert HRTF from %uhz to %uhz\n", src->sampleRate,
+            device->Frequency);
+        return NULL;
     }
-    free(fnamelist);
-    fnamelist = NULL;
+incompatible:
+    ERR("Incompatible format: %s %uhz\n",
+        DevFmtChannelsString(device->FmtChans), device->Frequency);
+    return NULL;
+}
+
+ALuint GetHrtfIrSize(const struct Hrtf *Hrtf)
+{
+    return Hrtf->irSize;
 }
 
 void FreeHrtf(void)
 {
+    ALuint i;
+
+    for(i = 0;i < NumResampledHrtfs;i++)
+        free(ResampledHrtfs[i]);
+    NumResampledHrtfs = 0;
+    free(ResampledHrtfs);
+    ResampledHrtfs = NULL;
+
     NumLoadedHrtfs = 0;
     free(LoadedHrtfs);
     LoadedHrtfs = NULL;
+
+    for(i = 0;i < NumHrtfStorages;i++)
+        ReleaseHrtfStorage(&HrtfStorages[i]);
+    NumHrtfStorages = 0;
+    free(HrtfStorages);
+    HrtfStorages = NULL;
+
+    LoadedHrtfTables = AL_FALSE;
 }
@@ -36,15 +36,45 @@
 #include "alu.h"
 #include "bs2b.h"
 
+#ifndef M_PI
+#define M_PI  3.14159265358979323846
+#endif
+
+
+static __inline ALfloat Sample_ALbyte(ALbyte val)
+{ return val * (1.0f/127.0f); }
+
+static __inline ALfloat Sample_ALshort(ALshort val)
+{ return val * (1.0f/32767.0f); }
 
-static __inline ALfloat point32(const ALfloat *vals, ALint step, ALint frac)
-{ return vals[0]; (void)step; (void)frac; }
-static __inline ALfloat lerp32(const ALfloat *vals, ALint step, ALint frac)
-{ return lerp(vals[0], vals[step], frac * (1.0f/FRACTIONONE)); }
-static __inline ALfloat cubic32(const ALfloat *vals, ALint step, ALint frac)
-{ return cubic(vals[-step], vals[0], vals[step], vals[step+step],
+static __inline ALfloat Sample_ALfloat(ALfloat val)
+{ return val; }
+
+static __inline ALfloat Sample_ALmulaw(ALmulaw val)
+{ return muLawDecompressionTable[val] * (1.0f/32767.0f); }
+
+static __inline ALfloat Sample_ALalaw(ALalaw val)
+{ return aLawDecompressionTable[val] * (1.0f/32767.0f); }
+
+#define DECL_TEMPLATE(T)                                                      \
+static __inline ALfloat point_##T(const T *vals, ALint step, ALint frac)      \
+{ return Sample_##T(vals[0]); (void)step; (void)frac; }                       \
+static __inline ALfloat lerp_##T(const T *vals, ALint step, ALint frac)       \
+{ return lerp(Sample_##T(vals[0]), Sample_##T(vals[step]),                    \
+              frac * (1.0f/FRACTIONONE)); }                                   \
+static __inline ALfloat cubic_##T(const T *vals, ALint step, ALint frac)      \
+{ return cubic(Sample_##T(vals[-step]), Sample_##T(vals[0]),                  \
+               Sample_##T(vals[step]), Sample_##T(vals[step+step]),           \
                frac * (1.0f/FRACTIONONE)); }
 
+DECL_TEMPLATE(ALbyte)
+DECL_TEMPLATE(ALshort)
+DECL_TEMPLATE(ALfloat)
+DECL_TEMPLATE(ALmulaw)
+DECL_TEMPLATE(ALalaw)
+
+#undef DECL_TEMPLATE
+
 #ifdef __GNUC__
 #define LIKELY(x) __builtin_expect(!!(x), 1)
 #define UNLIKELY(x) __builtin_expect(!!(x), 0)
@@ -57,6 +87,7 @@ static __inline ALfloat cubic32(const ALfloat *vals, ALint step, ALint frac)
 #include <arm_neon.h>
 
 static __inline void ApplyCoeffs(ALuint Offset, ALfloat (*RESTRICT Values)[2],
+                                 const ALuint IrSize,
                                  ALfloat (*RESTRICT Coeffs)[2],
                                  ALfloat left, ALfloat right)
 {
@@ -68,10 +99,10 @@ static __inline void ApplyCoeffs(ALuint Offset, ALfloat (*RESTRICT Values)[2],
         leftright2 = vset_lane_f32(right, leftright2, 1);
         leftright4 = vcombine_f32(leftright2, leftright2);
     }
-    for(c = 0;c < HRIR_LENGTH;c += 2)
+    for(c = 0;c < IrSize;c += 2)
     {
-        const ALuint o0 = (Offset+c)&HRIR_MASK;
-        const ALuint o1 = (o0+1)&HRIR_MASK;
+        const ALuint o0 = (Offset+c)&(IrSize-1);
+        const ALuint o1 = (o0+1)&(IrSize-1);
         float32x4_t vals = vcombine_f32(vld1_f32((float32_t*)&Values[o0][0]),
                                         vld1_f32((float32_t*)&Values[o1][0]));
         float32x4_t coefs = vld1q_f32((float32_t*)&Coeffs[c][0]);
@@ -86,13 +117,14 @@ static __inline void ApplyCoeffs(ALuint Offset, ALfloat (*RESTRICT Values)[2],
 #else
 
 static __inline void ApplyCoeffs(ALuint Offset, ALfloat (*RESTRICT Values)[2],
+                                 const ALuint IrSize,
                                  ALfloat (*RESTRICT Coeffs)[2],
                                  ALfloat left, ALfloat right)
 {
     ALuint c;
-    for(c = 0;c < HRIR_LENGTH;c++)
+    for(c = 0;c < IrSize;c++)
     {
-        const ALuint off = (Offset+c)&HRIR_MASK;
+        const ALuint off = (Offset+c)&(IrSize-1);
         Values[off][0] += Coeffs[c][0] * left;
         Values[off][1] += Coeffs[c][1] * right;
     }
@@ -100,382 +132,837 @@ static __inline void ApplyCoeffs(ALuint Offset, ALfloat (*RESTRICT Values)[2],
 
 #endif
 
-#define DECL_TEMPLATE(T, sampler)                                             \
-static void Mix_Hrtf_##T##_##sampler(ALsource *Source, ALCdevice *Device,     \
-  const ALvoid *srcdata, ALuint *DataPosInt, ALuint *DataPosFrac,             \
-  ALuint OutPos, ALuint SamplesToDo, ALuint BufferSize)                       \
+#if defined(__SSE__) && defined(HAVE_XMMINTRIN_H)
+#include <xmmintrin.h>
+
+static __inline void ApplyGain(ALfloat *RESTRICT Out, const ALfloat *RESTRICT data,
+                               ALfloat gain, ALuint count)
+{
+    const __m128 gain4 = _mm_set1_ps(gain);
+    ALuint i;
+    for(i = 0;i+4 <= count;i += 4)
+    {
+        __m128 out4 = _mm_loadu_ps(&Out[i]);
+        out4 = _mm_add_ps(out4, _mm_mul_ps(_mm_loadu_ps(&data[i]), gain4));
+        _mm_storeu_ps(&Out[i], out4);
+    }
+    for(;i < count;i++)
+        Out[i] += data[i]*gain;
+}
+
+static __inline void AddSamples(ALfloat *RESTRICT Out, const ALfloat *RESTRICT data,
+                                ALuint count)
+{
+    ALuint i;
+    for(i = 0;i+4 <= count;i += 4)
+        _mm_storeu_ps(&Out[i], _mm_add_ps(_mm_loadu_ps(&Out[i]),
+                                          _mm_loadu_ps(&data[i])));
+    for(;i < count;i++)
+        Out[i] += data[i];
+}
+
+#else
+
+static __inline void ApplyGain(ALfloat *RESTRICT Out, const ALfloat *RESTRICT data,
+                               ALfloat gain, ALuint count)
+{
+    ALuint i;
+    for(i = 0;i < count;i++)
+        Out[i] += data[i]*gain;
+}
+
+static __inline void AddSamples(ALfloat *RESTRICT Out, const ALfloat *RESTRICT data,
+                                ALuint count)
+{
+    ALuint i;
+    for(i = 0;i < count;i++)
+        Out[i] += data[i];
+}
+
+#endif
+
+
+/* Windowed sinc filter coefficients for the sinc resampler, one table for
+ * each cutoff scale and one row for each phase. Tap 0 applies to the sample
+ * SINC_TAPS/2-1 frames before the current position. Table 0 has its cutoff at
+ * the source's Nyquist frequency, and each following one half an octave
+ * lower, so sources stepping faster than one frame per sample are filtered
+ * below the output's Nyquist frequency instead of aliasing. The taps don't
+ * widen with the scale, so the lower cutoffs have a wider transition band. */
+#define SINC_TAPS         8
+#define SINC_PHASE_BITS   10
+#define SINC_PHASES       (1<<SINC_PHASE_BITS)
+#define SINC_FRAC_BITS    (FRACTIONBITS-SINC_PHASE_BITS)
+#define SINC_SCALES       5
+
+static ALfloat SincCoeffs[SINC_SCALES][SINC_PHASES][SINC_TAPS];
+/* The smallest increment that uses each table after the first */
+static ALuint SincScaleSteps[SINC_SCALES-1];
+
+static ALdouble SincWindowed(ALdouble x, ALdouble cutoff)
+{
+    /* Blackman window spanning all the taps */
+    ALdouble w = 0.42 + 0.5*cos(M_PI*x/(SINC_TAPS/2)) +
+                 0.08*cos(2.0*M_PI*x/(SINC_TAPS/2));
+    x *= cutoff;
+    if(fabs(x) < 1e-9)
+        return w;
+    return w * sin(M_PI*x) / (M_PI*x);
+}
+
+ALvoid aluInitResamplers(void)
+{
+    ALuint s, p, k;
+
+    for(s = 0;s < SINC_SCALES;s++)
+    {
+        ALdouble cutoff = pow(2.0, -0.5*s);
+
+        /* Switch to a table when the increment is nearer its scale than the
+         * previous one's, in octaves */
+        if(s > 0)
+            SincScaleSteps[s-1] = (ALuint)(pow(2.0, 0.5*s - 0.25)*FRACTIONONE);
+
+        for(p = 0;p < SINC_PHASES;p++)
+        {
+            /* Use the phase at the middle of the fractions that map to it */
+            ALdouble mu = (p+0.5) / SINC_PHASES;
+            ALdouble row[SINC_TAPS];
+            ALdouble sum = 0.0;
+
+            for(k = 0;k < SINC_TAPS;k++)
+            {
+                row[k] = SincWindowed((ALdouble)k - (SINC_TAPS/2-1) - mu, cutoff);
+                sum += row[k];
+            }
+            /* Normalize for unity gain at DC */
+            for(k = 0;k < SINC_TAPS;k++)
+                SincCoeffs[s][p][k] = (ALfloat)(row[k] / sum);
+        }
+    }
+}
+
+static __inline const ALfloat (*SelectSincTable(ALuint increment))[SINC_TAPS]
+{
+    ALuint s = 0;
+    while(s < SINC_SCALES-1 && increment >= SincScaleSteps[s])
+        s++;
+    return (const ALfloat(*)[SINC_TAPS])SincCoeffs[s];
+}
+
+#if defined(__SSE__) && defined(HAVE_XMMINTRIN_H)
+
+/* Builds the vectors from the converted samples directly, as writing them to
+ * memory for a vector load stalls on store forwarding. */
+#define DECL_TEMPLATE(T)                                                      \
+static __inline ALfloat sinc_##T(const ALfloat (*table)[SINC_TAPS],          \
+                                 const T *vals, ALint step, ALint frac)       \
 {                                                                             \
-    const ALuint NumChannels = Source->NumChannels;                           \
-    const T *RESTRICT data = srcdata;                                         \
-    const ALint *RESTRICT DelayStep = Source->Params.HrtfDelayStep;           \
-    ALfloat (*RESTRICT DryBuffer)[MAXCHANNELS];                               \
-    ALfloat *RESTRICT ClickRemoval, *RESTRICT PendingClicks;                  \
-    ALfloat (*RESTRICT CoeffStep)[2] = Source->Params.HrtfCoeffStep;          \
-    ALuint pos, frac;                                                         \
-    FILTER *DryFilter;                                                        \
-    ALuint BufferIdx;                                                         \
-    ALuint increment;                                                         \
-    ALuint i, out, c;                                                         \
-    ALfloat value;                                                            \
+    const ALfloat *coeffs = table[frac>>SINC_FRAC_BITS];                      \
+    __m128 v0, v1, r;                                                         \
                                                                               \
-    increment = Source->Params.Step;                                          \
+    v0 = _mm_setr_ps(Sample_##T(vals[-3*step]), Sample_##T(vals[-2*step]),    \
+                     Sample_##T(vals[-step]),   Sample_##T(vals[0]));         \
+    v1 = _mm_setr_ps(Sample_##T(vals[step]),    Sample_##T(vals[2*step]),     \
+                     Sample_##T(vals[3*step]),  Sample_##T(vals[4*step]));    \
+    r = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&coeffs[0]), v0),                  \
+                   _mm_mul_ps(_mm_loadu_ps(&coeffs[4]), v1));                 \
+    r = _mm_add_ps(r, _mm_movehl_ps(r, r));                                   \
+    r = _mm_add_ss(r, _mm_shuffle_ps(r, r, _MM_SHUFFLE(1,1,1,1)));            \
+    return _mm_cvtss_f32(r);                                                  \
+}
+
+#elif defined(__ARM_NEON__) && defined(HAVE_ARM_NEON_H)
+
+#define DECL_TEMPLATE(T)                                                      \
+static __inline ALfloat sinc_##T(const ALfloat (*table)[SINC_TAPS],          \
+                                 const T *vals, ALint step, ALint frac)       \
+{                                                                             \
+    const ALfloat *coeffs = table[frac>>SINC_FRAC_BITS];                      \
+    ALfloat in[SINC_TAPS];                                                    \
+    float32x4_t r;                                                            \
+    float32x2_t r2;                                                           \
+    ALint k;                                                                  \
                                                                               \
-    DryBuffer = Device->DryBuffer;                                            \
-    ClickRemoval = Device->ClickRemoval;                                      \
-    PendingClicks = Device->PendingClicks;                                    \
-    DryFilter = &Source->Params.iirFilter;                                    \
+    for(k = 0;k < SINC_TAPS;k++)                                              \
+        in[k] = Sample_##T(vals[(k-(SINC_TAPS/2-1))*step]);                   \
+    r = vmulq_f32(vld1q_f32(&coeffs[0]), vld1q_f32(&in[0]));                  \
+    r = vmlaq_f32(r, vld1q_f32(&coeffs[4]), vld1q_f32(&in[4]));               \
+    r2 = vadd_f32(vget_low_f32(r), vget_high_f32(r));                         \
+    r2 = vpadd_f32(r2, r2);                                                   \
+    return vget_lane_f32(r2, 0);                                              \
+}
+
+#else
+
+#define DECL_TEMPLATE(T)                                                      \
+static __inline ALfloat sinc_##T(const ALfloat (*table)[SINC_TAPS],          \
+                                 const T *vals, ALint step, ALint frac)       \
+{                                                                             \
+    const ALfloat *coeffs = table[frac>>SINC_FRAC_BITS];                      \
+    ALfloat r = 0.0f;                                                         \
+    ALint k;                                                                  \
                                                                               \
-    pos = 0;                                                                  \
-    frac = *DataPosFrac;                                                      \
+    for(k = 0;k < SINC_TAPS;k++)                                              \
+        r += coeffs[k] * Sample_##T(vals[(k-(SINC_TAPS/2-1))*step]);          \
+    return r;                                                                 \
+}
+
+#endif
+
+DECL_TEMPLATE(ALbyte)
+DECL_TEMPLATE(ALshort)
+DECL_TEMPLATE(ALfloat)
+DECL_TEMPLATE(ALmulaw)
+DECL_TEMPLATE(ALalaw)
+
+#undef DECL_TEMPLATE
+
+
+#define DECL_TEMPLATE(T, sampler)                                             \
+static void Resample_##T##_##sampler(const ALvoid *src, ALuint frac,          \
+  ALuint increment, ALuint NumChannels, ALfloat *RESTRICT OutBuffer,          \
+  ALuint BufferSize)                                                          \
+{                                                                             \
+    const T *data = src;                                                      \
+    ALuint pos = 0;                                                           \
+    ALuint i;                                                                 \
                                                                               \
-    for(i = 0;i < NumChannels;i++)                                            \
+    for(i = 0;i < BufferSize;i++)                                             \
     {                                                                         \
-        ALfloat (*RESTRICT TargetCoeffs)[2] = Source->Params.HrtfCoeffs[i];   \
-        ALuint *RESTRICT TargetDelay = Source->Params.HrtfDelay[i];           \
-        ALfloat *RESTRICT History = Source->HrtfHistory[i];                   \
-        ALfloat (*RESTRICT Values)[2] = Source->HrtfValues[i];                \
-        ALint Counter = maxu(Source->HrtfCounter, OutPos) - OutPos;           \
-        ALuint Offset = Source->HrtfOffset + OutPos;                          \
-        ALfloat Coeffs[HRIR_LENGTH][2];                                       \
-        ALuint Delay[2];                                                      \
-        ALfloat left, right;                                                  \
+        OutBuffer[i] = sampler##_##T(data + pos*NumChannels, NumChannels, frac);\
                                                                               \
-        pos = 0;                                                              \
-        frac = *DataPosFrac;                                                  \
-                                                                              \
-        for(c = 0;c < HRIR_LENGTH;c++)                                        \
-        {                                                                     \
-            Coeffs[c][0] = TargetCoeffs[c][0] - (CoeffStep[c][0]*Counter);    \
-            Coeffs[c][1] = TargetCoeffs[c][1] - (CoeffStep[c][1]*Counter);    \
-        }                                                                     \
-                                                                              \
-        Delay[0] = TargetDelay[0] - (DelayStep[0]*Counter) + 32768;           \
-        Delay[1] = TargetDelay[1] - (DelayStep[1]*Counter) + 32768;           \
-                                                                              \
-        if(LIKELY(OutPos == 0))                                               \
-        {                                                                     \
-            value = sampler(data + pos*NumChannels + i, NumChannels, frac);   \
-            value = lpFilter2PC(DryFilter, i, value);                         \
-                                                                              \
-            History[Offset&SRC_HISTORY_MASK] = value;                         \
-            left = History[(Offset-(Delay[0]>>16))&SRC_HISTORY_MASK];         \
-            right = History[(Offset-(Delay[1]>>16))&SRC_HISTORY_MASK];        \
-                                                                              \
-            ClickRemoval[FRONT_LEFT]  -= Values[(Offset+1)&HRIR_MASK][0] +    \
-                                         Coeffs[0][0] * left;                 \
-            ClickRemoval[FRONT_RIGHT] -= Values[(Offset+1)&HRIR_MASK][1] +    \
-                                         Coeffs[0][1] * right;                \
-        }                                                                     \
-        for(BufferIdx = 0;BufferIdx < BufferSize && Counter > 0;BufferIdx++)  \
-        {                                                                     \
-            value = sampler(data + pos*NumChannels + i, NumChannels, frac);   \
-            value = lpFilter2P(DryFilter, i, value);                          \
-                                                                              \
-            History[Offset&SRC_HISTORY_MASK] = value;                         \
-            left = History[(Offset-(Delay[0]>>16))&SRC_HISTORY_MASK];         \
-            right = History[(Offset-(Delay[1]>>16))&SRC_HISTORY_MASK];        \
-                                                                              \
-            Delay[0] += DelayStep[0];                                         \
-            Delay[1] += DelayStep[1];                                         \
-                                                                              \
-            Values[Offset&HRIR_MASK][0] = 0.0f;                               \
-            Values[Offset&HRIR_MASK][1] = 0.0f;                               \
-            Offset++;                                                         \
-                                                                              \
-            for(c = 0;c < HRIR_LENGTH;c++)                                    \
-            {                                                                 \
-                const ALuint off = (Offset+c)&HRIR_MASK;                      \
-                Values[off][0] += Coeffs[c][0] * left;                        \
-                Values[off][1] += Coeffs[c][1] * right;                       \
-                Coeffs[c][0] += CoeffStep[c][0];                              \
-                Coeffs[c][1] += CoeffStep[c][1];                              \
-            }                                                                 \
-                                                                              \
-            DryBuffer[OutPos][FRONT_LEFT]  += Values[Offset&HRIR_MASK][0];    \
-            DryBuffer[OutPos][FRONT_RIGHT] += Values[Offset&HRIR_MASK][1];    \
-                                                                              \
-            frac += increment;                                                \
-            pos  += frac>>FRACTIONBITS;                                       \
-            frac &= FRACTIONMASK;                                             \
-            OutPos++;                                                         \
-            Counter--;                                                        \
-        }                                                                     \
-                                                                              \
-        Delay[0] >>= 16;                                                      \
-        Delay[1] >>= 16;                                                      \
-        for(;BufferIdx < BufferSize;BufferIdx++)                              \
-        {                                                                     \
-            value = sampler(data + pos*NumChannels + i, NumChannels, frac);   \
-            value = lpFilter2P(DryFilter, i, value);                          \
-                                                                              \
-            History[Offset&SRC_HISTORY_MASK] = value;                         \
-            left = History[(Offset-Delay[0])&SRC_HISTORY_MASK];               \
-            right = History[(Offset-Delay[1])&SRC_HISTORY_MASK];              \
-                                                                              \
-            Values[Offset&HRIR_MASK][0] = 0.0f;                               \
-            Values[Offset&HRIR_MASK][1] = 0.0f;                               \
-            Offset++;                                                         \
-                                                                              \
-            ApplyCoeffs(Offset, Values, Coeffs, left, right);                 \
-            DryBuffer[OutPos][FRONT_LEFT]  += Values[Offset&HRIR_MASK][0];    \
-            DryBuffer[OutPos][FRONT_RIGHT] += Values[Offset&HRIR_MASK][1];    \
-                                                                              \
-            frac += increment;                                                \
-            pos  += frac>>FRACTIONBITS;                                       \
-            frac &= FRACTIONMASK;                                             \
-            OutPos++;                                                         \
-        }                                                                     \
-        if(LIKELY(OutPos == SamplesToDo))                                     \
-        {                                                                     \
-            value = sampler(data + pos*NumChannels + i, NumChannels, frac);   \
-            value = lpFilter2PC(DryFilter, i, value);                         \
-                                                                              \
-            History[Offset&SRC_HISTORY_MASK] = value;                         \
-            left = History[(Offset-Delay[0])&SRC_HISTORY_MASK];               \
-            right = History[(Offset-Delay[1])&SRC_HISTORY_MASK];              \
-                                                                              \
-            PendingClicks[FRONT_LEFT]  += Values[(Offset+1)&HRIR_MASK][0] +   \
-                                          Coeffs[0][0] * left;                \
-            PendingClicks[FRONT_RIGHT] += Values[(Offset+1)&HRIR_MASK][1] +   \
-                                          Coeffs[0][1] * right;               \
-        }                                                                     \
-        OutPos -= BufferSize;                                                 \
+        frac += increment;                                                    \
+        pos  += frac>>FRACTIONBITS;                                           \
+        frac &= FRACTIONMASK;                                                 \
     }                                                                         \
+}
+
+DECL_TEMPLATE(ALbyte, point)
+DECL_TEMPLATE(ALbyte, lerp)
+DECL_TEMPLATE(ALbyte, cubic)
+
+DECL_TEMPLATE(ALshort, point)
+DECL_TEMPLATE(ALshort, lerp)
+DECL_TEMPLATE(ALshort, cubic)
+
+DECL_TEMPLATE(ALfloat, point)
+DECL_TEMPLATE(ALfloat, lerp)
+DECL_TEMPLATE(ALfloat, cubic)
+
+DECL_TEMPLATE(ALmulaw, point)
+DECL_TEMPLATE(ALmulaw, lerp)
+DECL_TEMPLATE(ALmulaw, cubic)
+
+DECL_TEMPLATE(ALalaw, point)
+DECL_TEMPLATE(ALalaw, lerp)
+DECL_TEMPLATE(ALalaw, cubic)
+
+#undef DECL_TEMPLATE
+
+#define DECL_TEMPLATE(T)                                                      \
+static void Resample_##T##_sinc(const ALvoid *src, ALuint frac,               \
+  ALuint increment, ALuint NumChannels, ALfloat *RESTRICT OutBuffer,          \
+  ALuint BufferSize)                                                          \
+{                                                                             \
+    const ALfloat (*table)[SINC_TAPS] = SelectSincTable(increment);           \
+    const T *data = src;                                                      \
+    ALuint pos = 0;                                                           \
+    ALuint i;                                                                 \
                                                                               \
-    for(out = 0;out < Device->NumAuxSends;out++)                              \
+    for(i = 0;i < BufferSize;i++)                                             \
     {                                                                         \
-        ALeffectslot *Slot = Source->Params.Send[out].Slot;                   \
-        ALfloat  WetSend;                                                     \
-        ALfloat *RESTRICT WetBuffer;                                          \
-        ALfloat *RESTRICT WetClickRemoval;                                    \
-        ALfloat *RESTRICT WetPendingClicks;                                   \
-        FILTER  *WetFilter;                                                   \
-                                                                              \
-        if(Slot == NULL)                                                      \
-            continue;                                                         \
-                                                                              \
-        WetBuffer = Slot->WetBuffer;                                          \
-        WetClickRemoval = Slot->ClickRemoval;                                 \
-        WetPendingClicks = Slot->PendingClicks;                               \
-        WetFilter = &Source->Params.Send[out].iirFilter;                      \
-        WetSend = Source->Params.Send[out].WetGain;                           \
-                                                                              \
-        for(i = 0;i < NumChannels;i++)                                        \
-        {                                                                     \
-            pos = 0;                                                          \
-            frac = *DataPosFrac;                                              \
-                                                                              \
-            if(LIKELY(OutPos == 0))                                           \
-            {                                                                 \
-                value = sampler(data + pos*NumChannels + i, NumChannels,frac);\
-                value = lpFilter1PC(WetFilter, i, value);                     \
-                                                                              \
-                WetClickRemoval[0] -= value * WetSend;                        \
-            }                                                                 \
-            for(BufferIdx = 0;BufferIdx < BufferSize;BufferIdx++)             \
-            {                                                                 \
-                value = sampler(data + pos*NumChannels + i, NumChannels,frac);\
-                value = lpFilter1P(WetFilter, i, value);                      \
-                                                                              \
-                WetBuffer[OutPos] += value * WetSend;                         \
-                                                                              \
-                frac += increment;                                            \
-                pos  += frac>>FRACTIONBITS;                                   \
-                frac &= FRACTIONMASK;                                         \
-                OutPos++;                                                     \
-            }                                                                 \
-            if(LIKELY(OutPos == SamplesToDo))                                 \
-            {                                                                 \
-                value = sampler(data + pos*NumChannels + i, NumChannels,frac);\
-                value = lpFilter1PC(WetFilter, i, value);                     \
+        OutBuffer[i] = sinc_##T(table, data + pos*NumChannels, NumChannels,   \
+                                frac);                                        \
                                                                               \
-                WetPendingClicks[0] += value * WetSend;                       \
-            }                                                                 \
-            OutPos -= BufferSize;                                             \
-        }                                                                     \
+        frac += increment;                                                    \
+        pos  += frac>>FRACTIONBITS;                                           \
+        frac &= FRACTIONMASK;                                                 \
     }                                                                         \
-    *DataPosInt += pos;                                                       \
-    *DataPosFrac = frac;                                                      \
 }
 
-DECL_TEMPLATE(ALfloat, point32)
-DECL_TEMPLATE(ALfloat, lerp32)
-DECL_TEMPLATE(ALfloat, cubic32)
+DECL_TEMPLATE(ALbyte)
+DECL_TEMPLATE(ALshort)
+DECL_TEMPLATE(ALfloat)
+DECL_TEMPLATE(ALmulaw)
+DECL_TEMPLATE(ALalaw)
 
 #undef DECL_TEMPLATE
 
+#define DECL_TEMPLATE(T)                                                      \
+static ResamplerFunc SelectResampler_##T(enum Resampler Resampler)           \
+{                                                                             \
+    switch(Resampler)                                                         \
+    {                                                                         \
+        case PointResampler:                                                  \
+            return Resample_##T##_point;                                      \
+        case LinearResampler:                                                 \
+            return Resample_##T##_lerp;                                       \
+        case CubicResampler:                                                  \
+            return Resample_##T##_cubic;                                      \
+        case SincResampler:                                                   \
+            return Resample_##T##_sinc;                                       \
+        case ResamplerMax:                                                    \
+            break;                                                            \
+    }                                                                         \
+    return NULL;                                                              \
+}
+
+DECL_TEMPLATE(ALbyte)
+DECL_TEMPLATE(ALshort)
+DECL_TEMPLATE(ALfloat)
+DECL_TEMPLATE(ALmulaw)
+DECL_TEMPLATE(ALalaw)
+
+#undef DECL_TEMPLATE
 
-#define DECL_TEMPLATE(T, sampler)                                             \
-static void Mix_##T##_##sampler(ALsource *Source, ALCdevice *Device,          \
-  const ALvoid *srcdata, ALuint *DataPosInt, ALuint *DataPosFrac,             \
-  ALuint OutPos, ALuint SamplesToDo, ALuint BufferSize)                       \
+/* Selects a resampler that reads samples of the given storage type in place.
+ * IMA4 data can't be read in place, and is always decoded to the stack. */
+ResamplerFunc SelectResampler(enum Resampler Resampler, enum FmtType FmtType)
+{
+    switch(FmtType)
+    {
+        case FmtByte:
+            return SelectResampler_ALbyte(Resampler);
+        case FmtShort:
+            return SelectResampler_ALshort(Resampler);
+        case FmtFloat:
+            return SelectResampler_ALfloat(Resampler);
+        case FmtMulaw:
+            return SelectResampler_ALmulaw(Resampler);
+        case FmtAlaw:
+            return SelectResampler_ALalaw(Resampler);
+        case FmtIMA4:
+            break;
+    }
+    return NULL;
+}
+
+
+#define DECL_TEMPLATE(N)                                                      \
+ALvoid MixDirect_Hrtf##N(ALsource *Source, ALCdevice *Device,                 \
+                         const MixBus *Bus, const ALfloat *RESTRICT data,     \
+                         ALuint srcchan, ALuint OutPos, ALuint SamplesToDo,   \
+                         ALuint BufferSize)                                   \
 {                                                                             \
-    const ALuint NumChannels = Source->NumChannels;                           \
-    const T *RESTRICT data = srcdata;                                         \
-    ALfloat (*RESTRICT DryBuffer)[MAXCHANNELS];                               \
+    const ALint *RESTRICT DelayStep = Source->Params.HrtfDelayStep;           \
+    ALfloat (*RESTRICT DryBuffer)[BUFFERSIZE];                                \
     ALfloat *RESTRICT ClickRemoval, *RESTRICT PendingClicks;                  \
-    ALfloat DrySend[MAXCHANNELS];                                             \
+    ALfloat (*RESTRICT CoeffStep)[2] = Source->Hrtf->CoeffStep;               \
+    ALfloat (*RESTRICT TargetCoeffs)[2] = &Source->Hrtf->Coeffs[srcchan*N];   \
+    ALuint *RESTRICT TargetDelay = Source->Params.HrtfDelay[srcchan];         \
+    ALfloat *RESTRICT History = Source->HrtfHistory[srcchan];                 \
+    ALfloat (*RESTRICT Values)[2] = &Source->Hrtf->Values[srcchan*N];         \
+    ALint Counter = maxu(Source->HrtfCounter, OutPos) - OutPos;               \
+    ALuint Offset = Source->HrtfOffset + OutPos;                              \
+    ALfloat Coeffs[N][2];                                                     \
+    ALuint Delay[2];                                                          \
+    ALfloat left, right;                                                      \
     FILTER *DryFilter;                                                        \
-    ALuint pos, frac;                                                         \
-    ALuint BufferIdx;                                                         \
-    ALuint increment;                                                         \
-    ALuint i, out, c;                                                         \
+    ALuint pos, c;                                                            \
     ALfloat value;                                                            \
                                                                               \
-    increment = Source->Params.Step;                                          \
-                                                                              \
-    DryBuffer = Device->DryBuffer;                                            \
-    ClickRemoval = Device->ClickRemoval;                                      \
-    PendingClicks = Device->PendingClicks;                                    \
+    /* HRTF output is always stereo, so the first two dry planes are          \
+     * FRONT_LEFT and FRONT_RIGHT. */                                         \
+    (void)Device;                                                             \
+    DryBuffer = Bus->DryBuffer;                                               \
+    ClickRemoval = Bus->ClickRemoval;                                         \
+    PendingClicks = Bus->PendingClicks;                                       \
     DryFilter = &Source->Params.iirFilter;                                    \
                                                                               \
-    pos = 0;                                                                  \
-    frac = *DataPosFrac;                                                      \
+    for(c = 0;c < N;c++)                                                      \
+    {                                                                         \
+        Coeffs[c][0] = TargetCoeffs[c][0] - (CoeffStep[c][0]*Counter);        \
+        Coeffs[c][1] = TargetCoeffs[c][1] - (CoeffStep[c][1]*Counter);        \
+    }                                                                         \
+                                                                              \
+    Delay[0] = TargetDelay[0] - (DelayStep[0]*Counter) + 32768;               \
+    Delay[1] = TargetDelay[1] - (DelayStep[1]*Counter) + 32768;               \
                                                                               \
-    for(i = 0;i < NumChannels;i++)                                            \
+    if(LIKELY(OutPos == 0))                                                   \
     {                                                                         \
-        for(c = 0;c < MAXCHANNELS;c++)                                        \
-            DrySend[c] = Source->Params.DryGains[i][c];                       \
+        value = lpFilter2PC(DryFilter, srcchan, data[0]);                     \
                                                                               \
-        pos = 0;                                                              \
-        frac = *DataPosFrac;                                                  \
+        History[Offset&SRC_HISTORY_MASK] = value;                             \
+        left = History[(Offset-(Delay[0]>>16))&SRC_HISTORY_MASK];             \
+        right = History[(Offset-(Delay[1]>>16))&SRC_HISTORY_MASK];            \
                                                                               \
-        if(OutPos == 0)                                                       \
-        {                                                                     \
-            value = sampler(data + pos*NumChannels + i, NumChannels, frac);   \
+        ClickRemoval[FRONT_LEFT]  -= Values[(Offset+1)&(N-1)][0] +            \
+                                     Coeffs[0][0] * left;                     \
+        ClickRemoval[FRONT_RIGHT] -= Values[(Offset+1)&(N-1)][1] +            \
+                                     Coeffs[0][1] * right;                    \
+    }                                                                         \
+    for(pos = 0;pos < BufferSize && Counter > 0;pos++)                        \
+    {                                                                         \
+        value = lpFilter2P(DryFilter, srcchan, data[pos]);                    \
                                                                               \
-            value = lpFilter2PC(DryFilter, i, value);                         \
-            for(c = 0;c < MAXCHANNELS;c++)                                    \
-                ClickRemoval[c] -= value*DrySend[c];                          \
-        }                                                                     \
-        for(BufferIdx = 0;BufferIdx < BufferSize;BufferIdx++)                 \
-        {                                                                     \
-            value = sampler(data + pos*NumChannels + i, NumChannels, frac);   \
+        History[Offset&SRC_HISTORY_MASK] = value;                             \
+        left = History[(Offset-(Delay[0]>>16))&SRC_HISTORY_MASK];             \
+        right = History[(Offset-(Delay[1]>>16))&SRC_HISTORY_MASK];            \
                                                                               \
-            value = lpFilter2P(DryFilter, i, value);                          \
-            for(c = 0;c < MAXCHANNELS;c++)                                    \
-                DryBuffer[OutPos][c] += value*DrySend[c];                     \
+        Delay[0] += DelayStep[0];                                             \
+        Delay[1] += DelayStep[1];                                             \
                                                                               \
-            frac += increment;                                                \
-            pos  += frac>>FRACTIONBITS;                                       \
-            frac &= FRACTIONMASK;                                             \
-            OutPos++;                                                         \
-        }                                                                     \
-        if(OutPos == SamplesToDo)                                             \
-        {                                                                     \
-            value = sampler(data + pos*NumChannels + i, NumChannels, frac);   \
+        Values[Offset&(N-1)][0] = 0.0f;                                       \
+        Values[Offset&(N-1)][1] = 0.0f;                                       \
+        Offset++;                                                             \
                                                                               \
-            value = lpFilter2PC(DryFilter, i, value);                         \
-            for(c = 0;c < MAXCHANNELS;c++)                                    \
-                PendingClicks[c] += value*DrySend[c];                         \
+        for(c = 0;c < N;c++)                                                  \
+        {                                                                     \
+            const ALuint off = (Offset+c)&(N-1);                              \
+            Values[off][0] += Coeffs[c][0] * left;                            \
+            Values[off][1] += Coeffs[c][1] * right;                           \
+            Coeffs[c][0] += CoeffStep[c][0];                                  \
+            Coeffs[c][1] += CoeffStep[c][1];                                  \
         }                                                                     \
-        OutPos -= BufferSize;                                                 \
-    }                                                                         \
                                                                               \
-    for(out = 0;out < Device->NumAuxSends;out++)                              \
-    {                                                                         \
-        ALeffectslot *Slot = Source->Params.Send[out].Slot;                   \
-        ALfloat  WetSend;                                                     \
-        ALfloat *WetBuffer;                                                   \
-        ALfloat *WetClickRemoval;                                             \
-        ALfloat *WetPendingClicks;                                            \
-        FILTER  *WetFilter;                                                   \
+        DryBuffer[FRONT_LEFT][OutPos]  += Values[Offset&(N-1)][0];            \
+        DryBuffer[FRONT_RIGHT][OutPos] += Values[Offset&(N-1)][1];            \
                                                                               \
-        if(Slot == NULL)                                                      \
-            continue;                                                         \
+        OutPos++;                                                             \
+        Counter--;                                                            \
+    }                                                                         \
                                                                               \
-        WetBuffer = Slot->WetBuffer;                                          \
-        WetClickRemoval = Slot->ClickRemoval;                                 \
-        WetPendingClicks = Slot->PendingClicks;                               \
-        WetFilter = &Source->Params.Send[out].iirFilter;                      \
-        WetSend = Source->Params.Send[out].WetGain;                           \
+    Delay[0] >>= 16;                                                          \
+    Delay[1] >>= 16;                                                          \
+    for(;pos < BufferSize;pos++)                                              \
+    {                                                                         \
+        value = lpFilter2P(DryFilter, srcchan, data[pos]);                    \
                                                                               \
-        for(i = 0;i < NumChannels;i++)                                        \
-        {                                                                     \
-            pos = 0;                                                          \
-            frac = *DataPosFrac;                                              \
+        History[Offset&SRC_HISTORY_MASK] = value;                             \
+        left = History[(Offset-Delay[0])&SRC_HISTORY_MASK];                   \
+        right = History[(Offset-Delay[1])&SRC_HISTORY_MASK];                  \
                                                                               \
-            if(OutPos == 0)                                                   \
-            {                                                                 \
-                value = sampler(data + pos*NumChannels + i, NumChannels,frac);\
+        Values[Offset&(N-1)][0] = 0.0f;                                       \
+        Values[Offset&(N-1)][1] = 0.0f;                                       \
+        Offset++;                                                             \
                                                                               \
-                value = lpFilter1PC(WetFilter, i, value);                     \
-                WetClickRemoval[0] -= value * WetSend;                        \
-            }                                                                 \
-            for(BufferIdx = 0;BufferIdx < BufferSize;BufferIdx++)             \
-            {                                                                 \
-                value = sampler(data + pos*NumChannels + i, NumChannels,frac);\
+        ApplyCoeffs(Offset, Values, N, Coeffs, left, right);                  \
+        DryBuffer[FRONT_LEFT][OutPos]  += Values[Offset&(N-1)][0];            \
+        DryBuffer[FRONT_RIGHT][OutPos] += Values[Offset&(N-1)][1];            \
                                                                               \
-                value = lpFilter1P(WetFilter, i, value);                      \
-                WetBuffer[OutPos] += value * WetSend;                         \
+        OutPos++;                                                             \
+    }                                                                         \
+    if(LIKELY(OutPos == SamplesToDo))                                         \
+    {                                                                         \
+        value = lpFilter2PC(DryFilter, srcchan, data[pos]);                   \
                                                                               \
-                frac += increment;                                            \
-                pos  += frac>>FRACTIONBITS;                                   \
-                frac &= FRACTIONMASK;                                         \
-                OutPos++;                                                     \
-            }                                                                 \
-            if(OutPos == SamplesToDo)                                         \
-            {                                                                 \
-                value = sampler(data + pos*NumChannels + i, NumChannels,frac);\
+        History[Offset&SRC_HISTORY_MASK] = value;                             \
+        left = History[(Offset-Delay[0])&SRC_HISTORY_MASK];                   \
+        right = History[(Offset-Delay[1])&SRC_HISTORY_MASK];                  \
                                                                               \
-                value = lpFilter1PC(WetFilter, i, value);                     \
-                WetPendingClicks[0] += value * WetSend;                       \
-            }                                                                 \
-            OutPos -= BufferSize;                                             \
-        }                                                                     \
+        PendingClicks[FRONT_LEFT]  += Values[(Offset+1)&(N-1)][0] +           \
+                                      Coeffs[0][0] * left;                    \
+        PendingClicks[FRONT_RIGHT] += Values[(Offset+1)&(N-1)][1] +           \
+                                      Coeffs[0][1] * right;                   \
     }                                                                         \
-    *DataPosInt += pos;                                                       \
-    *DataPosFrac = frac;                                                      \
 }
 
-DECL_TEMPLATE(ALfloat, point32)
-DECL_TEMPLATE(ALfloat, lerp32)
-DECL_TEMPLATE(ALfloat, cubic32)
+DECL_TEMPLATE(8)
+DECL_TEMPLATE(16)
+DECL_TEMPLATE(32)
+DECL_TEMPLATE(64)
 
 #undef DECL_TEMPLATE
 
 
-MixerFunc SelectMixer(enum Resampler Resampler)
+/* Filters a block of two real signals, packed as the real and imaginary parts
+ * of a transformed buffer, with a filter prepared by SetHrtfFftFilter. Each
+ * bin depends on its mirror, so they're done in pairs to work in place. */
+static __inline void FilterHrtfBlock(ALcomplex *RESTRICT Block,
+                                     const ALcomplex *RESTRICT Filter,
+                                     ALuint FftSize)
 {
-    switch(Resampler)
+    const ALcomplex *RESTRICT Sum = Filter;
+    const ALcomplex *RESTRICT Diff = Filter+FftSize;
+    ALuint i;
+
+    for(i = 0;i <= FftSize/2;i++)
     {
-        case PointResampler:
-            return Mix_ALfloat_point32;
-        case LinearResampler:
-            return Mix_ALfloat_lerp32;
-        case CubicResampler:
-            return Mix_ALfloat_cubic32;
-        case ResamplerMax:
-            break;
+        const ALuint j = (FftSize-i) & (FftSize-1);
+        const ALcomplex z = Block[i], zc = Block[j];
+
+        Block[i].Real = z.Real*Sum[i].Real - z.Imag*Sum[i].Imag +
+                        zc.Real*Diff[i].Real + zc.Imag*Diff[i].Imag;
+        Block[i].Imag = z.Real*Sum[i].Imag + z.Imag*Sum[i].Real +
+                        zc.Real*Diff[i].Imag - zc.Imag*Diff[i].Real;
+
+        Block[j].Real = zc.Real*Sum[j].Real - zc.Imag*Sum[j].Imag +
+                        z.Real*Diff[j].Real + z.Imag*Diff[j].Imag;
+        Block[j].Imag = zc.Real*Sum[j].Imag + zc.Imag*Sum[j].Real +
+                        z.Real*Diff[j].Imag - z.Imag*Diff[j].Real;
     }
-    return NULL;
 }
 
-MixerFunc SelectHrtfMixer(enum Resampler Resampler)
+/* Mixes a source channel through the HRTF using FFT overlap-add convolution.
+ * The ear delays are applied to the input before it's transformed, and while
+ * the filter changes the input is split between the old and new filters
+ * instead of stepping coefficients. */
+ALvoid MixDirect_HrtfFft(ALsource *Source, ALCdevice *Device, const MixBus *Bus,
+  const ALfloat *RESTRICT data, ALuint srcchan,
+  ALuint OutPos, ALuint SamplesToDo, ALuint BufferSize)
 {
-    switch(Resampler)
+    HrtfFftState *State = Source->HrtfFft;
+    const ALuint FftSize = State->FftSize;
+    const ALuint TailSize = State->IrSize-1;
+    const ALuint BlockSize = FftSize-TailSize;
+    const ALcomplex *RESTRICT Filter = &State->Filters[srcchan*4*FftSize];
+    const ALcomplex *RESTRICT OldFilter = Filter + 2*FftSize;
+    const ALuint *Delay = State->Delay[srcchan];
+    const ALuint *OldDelay = State->OldDelay[srcchan];
+    ALfloat (*RESTRICT CoeffStep)[2] = Source->Hrtf->CoeffStep;
+    ALfloat (*RESTRICT TargetCoeffs)[2] = &Source->Hrtf->Coeffs[srcchan*State->IrSize];
+    ALfloat *RESTRICT History = Source->HrtfHistory[srcchan];
+    ALfloat *RESTRICT Tail[2];
+    ALint Counter = minu(maxu(Source->HrtfCounter, OutPos) - OutPos,
+                         State->FadeLength);
+    ALfloat FadeScale = (State->FadeLength ? 1.0f/State->FadeLength : 0.0f);
+    ALuint Offset = Source->HrtfOffset + OutPos;
+    ALfloat Input[SRC_HISTORY_LENGTH+BUFFERSIZE+1];
+    ALcomplex Block[MAX_FFT_SIZE];
+    ALcomplex OldBlock[MAX_FFT_SIZE];
+    ALfloat (*RESTRICT DryBuffer)[BUFFERSIZE];
+    ALfloat *RESTRICT ClickRemoval, *RESTRICT PendingClicks;
+    ALfloat *RESTRICT Delayed;
+    const ALfloat *Src[2], *OldSrc[2];
+    FILTER *DryFilter;
+    ALuint pos, todo, i;
+    ALfloat left, right;
+    ALfloat mu;
+
+    (void)Device;
+    DryBuffer = Bus->DryBuffer;
+    ClickRemoval = Bus->ClickRemoval;
+    PendingClicks = Bus->PendingClicks;
+    DryFilter = &Source->Params.iirFilter;
+    Tail[0] = &State->Tails[(srcchan*2 + 0)*TailSize];
+    Tail[1] = &State->Tails[(srcchan*2 + 1)*TailSize];
+
+    /* Line up the filtered input after the previous samples, so the delayed
+     * input for each ear can be read straight from it. */
+    for(i = 0;i < SRC_HISTORY_LENGTH;i++)
+        Input[i] = History[(Offset-SRC_HISTORY_LENGTH+i)&SRC_HISTORY_MASK];
+    Delayed = &Input[SRC_HISTORY_LENGTH];
+    for(pos = 0;pos < BufferSize;pos++)
+        Delayed[pos] = lpFilter2P(DryFilter, srcchan, data[pos]);
+    for(i = 0;i < SRC_HISTORY_LENGTH;i++)
+        History[(Offset+BufferSize-SRC_HISTORY_LENGTH+i)&SRC_HISTORY_MASK] =
+            Input[BufferSize+i];
+    Src[0] = Delayed - Delay[0];
+    Src[1] = Delayed - Delay[1];
+    OldSrc[0] = Delayed - OldDelay[0];
+    OldSrc[1] = Delayed - OldDelay[1];
+
+    if(LIKELY(OutPos == 0))
     {
-        case PointResampler:
-            return Mix_Hrtf_ALfloat_point32;
-        case LinearResampler:
-            return Mix_Hrtf_ALfloat_lerp32;
-        case CubicResampler:
-            return Mix_Hrtf_ALfloat_cubic32;
-        case ResamplerMax:
-            break;
+        left = Src[0][0];
+        right = Src[1][0];
+
+        ClickRemoval[FRONT_LEFT]  -= Tail[0][0] + left *
+            (TargetCoeffs[0][0] - CoeffStep[0][0]*Counter);
+        ClickRemoval[FRONT_RIGHT] -= Tail[1][0] + right *
+            (TargetCoeffs[0][1] - CoeffStep[0][1]*Counter);
+    }
+
+    for(pos = 0;pos < BufferSize;pos += todo)
+    {
+        todo = minu(BufferSize-pos, BlockSize);
+
+        if((ALint)pos < Counter)
+        {
+            for(i = 0;i < todo;i++)
+            {
+                mu = maxi(Counter-(ALint)(pos+i), 0) * FadeScale;
+                Block[i].Real = Src[0][pos+i] * (1.0f-mu);
+                Block[i].Imag = Src[1][pos+i] * (1.0f-mu);
+                OldBlock[i].Real = OldSrc[0][pos+i] * mu;
+                OldBlock[i].Imag = OldSrc[1][pos+i] * mu;
+            }
+            for(;i < FftSize;i++)
+            {
+                OldBlock[i].Real = OldBlock[i].Imag = 0.0f;
+                Block[i].Real = Block[i].Imag = 0.0f;
+            }
+
+            aluFFT(OldBlock, FftSize, AL_FALSE);
+            FilterHrtfBlock(OldBlock, OldFilter, FftSize);
+            aluFFT(Block, FftSize, AL_FALSE);
+            FilterHrtfBlock(Block, Filter, FftSize);
+            for(i = 0;i < FftSize;i++)
+            {
+                Block[i].Real += OldBlock[i].Real;
+                Block[i].Imag += OldBlock[i].Imag;
+            }
+        }
+        else
+        {
+            for(i = 0;i < todo;i++)
+            {
+                Block[i].Real = Src[0][pos+i];
+                Block[i].Imag = Src[1][pos+i];
+            }
+            for(;i < FftSize;i++)
+                Block[i].Real = Block[i].Imag = 0.0f;
+
+            aluFFT(Block, FftSize, AL_FALSE);
+            FilterHrtfBlock(Block, Filter, FftSize);
+        }
+        aluFFT(Block, FftSize, AL_TRUE);
+
+        /* Add the previous blocks' tail to the start of this one, and carry
+         * over what extends past it. */
+        for(i = 0;i < todo;i++)
+        {
+            left = Block[i].Real;
+            right = Block[i].Imag;
+            if(i < TailSize)
+            {
+                left += Tail[0][i];
+                right += Tail[1][i];
+            }
+            DryBuffer[FRONT_LEFT][OutPos+pos+i]  += left;
+            DryBuffer[FRONT_RIGHT][OutPos+pos+i] += right;
+        }
+        for(i = 0;i < TailSize;i++)
+        {
+            left = Block[todo+i].Real;
+            right = Block[todo+i].Imag;
+            if(todo+i < TailSize)
+            {
+                left += Tail[0][todo+i];
+                right += Tail[1][todo+i];
+            }
+            Tail[0][i] = left;
+            Tail[1][i] = right;
+        }
+    }
+
+    if(LIKELY(OutPos+BufferSize == SamplesToDo))
+    {
+        Delayed[BufferSize] = lpFilter2PC(DryFilter, srcchan, data[BufferSize]);
+        left = Src[0][BufferSize];
+        right = Src[1][BufferSize];
+
+        Counter = maxi(Counter-(ALint)BufferSize, 0);
+        PendingClicks[FRONT_LEFT]  += Tail[0][0] + left *
+            (TargetCoeffs[0][0] - CoeffStep[0][0]*Counter);
+        PendingClicks[FRONT_RIGHT] += Tail[1][0] + right *
+            (TargetCoeffs[0][1] - CoeffStep[0][1]*Counter);
     }
-    return NULL;
 }
 
+/* Filters a source channel and adds it to NumPlanes dry planes, starting at
+ * FirstPlane, with the given gains */
+static void MixDryPlanes(ALsource *Source, const MixBus *Bus,
+  const ALfloat *RESTRICT data, ALuint srcchan,
+  ALuint OutPos, ALuint SamplesToDo, ALuint BufferSize,
+  ALuint FirstPlane, const ALfloat *DrySend, ALuint NumPlanes)
+{
+    ALfloat (*RESTRICT DryBuffer)[BUFFERSIZE];
+    ALfloat *RESTRICT ClickRemoval, *RESTRICT PendingClicks;
+    ALfloat FilteredData[BUFFERSIZE];
+    FILTER *DryFilter;
+    ALuint pos, c;
+    ALfloat value;
+
+    DryBuffer = Bus->DryBuffer + FirstPlane;
+    ClickRemoval = Bus->ClickRemoval + FirstPlane;
+    PendingClicks = Bus->PendingClicks + FirstPlane;
+    DryFilter = &Source->Params.iirFilter;
+
+    if(OutPos == 0)
+    {
+        value = lpFilter2PC(DryFilter, srcchan, data[0]);
+        for(c = 0;c < NumPlanes;c++)
+            ClickRemoval[c] -= value*DrySend[c];
+    }
+    for(pos = 0;pos < BufferSize;pos++)
+        FilteredData[pos] = lpFilter2P(DryFilter, srcchan, data[pos]);
+    for(c = 0;c < NumPlanes;c++)
+        ApplyGain(&DryBuffer[c][OutPos], FilteredData, DrySend[c], BufferSize);
+    if(OutPos+BufferSize == SamplesToDo)
+    {
+        value = lpFilter2PC(DryFilter, srcchan, data[pos]);
+        for(c = 0;c < NumPlanes;c++)
+            PendingClicks[c] += value*DrySend[c];
+    }
+}
 
-static __inline ALfloat Sample_ALbyte(ALbyte val)
-{ return val * (1.0f/127.0f); }
+ALvoid MixDirect(ALsource *Source, ALCdevice *Device, const MixBus *Bus,
+  const ALfloat *RESTRICT data, ALuint srcchan,
+  ALuint OutPos, ALuint SamplesToDo, ALuint BufferSize)
+{
+    const enum Channel *ChanMap = Device->DevChannels;
+    const ALuint NumDryChans = ChannelsFromDevFmt(Device->FmtChans);
+    ALfloat DrySend[MAXCHANNELS];
+    ALuint c;
 
-static __inline ALfloat Sample_ALshort(ALshort val)
-{ return val * (1.0f/32767.0f); }
+    for(c = 0;c < NumDryChans;c++)
+        DrySend[c] = Source->Params.DryGains[srcchan][ChanMap[c]];
+
+    MixDryPlanes(Source, Bus, data, srcchan, OutPos, SamplesToDo, BufferSize,
+                 0, DrySend, NumDryChans);
+}
+
+/* Pans a source channel into the device's HRTF bed, which follows the output
+ * channels in the dry planes */
+ALvoid MixDirect_HrtfBed(ALsource *Source, ALCdevice *Device, const MixBus *Bus,
+  const ALfloat *RESTRICT data, ALuint srcchan,
+  ALuint OutPos, ALuint SamplesToDo, ALuint BufferSize)
+{
+    MixDryPlanes(Source, Bus, data, srcchan, OutPos, SamplesToDo, BufferSize,
+                 ChannelsFromDevFmt(Device->FmtChans),
+                 Source->Params.HrtfBedGains[srcchan], HRTF_BED_CHANNELS);
+}
+
+
+ALvoid MixSend(ALsource *Source, ALuint sendidx, const MixBus *Bus,
+  const ALfloat *RESTRICT data, ALuint srcchan,
+  ALuint OutPos, ALuint SamplesToDo, ALuint BufferSize)
+{
+    ALeffectslot *Slot = Source->Params.Send[sendidx].Slot;
+    ALfloat  WetSend;
+    ALfloat *RESTRICT WetBuffer;
+    ALfloat *RESTRICT WetClickRemoval;
+    ALfloat *RESTRICT WetPendingClicks;
+    ALfloat FilteredData[BUFFERSIZE];
+    FILTER  *WetFilter;
+    ALuint pos;
+    ALfloat value;
+
+    if(!Bus->WetBuffer)
+    {
+        WetBuffer = Slot->WetBuffer;
+        WetClickRemoval = Slot->ClickRemoval;
+        WetPendingClicks = Slot->PendingClicks;
+    }
+    else
+    {
+        WetBuffer = Bus->WetBuffer;
+        WetClickRemoval = Bus->WetClickRemoval;
+        WetPendingClicks = Bus->WetPendingClicks;
+    }
+    WetFilter = &Source->Params.Send[sendidx].iirFilter;
+    WetSend = Source->Params.Send[sendidx].WetGain;
+
+    if(OutPos == 0)
+    {
+        value = lpFilter1PC(WetFilter, srcchan, data[0]);
+        WetClickRemoval[0] -= value * WetSend;
+    }
+    for(pos = 0;pos < BufferSize;pos++)
+        FilteredData[pos] = lpFilter1P(WetFilter, srcchan, data[pos]);
+    ApplyGain(&WetBuffer[OutPos], FilteredData, WetSend, BufferSize);
+    if(OutPos+BufferSize == SamplesToDo)
+    {
+        value = lpFilter1PC(WetFilter, srcchan, data[pos]);
+        WetPendingClicks[0] += value * WetSend;
+    }
+}
+
+
+/* Moves what the last mixer call added to a logging bus into its log, and
+ * clears the bus for the next call. Each mixer call adds at most once to each
+ * sample and click accumulator, so adding the logged values back in the same
+ * order gives the same result as mixing directly. */
+static void LogMixCall(const MixBus *Bus, ALeffectslot *Slot, ALuint OutPos,
+                       ALuint Count)
+{
+    MixLog *Log = Bus->Log;
+    const ALuint NumPlanes = (Slot ? 1 : Log->NumPlanes);
+    const ALuint Size = NumPlanes * (Count+2);
+    ALfloat *RESTRICT Data = NULL;
+    ALuint c;
+
+    if(Log->NumRecords == Log->MaxRecords)
+    {
+        ALuint newmax = (Log->MaxRecords ? Log->MaxRecords*2 : 64);
+        void *temp = realloc(Log->Records, newmax*sizeof(*Log->Records));
+        if(temp)
+        {
+            Log->Records = temp;
+            Log->MaxRecords = newmax;
+        }
+    }
+    if(Log->DataSize+Size > Log->MaxData)
+    {
+        ALuint newmax = maxu(Log->MaxData*2, Log->DataSize+Size);
+        void *temp = realloc(Log->Data, newmax*sizeof(*Log->Data));
+        if(temp)
+        {
+            Log->Data = temp;
+            Log->MaxData = newmax;
+        }
+    }
+    if(Log->NumRecords < Log->MaxRecords && Log->DataSize+Size <= Log->MaxData)
+    {
+        MixRecord *Record = &Log->Records[Log->NumRecords++];
+        Record->Slot = Slot;
+        Record->OutPos = OutPos;
+        Record->Count = Count;
+        Record->Data = Log->DataSize;
+        Data = &Log->Data[Log->DataSize];
+        Log->DataSize += Size;
+    }
+    else
+        Log->Failed = AL_TRUE;
+
+    if(Slot)
+    {
+        if(Data)
+        {
+            memcpy(Data, &Bus->WetBuffer[OutPos], Count*sizeof(ALfloat));
+            Data[Count] = Bus->WetClickRemoval[0];
+            Data[Count+1] = Bus->WetPendingClicks[0];
+        }
+        memset(&Bus->WetBuffer[OutPos], 0, Count*sizeof(ALfloat));
+        Bus->WetClickRemoval[0] = 0.0f;
+        Bus->WetPendingClicks[0] = 0.0f;
+        return;
+    }
+
+    for(c = 0;c < NumPlanes;c++)
+    {
+        if(Data)
+        {
+            memcpy(&Data[c*Count], &Bus->DryBuffer[c][OutPos], Count*sizeof(ALfloat));
+            Data[NumPlanes*Count + c] = Bus->ClickRemoval[c];
+            Data[NumPlanes*(Count+1) + c] = Bus->PendingClicks[c];
+        }
+        memset(&Bus->DryBuffer[c][OutPos], 0, Count*sizeof(ALfloat));
+        Bus->ClickRemoval[c] = 0.0f;
+        Bus->PendingClicks[c] = 0.0f;
+    }
+}
+
+ALvoid ReplayMixLog(ALCdevice *Device, const MixLog *Log, ALuint First,
+                    ALuint Last)
+{
+    ALuint r, c;
+
+    for(r = First;r < Last;r++)
+    {
+        const MixRecord *Record = &Log->Records[r];
+        const ALfloat *Data = &Log->Data[Record->Data];
+        const ALuint Count = Record->Count;
+        ALeffectslot *Slot = Record->Slot;
+
+        if(Slot)
+        {
+            AddSamples(&Slot->WetBuffer[Record->OutPos], Data, Count);
+            Slot->ClickRemoval[0] += Data[Count];
+            Slot->PendingClicks[0] += Data[Count+1];
+            continue;
+        }
+        for(c = 0;c < Log->NumPlanes;c++)
+        {
+            AddSamples(&Device->DryBuffer[c][Record->OutPos], &Data[c*Count], Count);
+            Device->ClickRemoval[c] += Data[Log->NumPlanes*Count + c];
+            Device->PendingClicks[c] += Data[Log->NumPlanes*(Count+1) + c];
+        }
+    }
+}
 
-static __inline ALfloat Sample_ALfloat(ALfloat val)
-{ return val; }
 
 #define DECL_TEMPLATE(T)                                                      \
 static void Load_##T(ALfloat *dst, const T *src, ALuint samples)              \
@@ -488,21 +975,62 @@ static void Load_##T(ALfloat *dst, const T *src, ALuint samples)              \
 DECL_TEMPLATE(ALbyte)
 DECL_TEMPLATE(ALshort)
 DECL_TEMPLATE(ALfloat)
+DECL_TEMPLATE(ALmulaw)
+DECL_TEMPLATE(ALalaw)
 
 #undef DECL_TEMPLATE
 
-static void LoadStack(ALfloat *dst, const ALvoid *src, enum FmtType srctype, ALuint samples)
+/* Decodes sample frames starting at pos, a block at a time. Each block decodes
+ * on its own, so seeking only needs to find the block holding pos. */
+static void Load_ALima4(ALfloat *dst, const ALima4 *src, ALuint NumChannels,
+                        ALuint pos, ALuint frames)
+{
+    ALshort tmp[IMA4_BLOCK_LENGTH*MAXCHANNELS];
+    ALuint skip = pos%IMA4_BLOCK_LENGTH;
+    ALuint todo, i;
+
+    src += pos/IMA4_BLOCK_LENGTH * IMA4_BLOCK_SIZE*NumChannels;
+    while(frames > 0)
+    {
+        DecodeIMA4Block(tmp, src, NumChannels);
+        src += IMA4_BLOCK_SIZE*NumChannels;
+
+        todo = minu(frames, IMA4_BLOCK_LENGTH-skip);
+        for(i = 0;i < todo*NumChannels;i++)
+            dst[i] = Sample_ALshort(tmp[skip*NumChannels + i]);
+        dst += todo*NumChannels;
+        frames -= todo;
+        skip = 0;
+    }
+}
+
+/* Converts sample frames from the buffer's storage, starting at pos, into the
+ * stack */
+static void LoadStack(ALfloat *dst, const ALbuffer *ALBuffer, ALuint NumChannels,
+                      ALuint pos, ALuint frames)
 {
-    switch(srctype)
+    const ALuint offset = pos*NumChannels;
+    const ALuint samples = frames*NumChannels;
+
+    switch(ALBuffer->FmtType)
     {
         case FmtByte:
-            Load_ALbyte(dst, src, samples);
+            Load_ALbyte(dst, (const ALbyte*)ALBuffer->data + offset, samples);
             break;
         case FmtShort:
-            Load_ALshort(dst, src, samples);
+            Load_ALshort(dst, (const ALshort*)ALBuffer->data + offset, samples);
             break;
         case FmtFloat:
-            Load_ALfloat(dst, src, samples);
+            Load_ALfloat(dst, (const ALfloat*)ALBuffer->data + offset, samples);
+            break;
+        case FmtMulaw:
+            Load_ALmulaw(dst, (const ALmulaw*)ALBuffer->data + offset, samples);
+            break;
+        case FmtAlaw:
+            Load_ALalaw(dst, (const ALalaw*)ALBuffer->data + offset, samples);
+            break;
+        case FmtIMA4:
+            Load_ALima4(dst, ALBuffer->data, NumChannels, pos, frames);
             break;
     }
 }
@@ -515,7 +1043,268 @@ static void SilenceStack(ALfloat *dst, ALuint samples)
 }
 
 
-ALvoid MixSource(ALsource *Source, ALCdevice *Device, ALuint SamplesToDo)
+/* Fills the stack buffer with converted samples from the source's queue,
+ * including the resampler padding, wrapping at loop points and going across
+ * queue seams as needed. Returns the number of sample frames written. */
+static ALuint LoadSourceData(const ALsource *Source,
+  const ALbufferlistitem *BufferListItem, ALuint DataPosInt, ALboolean Looping,
+  ALuint BufferSize, ALfloat *SrcData)
+{
+    const ALuint BufferPrePadding = ResamplerPrePadding[Source->Resampler];
+    const ALuint NumChannels = Source->NumChannels;
+    ALuint SrcDataSize = 0;
+
+    if(Source->lSourceType == AL_STATIC)
+    {
+        const ALbuffer *ALBuffer = Source->queue->buffer;
+        ALuint DataSize;
+        ALuint pos;
+
+        /* If current pos is beyond the loop range, do not loop */
+        if(Looping == AL_FALSE || DataPosInt >= (ALuint)ALBuffer->LoopEnd)
+        {
+            Looping = AL_FALSE;
+
+            if(DataPosInt >= BufferPrePadding)
+                pos = DataPosInt - BufferPrePadding;
+            else
+            {
+                DataSize = BufferPrePadding - DataPosInt;
+                DataSize = minu(BufferSize, DataSize);
+
+                SilenceStack(&SrcData[SrcDataSize*NumChannels],
+                             DataSize*NumChannels);
+                SrcDataSize += DataSize;
+                BufferSize -= DataSize;
+
+                pos = 0;
+            }
+
+            /* Copy what's left to play in the source buffer, and clear the
+             * rest of the temp buffer */
+            DataSize = ALBuffer->SampleLen - pos;
+            DataSize = minu(BufferSize, DataSize);
+
+            LoadStack(&SrcData[SrcDataSize*NumChannels], ALBuffer, NumChannels,
+                      pos, DataSize);
+            SrcDataSize += DataSize;
+            BufferSize -= DataSize;
+
+            SilenceStack(&SrcData[SrcDataSize*NumChannels],
+                         BufferSize*NumChannels);
+            SrcDataSize += BufferSize;
+            BufferSize -= BufferSize;
+        }
+        else
+        {
+            ALuint LoopStart = ALBuffer->LoopStart;
+            ALuint LoopEnd   = ALBuffer->LoopEnd;
+
+            if(DataPosInt >= LoopStart)
+            {
+                pos = DataPosInt-LoopStart;
+                while(pos < BufferPrePadding)
+                    pos += LoopEnd-LoopStart;
+                pos -= BufferPrePadding;
+                pos += LoopStart;
+            }
+            else if(DataPosInt >= BufferPrePadding)
+                pos = DataPosInt - BufferPrePadding;
+            else
+            {
+                DataSize = BufferPrePadding - DataPosInt;
+                DataSize = minu(BufferSize, DataSize);
+
+                SilenceStack(&SrcData[SrcDataSize*NumChannels], DataSize*NumChannels);
+                SrcDataSize += DataSize;
+                BufferSize -= DataSize;
+
+                pos = 0;
+            }
+
+            /* Copy what's left of this loop iteration, then copy repeats
+             * of the loop section */
+            DataSize = LoopEnd - pos;
+            DataSize = minu(BufferSize, DataSize);
+
+            LoadStack(&SrcData[SrcDataSize*NumChannels], ALBuffer, NumChannels,
+                      pos, DataSize);
+            SrcDataSize += DataSize;
+            BufferSize -= DataSize;
+
+            DataSize = LoopEnd-LoopStart;
+            while(BufferSize > 0)
+            {
+                DataSize = minu(BufferSize, DataSize);
+
+                LoadStack(&SrcData[SrcDataSize*NumChannels], ALBuffer, NumChannels,
+                          LoopStart, DataSize);
+                SrcDataSize += DataSize;
+                BufferSize -= DataSize;
+            }
+        }
+    }
+    else
+    {
+        /* Crawl the buffer queue to fill in the temp buffer */
+        const ALbufferlistitem *tmpiter = BufferListItem;
+        ALuint pos;
+
+        if(DataPosInt >= BufferPrePadding)
+            pos = DataPosInt - BufferPrePadding;
+        else
+        {
+            pos = BufferPrePadding - DataPosInt;
+            while(pos > 0)
+            {
+                if(!tmpiter->prev && !Looping)
+                {
+                    ALuint DataSize = minu(BufferSize, pos);
+
+                    SilenceStack(&SrcData[SrcDataSize*NumChannels], DataSize*NumChannels);
+                    SrcDataSize += DataSize;
+                    BufferSize -= DataSize;
+
+                    pos = 0;
+                    break;
+                }
+
+                if(tmpiter->prev)
+                    tmpiter = tmpiter->prev;
+                else
+                {
+                    while(tmpiter->next)
+                        tmpiter = tmpiter->next;
+                }
+
+                if(tmpiter->buffer)
+                {
+                    if((ALuint)tmpiter->buffer->SampleLen > pos)
+                    {
+                        pos = tmpiter->buffer->SampleLen - pos;
+                        break;
+                    }
+                    pos -= tmpiter->buffer->SampleLen;
+                }
+            }
+        }
+
+        while(tmpiter && BufferSize > 0)
+        {
+            const ALbuffer *ALBuffer;
+            if((ALBuffer=tmpiter->buffer) != NULL)
+            {
+                ALuint DataSize = ALBuffer->SampleLen;
+
+                /* Skip the data already played */
+                if(DataSize <= pos)
+                    pos -= DataSize;
+                else
+                {
+                    DataSize -= pos;
+
+                    DataSize = minu(BufferSize, DataSize);
+                    LoadStack(&SrcData[SrcDataSize*NumChannels], ALBuffer,
+                              NumChannels, pos, DataSize);
+                    pos -= pos;
+                    SrcDataSize += DataSize;
+                    BufferSize -= DataSize;
+                }
+            }
+            tmpiter = tmpiter->next;
+            if(!tmpiter && Looping)
+                tmpiter = Source->queue;
+            else if(!tmpiter)
+            {
+                SilenceStack(&SrcData[SrcDataSize*NumChannels], BufferSize*NumChannels);
+                SrcDataSize += BufferSize;
+                BufferSize -= BufferSize;
+            }
+        }
+    }
+
+    return SrcDataSize;
+}
+
+/* Returns how many output samples can be resampled from SrcDataSize sample
+ * frames of input, which include the resampler padding. */
+static __inline ALuint MixableSamples(ALuint SrcDataSize, ALuint Padding,
+                                      ALuint increment, ALuint frac)
+{
+    ALint64 DataSize64;
+
+    DataSize64  = SrcDataSize;
+    DataSize64 -= Padding;
+    DataSize64 <<= FRACTIONBITS;
+    DataSize64 -= increment;
+    DataSize64 -= frac;
+    if(DataSize64 <= 0)
+        return 0;
+
+    return (ALuint)((DataSize64+(increment-1)) / increment);
+}
+
+
+/* Gets the samples a source playing a callback buffer needs to mix todo more
+ * samples, calling back for what's missing. The held samples are first moved
+ * down to keep only the pre-padding before the current position, which
+ * DataPosInt is updated for. Returns how many sample frames can be read from
+ * the start of the source's CallbackData, where those past the end of the
+ * stream are silent. */
+static ALuint LoadCallbackData(ALsource *Source, const ALbuffer *ALBuffer,
+  ALuint *DataPosInt, ALuint DataPosFrac, ALuint increment, ALuint todo)
+{
+    const ALuint BufferPrePadding = ResamplerPrePadding[Source->Resampler];
+    const ALuint BufferPadding = ResamplerPadding[Source->Resampler];
+    const ALuint NumChannels = Source->NumChannels;
+    const ALuint FrameSize = NumChannels * Source->SampleSize;
+    ALubyte *Data = Source->CallbackData;
+    ALuint Fill = Source->CallbackFill;
+    ALuint64 DataSize64;
+    ALuint DataSize;
+
+    if(Fill == 0 && !Source->CallbackEnded)
+    {
+        /* Starting, so the pre-padding is silence */
+        memset(Data, 0, BufferPrePadding*FrameSize);
+        Fill = BufferPrePadding;
+        *DataPosInt += BufferPrePadding;
+    }
+    else if(*DataPosInt > BufferPrePadding)
+    {
+        ALuint Drop = minu(*DataPosInt - BufferPrePadding, Fill);
+        memmove(Data, Data + Drop*FrameSize, (Fill-Drop)*FrameSize);
+        Fill -= Drop;
+        *DataPosInt -= Drop;
+    }
+
+    /* Same amount as would be converted to the stack */
+    DataSize64  = todo+1;
+    DataSize64 *= increment;
+    DataSize64 += DataPosFrac+FRACTIONMASK;
+    DataSize64 >>= FRACTIONBITS;
+    DataSize64 += BufferPadding + *DataPosInt;
+    DataSize = (ALuint)mini64(DataSize64, CALLBACK_FRAMES(NumChannels));
+
+    if(DataSize > Fill && !Source->CallbackEnded)
+    {
+        ALsizei want = (DataSize-Fill) * FrameSize;
+        ALsizei got = ALBuffer->Callback(ALBuffer->CallbackParam,
+                                         Data + Fill*FrameSize, want);
+        got = maxi(mini(got, want), 0);
+        if(got < want)
+            Source->CallbackEnded = AL_TRUE;
+        Fill += got / FrameSize;
+    }
+    if(DataSize > Fill)
+        memset(Data + Fill*FrameSize, 0, (DataSize-Fill)*FrameSize);
+
+    Source->CallbackFill = Fill;
+    return DataSize;
+}
+
+ALvoid MixSource(ALsource *Source, ALCdevice *Device, const MixBus *Bus,
+                 ALuint SamplesToDo)
 {
     ALbufferlistitem *BufferListItem;
     ALuint DataPosInt, DataPosFrac;
@@ -528,7 +1317,9 @@ ALvoid MixSource(ALsource *Source, ALCdevice *Device, ALuint SamplesToDo)
     ALuint NumChannels;
     ALuint FrameSize;
     ALint64 DataSize64;
-    ALuint i;
+    ALuint64 DataPos64;
+    ALfloat ResampledData[BUFFERSIZE+1];
+    ALuint chan, i, j;
 
     /* Get source info */
     State         = Source->state;
@@ -550,209 +1341,157 @@ ALvoid MixSource(ALsource *Source, ALCdevice *Device, ALuint SamplesToDo)
     do {
         const ALuint BufferPrePadding = ResamplerPrePadding[Resampler];
         const ALuint BufferPadding = ResamplerPadding[Resampler];
-        ALfloat StackData[STACK_DATA_SIZE/sizeof(ALfloat)];
-        ALfloat *SrcData = StackData;
-        ALuint SrcDataSize = 0;
-        ALuint BufferSize;
-
-        /* Figure out how many buffer bytes will be needed */
-        DataSize64  = SamplesToDo-OutPos+1;
-        DataSize64 *= increment;
-        DataSize64 += DataPosFrac+FRACTIONMASK;
-        DataSize64 >>= FRACTIONBITS;
-        DataSize64 += BufferPadding+BufferPrePadding;
-        DataSize64 *= NumChannels;
-
-        BufferSize  = (ALuint)mini64(DataSize64, STACK_DATA_SIZE/sizeof(ALfloat));
-        BufferSize /= NumChannels;
-
-        if(Source->lSourceType == AL_STATIC)
+        const ALbuffer *ALBuffer = BufferListItem->buffer;
+        ALuint CallbackSize = 0;
+        ALuint BufferSize = 0;
+
+        /* If current pos is beyond the loop range, do not loop */
+        if(Source->lSourceType == AL_STATIC && ALBuffer &&
+           DataPosInt >= (ALuint)ALBuffer->LoopEnd)
+            Looping = AL_FALSE;
+
+        /* Callback buffers are pulled from even when not mixed, to keep the
+         * stream going at the same pace */
+        if(ALBuffer && ALBuffer->Callback)
         {
-            const ALbuffer *ALBuffer = Source->queue->buffer;
-            const ALubyte *Data = ALBuffer->data;
-            ALuint DataSize;
-            ALuint pos;
+            CallbackSize = LoadCallbackData(Source, ALBuffer, &DataPosInt,
+                                            DataPosFrac, increment,
+                                            SamplesToDo-OutPos);
+            BufferSize = MixableSamples(CallbackSize,
+                                        BufferPadding+BufferPrePadding,
+                                        increment, DataPosFrac);
+            BufferSize = minu(BufferSize, (SamplesToDo-OutPos));
+        }
 
-            /* If current pos is beyond the loop range, do not loop */
-            if(Looping == AL_FALSE || DataPosInt >= (ALuint)ALBuffer->LoopEnd)
+        if(Source->Params.Virtual || Source->Params.Stolen)
+        {
+            /* The source is inaudible or over the voice budget, so just
+             * advance its position. The click removal fades out what it last
+             * mixed, and fades it back in when it's mixed again. */
+            if(!CallbackSize)
+                BufferSize = SamplesToDo-OutPos;
+        }
+        else
+        {
+            ALfloat StackData[STACK_DATA_SIZE/sizeof(ALfloat)];
+            const ALubyte *SrcData = NULL;
+            ALuint SrcDataSize = 0;
+            ALuint SampleSize = 0;
+            ResamplerFunc Resample = NULL;
+
+            /* Callback data is always in a format that's read in place */
+            if(CallbackSize)
             {
-                Looping = AL_FALSE;
-
-                if(DataPosInt >= BufferPrePadding)
-                    pos = DataPosInt - BufferPrePadding;
-                else
-                {
-                    DataSize = BufferPrePadding - DataPosInt;
-                    DataSize = minu(BufferSize, DataSize);
-
-                    SilenceStack(&SrcData[SrcDataSize*NumChannels],
-                                 DataSize*NumChannels);
-                    SrcDataSize += DataSize;
-                    BufferSize -= DataSize;
-
-                    pos = 0;
-                }
-
-                /* Copy what's left to play in the source buffer, and clear the
-                 * rest of the temp buffer */
-                DataSize = ALBuffer->SampleLen - pos;
-                DataSize = minu(BufferSize, DataSize);
-
-                LoadStack(&SrcData[SrcDataSize*NumChannels], &Data[pos*FrameSize],
-                          ALBuffer->FmtType, DataSize*NumChannels);
-                SrcDataSize += DataSize;
-                BufferSize -= DataSize;
-
-                SilenceStack(&SrcData[SrcDataSize*NumChannels],
-                             BufferSize*NumChannels);
-                SrcDataSize += BufferSize;
-                BufferSize -= BufferSize;
+                SrcData = Source->CallbackData;
+                SampleSize = Source->SampleSize;
+                Resample = Source->Params.Resample;
             }
-            else
+            /* Read straight from the buffer's storage when the section to
+             * mix, padding included, is contiguous in it and the storage can
+             * be read in place. */
+            else if(ALBuffer && Source->Params.Resample &&
+                    DataPosInt >= BufferPrePadding)
             {
-                ALuint LoopStart = ALBuffer->LoopStart;
-                ALuint LoopEnd   = ALBuffer->LoopEnd;
+                ALuint DataStart = DataPosInt - BufferPrePadding;
+                ALuint DataEnd = ALBuffer->SampleLen;
 
-                if(DataPosInt >= LoopStart)
+                if(Looping && Source->lSourceType == AL_STATIC)
                 {
-                    pos = DataPosInt-LoopStart;
-                    while(pos < BufferPrePadding)
-                        pos += LoopEnd-LoopStart;
-                    pos -= BufferPrePadding;
-                    pos += LoopStart;
-                }
-                else if(DataPosInt >= BufferPrePadding)
-                    pos = DataPosInt - BufferPrePadding;
-                else
-                {
-                    DataSize = BufferPrePadding - DataPosInt;
-                    DataSize = minu(BufferSize, DataSize);
+                    ALuint LoopStart = ALBuffer->LoopStart;
 
-                    SilenceStack(&SrcData[SrcDataSize*NumChannels], DataSize*NumChannels);
-                    SrcDataSize += DataSize;
-                    BufferSize -= DataSize;
-
-                    pos = 0;
+                    /* The pre-padding wraps around to the end of the loop */
+                    if(DataPosInt >= LoopStart && DataStart < LoopStart)
+                        DataEnd = 0;
+                    else
+                        DataEnd = ALBuffer->LoopEnd;
                 }
 
-                /* Copy what's left of this loop iteration, then copy repeats
-                 * of the loop section */
-                DataSize = LoopEnd - pos;
-                DataSize = minu(BufferSize, DataSize);
-
-                LoadStack(&SrcData[SrcDataSize*NumChannels], &Data[pos*FrameSize],
-                          ALBuffer->FmtType, DataSize*NumChannels);
-                SrcDataSize += DataSize;
-                BufferSize -= DataSize;
-
-                DataSize = LoopEnd-LoopStart;
-                while(BufferSize > 0)
+                if(DataEnd > DataStart)
                 {
-                    DataSize = minu(BufferSize, DataSize);
-
-                    LoadStack(&SrcData[SrcDataSize*NumChannels], &Data[LoopStart*FrameSize],
-                              ALBuffer->FmtType, DataSize*NumChannels);
-                    SrcDataSize += DataSize;
-                    BufferSize -= DataSize;
+                    SrcDataSize = DataEnd - DataStart;
+                    BufferSize = MixableSamples(SrcDataSize,
+                                                BufferPadding+BufferPrePadding,
+                                                increment, DataPosFrac);
                 }
-            }
-        }
-        else
-        {
-            /* Crawl the buffer queue to fill in the temp buffer */
-            ALbufferlistitem *tmpiter = BufferListItem;
-            ALuint pos;
-
-            if(DataPosInt >= BufferPrePadding)
-                pos = DataPosInt - BufferPrePadding;
-            else
-            {
-                pos = BufferPrePadding - DataPosInt;
-                while(pos > 0)
+                if(BufferSize > 0)
                 {
-                    if(!tmpiter->prev && !Looping)
-                    {
-                        ALuint DataSize = minu(BufferSize, pos);
-
-                        SilenceStack(&SrcData[SrcDataSize*NumChannels], DataSize*NumChannels);
-                        SrcDataSize += DataSize;
-                        BufferSize -= DataSize;
-
-                        pos = 0;
-                        break;
-                    }
-
-                    if(tmpiter->prev)
-                        tmpiter = tmpiter->prev;
-                    else
-                    {
-                        while(tmpiter->next)
-                            tmpiter = tmpiter->next;
-                    }
-
-                    if(tmpiter->buffer)
-                    {
-                        if((ALuint)tmpiter->buffer->SampleLen > pos)
-                        {
-                            pos = tmpiter->buffer->SampleLen - pos;
-                            break;
-                        }
-                        pos -= tmpiter->buffer->SampleLen;
-                    }
+                    SrcData = (const ALubyte*)ALBuffer->data + DataStart*FrameSize;
+                    SampleSize = Source->SampleSize;
+                    Resample = Source->Params.Resample;
                 }
             }
 
-            while(tmpiter && BufferSize > 0)
+            /* Otherwise convert the needed samples into the stack buffer,
+             * taking care of loop points, queue seams and padding edges. */
+            if(!Resample)
             {
-                const ALbuffer *ALBuffer;
-                if((ALBuffer=tmpiter->buffer) != NULL)
-                {
-                    const ALubyte *Data = ALBuffer->data;
-                    ALuint DataSize = ALBuffer->SampleLen;
+                /* Figure out how many buffer bytes will be needed */
+                DataSize64  = SamplesToDo-OutPos+1;
+                DataSize64 *= increment;
+                DataSize64 += DataPosFrac+FRACTIONMASK;
+                DataSize64 >>= FRACTIONBITS;
+                DataSize64 += BufferPadding+BufferPrePadding;
+                DataSize64 *= NumChannels;
+
+                BufferSize  = (ALuint)mini64(DataSize64, STACK_DATA_SIZE/sizeof(ALfloat));
+                BufferSize /= NumChannels;
+
+                SrcDataSize = LoadSourceData(Source, BufferListItem, DataPosInt,
+                                             Looping, BufferSize, StackData);
+                BufferSize = MixableSamples(SrcDataSize,
+                                            BufferPadding+BufferPrePadding,
+                                            increment, DataPosFrac);
+
+                SrcData = (const ALubyte*)StackData;
+                SampleSize = sizeof(ALfloat);
+                Resample = Source->Params.ResampleStack;
+            }
+            BufferSize = minu(BufferSize, (SamplesToDo-OutPos));
 
-                    /* Skip the data already played */
-                    if(DataSize <= pos)
-                        pos -= DataSize;
-                    else
-                    {
-                        Data += pos*FrameSize;
-                        DataSize -= pos;
-                        pos -= pos;
-
-                        DataSize = minu(BufferSize, DataSize);
-                        LoadStack(&SrcData[SrcDataSize*NumChannels], Data,
-                                  ALBuffer->FmtType, DataSize*NumChannels);
-                        SrcDataSize += DataSize;
-                        BufferSize -= DataSize;
-                    }
-                }
-                tmpiter = tmpiter->next;
-                if(!tmpiter && Looping)
-                    tmpiter = Source->queue;
-                else if(!tmpiter)
+            SrcData += BufferPrePadding*NumChannels*SampleSize;
+            for(chan = 0;chan < NumChannels;chan++)
+            {
+                /* Resample this channel once, including the sample following
+                 * the mixed section used for click removal, then run the dry
+                 * path and each send off the result. */
+                Resample(&SrcData[chan*SampleSize], DataPosFrac, increment,
+                         NumChannels, ResampledData, BufferSize+1);
+
+                Source->Params.DryMix(Source, Device, Bus, ResampledData, chan,
+                                      OutPos, SamplesToDo, BufferSize);
+                if(Bus->Log)
+                    LogMixCall(Bus, NULL, OutPos, BufferSize);
+                for(j = 0;j < Device->NumAuxSends;j++)
                 {
-                    SilenceStack(&SrcData[SrcDataSize*NumChannels], BufferSize*NumChannels);
-                    SrcDataSize += BufferSize;
-                    BufferSize -= BufferSize;
+                    if(!Source->Params.Send[j].Slot)
+                        continue;
+                    MixSend(Source, j, Bus, ResampledData, chan,
+                            OutPos, SamplesToDo, BufferSize);
+                    if(Bus->Log)
+                        LogMixCall(Bus, Source->Params.Send[j].Slot, OutPos,
+                                   BufferSize);
                 }
             }
         }
-
-        /* Figure out how many samples we can mix. */
-        DataSize64  = SrcDataSize;
-        DataSize64 -= BufferPadding+BufferPrePadding;
-        DataSize64 <<= FRACTIONBITS;
-        DataSize64 -= increment;
-        DataSize64 -= DataPosFrac;
-
-        BufferSize = (ALuint)((DataSize64+(increment-1)) / increment);
-        BufferSize = minu(BufferSize, (SamplesToDo-OutPos));
-
-        SrcData += BufferPrePadding*NumChannels;
-        Source->Params.DoMix(Source, Device, SrcData, &DataPosInt, &DataPosFrac,
-                             OutPos, SamplesToDo, BufferSize);
+        DataPos64  = DataPosFrac;
+        DataPos64 += (ALuint64)increment*BufferSize;
+        DataPosInt += (ALuint)(DataPos64>>FRACTIONBITS);
+        DataPosFrac = (ALuint)(DataPos64&FRACTIONMASK);
         OutPos += BufferSize;
 
+        /* Callback streams end once they've played the last samples given */
+        if(CallbackSize)
+        {
+            if(Source->CallbackEnded && DataPosInt >= Source->CallbackFill)
+            {
+                State = AL_STOPPED;
+                BuffersPlayed = Source->BuffersInQueue;
+                DataPosInt = 0;
+                DataPosFrac = 0;
+            }
+            continue;
+        }
+
         /* Handle looping sources */
         while(1)
         {
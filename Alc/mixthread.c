@@ -0,0 +1,376 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 1999-2007 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ *  Boston, MA  02111-1307, USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "alMain.h"
+#include "alSource.h"
+#include "alAuxEffectSlot.h"
+#include "alu.h"
+
+
+#ifdef _WIN32
+
+typedef HANDLE MixSemaphore;
+
+static ALboolean InitSemaphore(MixSemaphore *sem)
+{
+    *sem = CreateSemaphore(NULL, 0, 0x7fffffff, NULL);
+    return (*sem != NULL);
+}
+
+static void DestroySemaphore(MixSemaphore *sem)
+{ CloseHandle(*sem); }
+
+static void PostSemaphore(MixSemaphore *sem)
+{ ReleaseSemaphore(*sem, 1, NULL); }
+
+static void WaitSemaphore(MixSemaphore *sem)
+{ WaitForSingleObject(*sem, INFINITE); }
+
+#else
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    ALuint count;
+} MixSemaphore;
+
+static ALboolean InitSemaphore(MixSemaphore *sem)
+{
+    if(pthread_mutex_init(&sem->mutex, NULL) != 0)
+        return AL_FALSE;
+    if(pthread_cond_init(&sem->cond, NULL) != 0)
+    {
+        pthread_mutex_destroy(&sem->mutex);
+        return AL_FALSE;
+    }
+    sem->count = 0;
+    return AL_TRUE;
+}
+
+static void DestroySemaphore(MixSemaphore *sem)
+{
+    pthread_cond_destroy(&sem->cond);
+    pthread_mutex_destroy(&sem->mutex);
+}
+
+static void PostSemaphore(MixSemaphore *sem)
+{
+    pthread_mutex_lock(&sem->mutex);
+    sem->count++;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->mutex);
+}
+
+static void WaitSemaphore(MixSemaphore *sem)
+{
+    pthread_mutex_lock(&sem->mutex);
+    while(sem->count == 0)
+        pthread_cond_wait(&sem->cond, &sem->mutex);
+    sem->count--;
+    pthread_mutex_unlock(&sem->mutex);
+}
+
+#endif
+
+
+typedef struct MixThread {
+    struct MixThreadPool *Pool;
+    ALvoid *Thread;
+    MixSemaphore Start;
+
+    /* The sources this thread mixes for the current update, every
+     * SourceStep'th one starting from Sources */
+    ALsource **Sources;
+    ALuint SourceCount;
+    ALuint SourceStep;
+
+    /* Where each source's records start in the log, with an extra entry
+     * for the end of the last one */
+    ALuint *SourceStart;
+    ALuint MaxSources;
+
+    MixBus Bus;
+    MixLog Log;
+
+    ALfloat DryBuffer[MAXCHANNELS][BUFFERSIZE];
+    ALfloat ClickRemoval[MAXCHANNELS];
+    ALfloat PendingClicks[MAXCHANNELS];
+    ALfloat WetBuffer[BUFFERSIZE];
+    ALfloat WetClicks[2];
+} MixThread;
+
+struct MixThreadPool {
+    /* The calling thread's share is logged like the others */
+    MixThread *Local;
+
+    MixThread **Threads;
+    ALuint NumThreads;
+
+    MixSemaphore Done;
+    volatile ALboolean Quit;
+
+    /* Parameters for the current update */
+    ALCdevice *Device;
+    ALuint SamplesToDo;
+};
+
+
+static ALvoid MixThreadRun(MixThread *self)
+{
+    struct MixThreadPool *pool = self->Pool;
+    ALCdevice *Device = pool->Device;
+    const ALuint SamplesToDo = pool->SamplesToDo;
+    ALuint i;
+
+    self->Log.NumRecords = 0;
+    self->Log.DataSize = 0;
+    self->Log.NumPlanes = DryPlanesFromDevice(Device);
+    self->Log.Failed = AL_FALSE;
+
+    for(i = 0;i < self->SourceCount;i++)
+    {
+        self->SourceStart[i] = self->Log.NumRecords;
+        MixSource(self->Sources[i*self->SourceStep], Device, &self->Bus,
+                  SamplesToDo);
+    }
+    self->SourceStart[i] = self->Log.NumRecords;
+}
+
+static ALuint MixThreadProc(ALvoid *ptr)
+{
+    MixThread *self = ptr;
+    int fpuState;
+
+    fpuState = SetMixerFPUMode();
+    while(1)
+    {
+        WaitSemaphore(&self->Start);
+        if(self->Pool->Quit)
+            break;
+
+        MixThreadRun(self);
+        PostSemaphore(&self->Pool->Done);
+    }
+    RestoreFPUMode(fpuState);
+
+    return 0;
+}
+
+/* Sets the thread's share of the sources, making sure it can track where
+ * each one's records start */
+static ALboolean MixThreadSetSources(MixThread *self, ALsource **sources,
+                                     ALuint count, ALuint step)
+{
+    if(count+1 > self->MaxSources)
+    {
+        void *temp = realloc(self->SourceStart, (count+1)*sizeof(*self->SourceStart));
+        if(!temp) return AL_FALSE;
+        self->SourceStart = temp;
+        self->MaxSources = count+1;
+    }
+
+    self->Sources = sources;
+    self->SourceCount = count;
+    self->SourceStep = step;
+    return AL_TRUE;
+}
+
+static MixThread *CreateMixThread(struct MixThreadPool *pool)
+{
+    MixThread *thread = calloc(1, sizeof(*thread));
+    if(!thread)
+        return NULL;
+
+    thread->Pool = pool;
+    thread->Bus.DryBuffer = thread->DryBuffer;
+    thread->Bus.ClickRemoval = thread->ClickRemoval;
+    thread->Bus.PendingClicks = thread->PendingClicks;
+    thread->Bus.WetBuffer = thread->WetBuffer;
+    thread->Bus.WetClickRemoval = &thread->WetClicks[0];
+    thread->Bus.WetPendingClicks = &thread->WetClicks[1];
+    thread->Bus.Log = &thread->Log;
+    return thread;
+}
+
+static void DestroyMixThread(MixThread *thread)
+{
+    free(thread->SourceStart);
+    free(thread->Log.Records);
+    free(thread->Log.Data);
+    free(thread);
+}
+
+
+struct MixThreadPool *CreateMixThreadPool(ALuint count)
+{
+    struct MixThreadPool *pool;
+    ALuint i;
+
+    pool = calloc(1, sizeof(*pool));
+    if(!pool) return NULL;
+
+    pool->Threads = calloc(count, sizeof(*pool->Threads));
+    pool->Local = CreateMixThread(pool);
+    if(!pool->Threads || !pool->Local || !InitSemaphore(&pool->Done))
+    {
+        if(pool->Local)
+            DestroyMixThread(pool->Local);
+        free(pool->Threads);
+        free(pool);
+        return NULL;
+    }
+    pool->Quit = AL_FALSE;
+
+    for(i = 0;i < count;i++)
+    {
+        MixThread *thread = CreateMixThread(pool);
+        if(!thread)
+            break;
+        if(!InitSemaphore(&thread->Start))
+        {
+            DestroyMixThread(thread);
+            break;
+        }
+
+        thread->Thread = StartThread(MixThreadProc, thread);
+        if(!thread->Thread)
+        {
+            DestroySemaphore(&thread->Start);
+            DestroyMixThread(thread);
+            break;
+        }
+        pool->Threads[pool->NumThreads++] = thread;
+    }
+    if(pool->NumThreads < count)
+        WARN("Only started %u of %u mixing threads\n", pool->NumThreads, count);
+
+    if(pool->NumThreads == 0)
+    {
+        DestroyMixThreadPool(pool);
+        return NULL;
+    }
+
+    TRACE("Started %u mixing threads\n", pool->NumThreads);
+    return pool;
+}
+
+ALvoid DestroyMixThreadPool(struct MixThreadPool *pool)
+{
+    ALuint i;
+
+    if(!pool)
+        return;
+
+    pool->Quit = AL_TRUE;
+    for(i = 0;i < pool->NumThreads;i++)
+    {
+        MixThread *thread = pool->Threads[i];
+
+        PostSemaphore(&thread->Start);
+        StopThread(thread->Thread);
+        DestroySemaphore(&thread->Start);
+        DestroyMixThread(thread);
+    }
+    DestroySemaphore(&pool->Done);
+
+    DestroyMixThread(pool->Local);
+    free(pool->Threads);
+    free(pool);
+}
+
+
+/* Mixes the context's active sources, dealing them out in turn across the
+ * pool's threads and the calling thread. Interleaving spreads runs of cheap
+ * virtual or stolen voices evenly over the threads. Every thread logs what
+ * it mixes, and the calling thread then adds the logs into the device and
+ * slot buffers in source order, so the result is the same as mixing the
+ * sources one after another without threads. */
+ALvoid MixSourcesThreaded(struct MixThreadPool *pool, ALCdevice *Device,
+                          ALCcontext *Context, ALuint SamplesToDo)
+{
+    ALsource **Sources = Context->ActiveSources;
+    const ALuint SourceCount = Context->ActiveSourceCount;
+    ALboolean Failed = AL_FALSE;
+    ALuint NumWorkers;
+    ALuint i;
+
+    NumWorkers = minu(pool->NumThreads+1, SourceCount);
+    for(i = 0;i < NumWorkers;i++)
+    {
+        MixThread *thread = ((i == 0) ? pool->Local : pool->Threads[i-1]);
+        if(!MixThreadSetSources(thread, &Sources[i],
+                                (SourceCount-i + NumWorkers-1) / NumWorkers,
+                                NumWorkers))
+        {
+            NumWorkers = i;
+            break;
+        }
+    }
+
+    if(NumWorkers <= 1)
+    {
+        MixBus Bus;
+
+        Bus.DryBuffer = Device->DryBuffer;
+        Bus.ClickRemoval = Device->ClickRemoval;
+        Bus.PendingClicks = Device->PendingClicks;
+        Bus.WetBuffer = NULL;
+        Bus.WetClickRemoval = NULL;
+        Bus.WetPendingClicks = NULL;
+        Bus.Log = NULL;
+        for(i = 0;i < SourceCount;i++)
+            MixSource(Sources[i], Device, &Bus, SamplesToDo);
+        return;
+    }
+
+    pool->Device = Device;
+    pool->SamplesToDo = SamplesToDo;
+    for(i = 1;i < NumWorkers;i++)
+        PostSemaphore(&pool->Threads[i-1]->Start);
+
+    MixThreadRun(pool->Local);
+
+    for(i = 1;i < NumWorkers;i++)
+        WaitSemaphore(&pool->Done);
+
+    for(i = 0;i < SourceCount;i++)
+    {
+        const ALuint w = i%NumWorkers;
+        const ALuint k = i/NumWorkers;
+        const MixThread *thread = ((w == 0) ? pool->Local : pool->Threads[w-1]);
+
+        ReplayMixLog(Device, &thread->Log, thread->SourceStart[k],
+                     thread->SourceStart[k+1]);
+    }
+
+    for(i = 0;i < NumWorkers;i++)
+    {
+        const MixThread *thread = ((i == 0) ? pool->Local : pool->Threads[i-1]);
+        if(thread->Log.Failed)
+            Failed = AL_TRUE;
+    }
+    if(Failed)
+        ERR("Out of memory logging mixed sources, some output was lost\n");
+}
@@ -26,6 +26,10 @@ typedef struct ALeffectslot
     ALfloat ClickRemoval[1];
     ALfloat PendingClicks[1];
 
+    /* Samples of silent input seen since the last audible input, up to the
+     * effect's tail length. Once it's reached, the slot sleeps. */
+    ALuint SilentSamples;
+
     RefCount ref;
 
     // Index to itself
@@ -42,7 +46,11 @@ struct ALeffectState {
     ALvoid (*Destroy)(ALeffectState *State);
     ALboolean (*DeviceUpdate)(ALeffectState *State, ALCdevice *Device);
     ALvoid (*Update)(ALeffectState *State, ALCdevice *Device, const ALeffectslot *Slot);
-    ALvoid (*Process)(ALeffectState *State, ALuint SamplesToDo, const ALfloat *SamplesIn, ALfloat (*SamplesOut)[MAXCHANNELS]);
+    ALvoid (*Process)(ALeffectState *State, const ALCdevice *Device, ALuint SamplesToDo, const ALfloat *SamplesIn, ALfloat (*SamplesOut)[BUFFERSIZE]);
+
+    /* How many samples the output keeps going for after the input goes
+     * silent, set by Update */
+    ALuint TailLength;
 };
 
 ALeffectState *NoneCreate(void);
@@ -54,7 +62,7 @@ ALeffectState *DedicatedCreate(void);
 #define ALeffectState_Destroy(a)        ((a)->Destroy((a)))
 #define ALeffectState_DeviceUpdate(a,b) ((a)->DeviceUpdate((a),(b)))
 #define ALeffectState_Update(a,b,c)     ((a)->Update((a),(b),(c)))
-#define ALeffectState_Process(a,b,c,d)  ((a)->Process((a),(b),(c),(d)))
+#define ALeffectState_Process(a,b,c,d,e) ((a)->Process((a),(b),(c),(d),(e)))
 
 ALenum InitializeEffect(ALCdevice *Device, ALeffectslot *EffectSlot, ALeffect *effect);
 
@@ -47,6 +47,9 @@ enum FmtType {
     FmtByte  = UserFmtByte,
     FmtShort = UserFmtShort,
     FmtFloat = UserFmtFloat,
+    FmtMulaw = UserFmtMulaw,
+    FmtAlaw  = UserFmtAlaw,
+    FmtIMA4  = UserFmtIMA4,
 };
 enum FmtChannels {
     FmtMono   = UserFmtMono,
@@ -65,6 +68,34 @@ static __inline ALuint FrameSizeFromFmt(enum FmtChannels chans, enum FmtType typ
     return ChannelsFromFmt(chans) * BytesFromFmt(type);
 }
 
+/* Storage formats that are decoded as they're mixed */
+static __inline ALboolean IsCompressedFmt(enum FmtType type)
+{
+    return (type == FmtMulaw || type == FmtAlaw || type == FmtIMA4);
+}
+
+/* IMA4 data is made of blocks of 65 sample frames, each taking 36 bytes per
+ * channel. Blocks decode independently of each other. */
+#define IMA4_BLOCK_LENGTH 65
+#define IMA4_BLOCK_SIZE   36
+
+typedef ALubyte ALmulaw;
+typedef ALubyte ALalaw;
+typedef ALubyte ALima4;
+
+extern const ALshort muLawDecompressionTable[256];
+extern const ALshort aLawDecompressionTable[256];
+void DecodeIMA4Block(ALshort *dst, const ALima4 *src, ALint numchans);
+
+/* Keeps IMA4, mu-law and A-law buffer data compressed, instead of decoding it
+ * to 16-bit samples when loaded */
+extern ALboolean CompressedBuffers;
+
+/* Resamples buffer data to the device's rate when it's loaded with
+ * alBufferData, so sources playing it at the normal pitch don't need to */
+extern ALboolean ResampleBuffers;
+void InitBufferResampler(void);
+
 
 typedef struct ALbuffer
 {
@@ -84,6 +115,22 @@ typedef struct ALbuffer
     ALsizei  LoopStart;
     ALsizei  LoopEnd;
 
+    /* Set when the data was resampled as it was loaded, so updates given at
+     * the original rate can't be placed anymore */
+    ALboolean Resampled;
+
+    /* Set when data is owned by the app and used in place. It's never
+     * written, and the app is told through ReleaseCallback (if given) once
+     * the buffer stops using it. */
+    ALboolean StaticData;
+    ALBUFFERRELEASEPROCSOFT ReleaseCallback;
+    ALvoid *ReleaseParam;
+
+    /* Set for buffers with no data of their own, which sources play by
+     * pulling samples from the app as they're mixed */
+    ALBUFFERCALLBACKTYPESOFT Callback;
+    ALvoid *CallbackParam;
+
     RefCount ref; // Number of sources using this buffer (deletion can only occur when this is 0)
 
     RWLock lock;
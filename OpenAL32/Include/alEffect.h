@@ -20,13 +20,14 @@ extern ALboolean DisabledEffects[MAX_EFFECTS];
 
 extern ALfloat ReverbBoost;
 extern ALboolean EmulateEAXReverb;
+extern ALuint ReverbDecimation;
 
 typedef struct ALeffect
 {
     // Effect type (AL_EFFECT_NULL, ...)
     ALenum type;
 
-    struct {
+    struct ALreverbProps {
         // Shared Reverb Properties
         ALfloat Density;
         ALfloat Diffusion;
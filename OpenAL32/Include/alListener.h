@@ -16,6 +16,19 @@ typedef struct ALlistener_struct
     volatile ALfloat Matrix[4][4];
     volatile ALfloat Gain;
     volatile ALfloat MetersPerUnit;
+
+    /* Guards the vector properties against partial updates */
+    volatile int PropSeq;
+
+    /* A consistent copy of the properties, taken by CalcListenerParams for
+     * the source updates to read */
+    struct {
+        ALfloat Position[3];
+        ALfloat Velocity[3];
+        ALfloat Matrix[4][4];
+        ALfloat Gain;
+        ALfloat MetersPerUnit;
+    } Params;
 } ALlistener;
 
 #ifdef __cplusplus
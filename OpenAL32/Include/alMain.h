@@ -28,6 +28,43 @@ AL_API ALvoid AL_APIENTRY alProcessUpdatesSOFT(void);
 #endif
 #endif
 
+#ifndef AL_SOFTX_source_priority
+#define AL_SOFTX_source_priority 1
+#define AL_SOURCE_PRIORITY_SOFT                  0xC003
+#endif
+
+#ifndef AL_SOFTX_static_buffer
+#define AL_SOFTX_static_buffer 1
+typedef void (AL_APIENTRY*ALBUFFERRELEASEPROCSOFT)(ALuint buffer, const ALvoid *data, ALvoid *userptr);
+typedef ALvoid (AL_APIENTRY*LPALBUFFERDATASTATICSOFT)(ALuint,ALenum,const ALvoid*,ALsizei,ALsizei,ALBUFFERRELEASEPROCSOFT,ALvoid*);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API ALvoid AL_APIENTRY alBufferDataStaticSOFT(ALuint buffer, ALenum format, const ALvoid *data, ALsizei size, ALsizei freq, ALBUFFERRELEASEPROCSOFT callback, ALvoid *userptr);
+#endif
+#endif
+
+#ifndef AL_SOFTX_callback_buffer
+#define AL_SOFTX_callback_buffer 1
+typedef ALsizei (AL_APIENTRY*ALBUFFERCALLBACKTYPESOFT)(ALvoid *userptr, ALvoid *sampledata, ALsizei numbytes);
+typedef ALvoid (AL_APIENTRY*LPALBUFFERCALLBACKSOFT)(ALuint,ALenum,ALsizei,ALBUFFERCALLBACKTYPESOFT,ALvoid*);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API ALvoid AL_APIENTRY alBufferCallbackSOFT(ALuint buffer, ALenum format, ALsizei freq, ALBUFFERCALLBACKTYPESOFT callback, ALvoid *userptr);
+#endif
+#endif
+
+#ifndef AL_SOFTX_sound_bank
+#define AL_SOFTX_sound_bank 1
+typedef ALsizei (AL_APIENTRY*LPALLOADBANKSOFT)(const ALchar*,ALsizei,ALuint*);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API ALsizei AL_APIENTRY alLoadBankSOFT(const ALchar *filename, ALsizei n, ALuint *buffers);
+#endif
+#endif
+
+#ifndef ALC_SOFTX_voice_budget
+#define ALC_SOFTX_voice_budget 1
+#define ALC_MAX_VOICES_SOFT                      0xC004
+#define ALC_STOLEN_VOICES_SOFT                   0xC005
+#endif
+
 
 #if defined(HAVE_STDINT_H)
 #include <stdint.h>
@@ -314,6 +351,51 @@ void WriteLock(RWLock *lock);
 void WriteUnlock(RWLock *lock);
 
 
+/* Property sequence counters. These let the API publish multi-value property
+ * changes (position vectors, orientation, etc) without taking the device lock
+ * the mixer holds. A writer makes the count odd while it changes the values
+ * and even again when done, so a reader knows it got a consistent set if the
+ * count was even and did not change across the read. */
+static __inline void BeginPropWrite(volatile int *seq)
+{
+    int val;
+    while(1)
+    {
+        val = *seq;
+        if(!(val&1) && CompExchangeInt(seq, val, val+1))
+            break;
+        sched_yield();
+    }
+}
+static __inline void EndPropWrite(volatile int *seq)
+{
+    int val;
+    do {
+        val = *seq;
+    } while(!CompExchangeInt(seq, val, val+1));
+}
+
+/* Returns the current count, with a full barrier. Odd means a write is in
+ * progress. */
+static __inline int ReadPropSeq(volatile int *seq)
+{
+    int val;
+    do {
+        val = *seq;
+    } while(!CompExchangeInt(seq, val, val));
+    return val;
+}
+static __inline int BeginPropRead(volatile int *seq)
+{
+    int val;
+    while(((val=ReadPropSeq(seq))&1))
+        sched_yield();
+    return val;
+}
+static __inline ALboolean EndPropRead(volatile int *seq, int val)
+{ return CompExchangeInt(seq, val, val); }
+
+
 typedef struct UIntMap {
     struct {
         ALuint key;
@@ -359,6 +441,10 @@ extern "C" {
 
 
 struct Hrtf;
+struct HrtfState;
+struct HrtfFftState;
+struct HrtfBed;
+struct HrtfCache;
 
 
 // Find the next power-of-2 for non-power-of-2 numbers.
@@ -555,6 +641,18 @@ struct ALCdevice_struct
     ALCuint      NumStereoSources;
     ALuint       NumAuxSends;
 
+    // Maximum number of voices mixed at once across all of the device's
+    // contexts (0 for no limit), and the number of voices left unmixed over
+    // it as of the last ranking
+    ALuint       MaxVoices;
+    volatile ALuint StolenVoices;
+
+    // Set when the playing sources change, so the voices get ranked again,
+    // and scratch space to rank them in
+    volatile ALenum RankVoices;
+    struct ALsource **VoiceRanks;
+    ALuint       VoiceRanksSize;
+
     // Map of Buffers for this device
     UIntMap BufferMap;
 
@@ -566,6 +664,14 @@ struct ALCdevice_struct
 
     /* HRTF filter tables */
     const struct Hrtf *Hrtf;
+    /* Mix HRTF sources with FFT convolution instead of per-sample */
+    ALboolean HrtfFft;
+    /* When set, HRTF sources are panned into a first-order B-format bed,
+     * kept in the DryBuffer planes after the output channels, which gets
+     * binauralized once per update */
+    struct HrtfBed *HrtfBed;
+    /* Interpolated HRIRs for recently used directions, or NULL */
+    struct HrtfCache *HrtfCache;
 
     // Stereo-to-binaural filter
     struct bs2b *Bs2b;
@@ -574,8 +680,9 @@ struct ALCdevice_struct
     // Device flags
     ALuint       Flags;
 
-    // Dry path buffer mix
-    ALfloat DryBuffer[BUFFERSIZE][MAXCHANNELS];
+    // Dry path buffer mix. Planar, with only the first
+    // ChannelsFromDevFmt(FmtChans) planes in use, ordered as DevChannels
+    ALfloat DryBuffer[MAXCHANNELS][BUFFERSIZE];
 
     enum Channel DevChannels[MAXCHANNELS];
 
@@ -583,12 +690,16 @@ struct ALCdevice_struct
     ALfloat PanningLUT[LUT_NUM][MAXCHANNELS];
     ALuint  NumChan;
 
+    // Indexed the same as the DryBuffer planes
     ALfloat ClickRemoval[MAXCHANNELS];
     ALfloat PendingClicks[MAXCHANNELS];
 
     /* Default effect slot */
     struct ALeffectslot *DefaultSlot;
 
+    /* Extra threads for mixing sources, or NULL to mix on one thread */
+    struct MixThreadPool *MixPool;
+
     // Contexts created on this device
     ALCcontext *volatile ContextList;
 
@@ -717,15 +828,35 @@ void SetDefaultWFXChannelOrder(ALCdevice *device);
 const ALCchar *DevFmtTypeString(enum DevFmtType type);
 const ALCchar *DevFmtChannelsString(enum DevFmtChannels chans);
 
-#define HRIR_BITS        (5)
-#define HRIR_LENGTH      (1<<HRIR_BITS)
-#define HRIR_MASK        (HRIR_LENGTH-1)
-void InitHrtf(void);
+/* Supported HRIR lengths, as powers of 2 between these */
+#define MIN_HRIR_LENGTH  (8)
+#define MAX_HRIR_LENGTH  (64)
 void FreeHrtf(void);
 const struct Hrtf *GetHrtf(ALCdevice *device);
+ALuint GetHrtfIrSize(const struct Hrtf *Hrtf);
 ALfloat CalcHrtfDelta(ALfloat oldGain, ALfloat newGain, const ALfloat olddir[3], const ALfloat newdir[3]);
-void GetLerpedHrtfCoeffs(const struct Hrtf *Hrtf, ALfloat elevation, ALfloat azimuth, ALfloat gain, ALfloat (*coeffs)[2], ALuint *delays);
-ALuint GetMovingHrtfCoeffs(const struct Hrtf *Hrtf, ALfloat elevation, ALfloat azimuth, ALfloat gain, ALfloat delta, ALint counter, ALfloat (*coeffs)[2], ALuint *delays, ALfloat (*coeffStep)[2], ALint *delayStep);
+void GetLerpedHrtfCoeffs(const struct Hrtf *Hrtf, struct HrtfCache *cache, ALfloat elevation, ALfloat azimuth, ALfloat gain, ALfloat (*coeffs)[2], ALuint *delays);
+ALuint GetMovingHrtfCoeffs(const struct Hrtf *Hrtf, struct HrtfCache *cache, ALfloat elevation, ALfloat azimuth, ALfloat gain, ALfloat delta, ALint counter, ALfloat (*coeffs)[2], ALuint *delays, ALfloat (*coeffStep)[2], ALint *delayStep);
+struct HrtfCache *CreateHrtfCache(ALuint size);
+void ResetHrtfCache(struct HrtfCache *cache, const struct Hrtf *Hrtf);
+void GetHrtfCacheStats(const struct HrtfCache *cache, ALuint *hits, ALuint *misses);
+struct HrtfState *ResizeHrtfState(struct HrtfState *state, ALuint numChannels, ALuint irSize);
+void ClearHrtfState(struct HrtfState *state);
+struct HrtfFftState *ResizeHrtfFftState(struct HrtfFftState *state, ALuint numChannels, ALuint irSize);
+void ClearHrtfFftState(struct HrtfFftState *state);
+void SetHrtfFftFilter(struct HrtfFftState *state, ALuint chan, const ALfloat (*coeffs)[2], const ALuint *delays, ALuint fadeLength);
+
+#define HRTF_BED_CHANNELS (4)
+struct HrtfBed *CreateHrtfBed(const struct Hrtf *Hrtf);
+void GetHrtfBedGains(ALfloat elevation, ALfloat azimuth, ALfloat gain, ALfloat *gains);
+void MixHrtfBed(struct HrtfBed *Bed, ALfloat (*BedBuffer)[BUFFERSIZE], ALfloat (*OutBuffer)[BUFFERSIZE], ALuint SamplesToDo);
+
+/* Number of DryBuffer planes to mix, including the HRTF bed's */
+static __inline ALuint DryPlanesFromDevice(const ALCdevice *device)
+{
+    return ChannelsFromDevFmt(device->FmtChans) +
+           (device->HrtfBed ? HRTF_BED_CHANNELS : 0);
+}
 
 void al_print(const char *func, const char *fmt, ...) PRINTF_STYLE(2,3);
 #define AL_PRINT(...) al_print(__FUNCTION__, __VA_ARGS__)
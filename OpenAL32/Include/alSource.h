@@ -4,6 +4,7 @@
 #define MAX_SENDS                 4
 
 #include "alFilter.h"
+#include "alBuffer.h"
 #include "alu.h"
 #include "AL/al.h"
 
@@ -20,6 +21,11 @@ extern enum Resampler DefaultResampler;
 extern const ALsizei ResamplerPadding[ResamplerMax];
 extern const ALsizei ResamplerPrePadding[ResamplerMax];
 
+/* Sample frames held for a source playing a callback buffer. This is as much
+ * as the mixer converts at once otherwise, which the source's step is already
+ * limited to. */
+#define CALLBACK_FRAMES(chans)  (STACK_DATA_SIZE/sizeof(ALfloat)/(chans))
+
 
 typedef struct ALbufferlistitem
 {
@@ -28,6 +34,43 @@ typedef struct ALbufferlistitem
     struct ALbufferlistitem *prev;
 } ALbufferlistitem;
 
+/* A source's HRIR coefficients and convolution output for mixing through the
+ * device's HRTF, allocated for the HRIR length the device uses */
+typedef struct HrtfState {
+    ALuint IrSize;
+    ALuint NumChannels;
+
+    /* For each channel, the target HRIR coefficients (IrSize each) */
+    ALfloat (*Coeffs)[2];
+    /* The per-sample coefficient steps for moving sources (IrSize) */
+    ALfloat (*CoeffStep)[2];
+    /* For each channel, the convolved output still to be mixed by the
+     * time-domain mixers (IrSize each) */
+    ALfloat (*Values)[2];
+} HrtfState;
+
+/* State for mixing a source's channels through the device's HRTF with
+ * block-based FFT convolution, used in place of the HrtfState values */
+typedef struct HrtfFftState {
+    ALuint FftSize;
+    ALuint IrSize;
+    ALuint NumChannels;
+
+    /* Length of the current crossfade from the old filters, in samples */
+    ALuint FadeLength;
+
+    /* Ear delays, in samples, for the current and old filters */
+    ALuint Delay[MAXCHANNELS][2];
+    ALuint OldDelay[MAXCHANNELS][2];
+
+    /* For each channel, the current and old filters' spectra as the sum and
+     * difference of the left and right ear responses (4 * FftSize) */
+    ALcomplex *Filters;
+    /* For each channel, the left and right output carried over into the
+     * next block (2 * (IrSize-1)) */
+    ALfloat *Tails;
+} HrtfFftState;
+
 typedef struct ALsource
 {
     volatile ALfloat   flPitch;
@@ -47,6 +90,7 @@ typedef struct ALsource
     volatile ALboolean bLooping;
     volatile enum DistanceModel DistanceModel;
     volatile ALboolean DirectChannels;
+    volatile ALfloat   Priority;
 
     enum Resampler Resampler;
 
@@ -86,26 +130,55 @@ typedef struct ALsource
     ALuint NumChannels;
     ALuint SampleSize;
 
+    /* Samples pulled from a callback buffer, in the buffer's format. They
+     * start with the resampler's pre-padding before the current position,
+     * and CallbackFill frames are valid. CallbackEnded is set once the
+     * callback gave less than asked for, ending the stream. */
+    ALubyte *CallbackData;
+    ALuint CallbackFill;
+    ALboolean CallbackEnded;
+
     /* HRTF info */
     ALboolean HrtfMoving;
     ALuint HrtfCounter;
     ALfloat HrtfHistory[MAXCHANNELS][SRC_HISTORY_LENGTH];
-    ALfloat HrtfValues[MAXCHANNELS][HRIR_LENGTH][2];
+    HrtfState *Hrtf;
     ALuint HrtfOffset;
+    HrtfFftState *HrtfFft;
 
     /* Current target parameters used for mixing */
     struct {
-        MixerFunc DoMix;
+        /* Resamplers reading the buffer storage in place, and reading
+         * samples converted to the stack */
+        ResamplerFunc Resample;
+        ResamplerFunc ResampleStack;
+        DryMixerFunc DryMix;
+
+        /* Set when every gain is below the virtual voice threshold, so the
+         * source only advances without being mixed */
+        ALboolean Virtual;
+        /* Priority scaled by the loudest gain, used to rank voices against
+         * the device's voice budget. Stolen is set by the mixer for voices
+         * that didn't make the cut, which advance like virtual ones. */
+        ALfloat Score;
+        ALboolean Stolen;
 
         ALint Step;
 
+        /* The last consistent copy of the vector properties */
+        ALfloat Position[3];
+        ALfloat Direction[3];
+        ALfloat Velocity[3];
+
         ALfloat HrtfGain;
         ALfloat HrtfDir[3];
-        ALfloat HrtfCoeffs[MAXCHANNELS][HRIR_LENGTH][2];
         ALuint HrtfDelay[MAXCHANNELS][2];
-        ALfloat HrtfCoeffStep[HRIR_LENGTH][2];
         ALint HrtfDelayStep[2];
 
+        /* B-format gains for each input channel, when mixing into the
+         * device's HRTF bed */
+        ALfloat HrtfBedGains[MAXCHANNELS][HRTF_BED_CHANNELS];
+
         /* A mixing matrix. First subscript is the channel number of the input
          * data (regardless of channel configuration) and the second is the
          * channel target (eg. FRONT_LEFT) */
@@ -123,6 +196,9 @@ typedef struct ALsource
     } Params;
     volatile ALenum NeedsUpdate;
 
+    /* Guards the vector properties against partial updates */
+    volatile int PropSeq;
+
     ALvoid (*Update)(struct ALsource *self, const ALCcontext *context);
 
     // Index to itself
@@ -135,6 +211,8 @@ ALboolean ApplyOffset(ALsource *Source);
 
 ALvoid ReleaseALSources(ALCcontext *Context);
 
+ResamplerFunc SelectResampler(enum Resampler Resampler, enum FmtType FmtType);
+
 #ifdef __cplusplus
 }
 #endif
@@ -119,17 +119,24 @@ extern "C" {
 
 struct ALsource;
 struct ALbuffer;
+struct ALeffectslot;
+struct MixBus;
 
-typedef ALvoid (*MixerFunc)(struct ALsource *self, ALCdevice *Device,
-                            const ALvoid *RESTRICT data,
-                            ALuint *DataPosInt, ALuint *DataPosFrac,
-                            ALuint OutPos, ALuint SamplesToDo,
-                            ALuint BufferSize);
+typedef ALvoid (*ResamplerFunc)(const ALvoid *src, ALuint frac,
+                                ALuint increment, ALuint NumChannels,
+                                ALfloat *RESTRICT dst, ALuint dstlen);
+
+typedef ALvoid (*DryMixerFunc)(struct ALsource *self, ALCdevice *Device,
+                               const struct MixBus *Bus,
+                               const ALfloat *RESTRICT data, ALuint srcchan,
+                               ALuint OutPos, ALuint SamplesToDo,
+                               ALuint BufferSize);
 
 enum Resampler {
     PointResampler,
     LinearResampler,
     CubicResampler,
+    SincResampler,
 
     ResamplerMax,
 };
@@ -171,14 +178,66 @@ enum DistanceModel {
  * may need more iterations. The value needs to be a sensible size, however, as
  * it constrains the max stepping value used for mixing.
  * The mixer requires being able to do two samplings per mixing loop. A 16KB
- * buffer can hold 512 sample frames for a 7.1 float buffer. With the cubic
- * resampler (which requires 3 padding sample frames), this limits the maximum
- * step to about 508. This means that buffer_freq*source_pitch cannot exceed
- * device_freq*508 for an 8-channel 32-bit buffer. */
+ * buffer can hold 512 sample frames for a 7.1 float buffer. With the sinc
+ * resampler (which requires 7 padding sample frames), this limits the maximum
+ * step to about 504. This means that buffer_freq*source_pitch cannot exceed
+ * device_freq*504 for an 8-channel 32-bit buffer. */
 #ifndef STACK_DATA_SIZE
 #define STACK_DATA_SIZE  16384
 #endif
 
+/* Contributions recorded from a logging MixBus, one record for each mixer
+ * call. A record's data holds Count samples for each plane, followed by each
+ * plane's click removal and pending click values. Dry records have NumPlanes
+ * planes, send records (with a non-NULL Slot) have one. */
+typedef struct MixRecord {
+    struct ALeffectslot *Slot;
+    ALuint OutPos;
+    ALuint Count;
+    ALuint Data;
+} MixRecord;
+
+typedef struct MixLog {
+    MixRecord *Records;
+    ALuint NumRecords;
+    ALuint MaxRecords;
+
+    ALfloat *Data;
+    ALuint DataSize;
+    ALuint MaxData;
+
+    ALuint NumPlanes;
+    ALboolean Failed;
+} MixLog;
+
+/* The buffers a source is mixed into. Normally these are the device's and
+ * the effect slots' own buffers. Mixing threads instead use zeroed scratch
+ * buffers with a Log, so what each mixer call adds can be added to the real
+ * buffers afterward in the same order as without threads. */
+typedef struct MixBus {
+    ALfloat (*DryBuffer)[BUFFERSIZE];
+    ALfloat *ClickRemoval;
+    ALfloat *PendingClicks;
+
+    /* Scratch accumulators shared by all sends. If WetBuffer is NULL, sends
+     * mix directly into the slots' own buffers. */
+    ALfloat *WetBuffer;
+    ALfloat *WetClickRemoval;
+    ALfloat *WetPendingClicks;
+
+    MixLog *Log;
+} MixBus;
+
+struct MixThreadPool;
+
+/* Largest transform aluFFT handles */
+#define MAX_FFT_SIZE  1024
+
+typedef struct ALcomplex {
+    ALfloat Real;
+    ALfloat Imag;
+} ALcomplex;
+
 
 static __inline ALfloat minf(ALfloat a, ALfloat b)
 { return ((a > b) ? b : a); }
@@ -289,21 +348,54 @@ static __inline void aluNormalize(ALfloat *inVector)
 
 
 ALvoid aluInitPanning(ALCdevice *Device);
+ALvoid aluInitResamplers(void);
+ALvoid aluInitFFT(void);
+ALvoid aluFFT(ALcomplex *buffer, ALuint size, ALboolean inverse);
 ALint aluCart2LUTpos(ALfloat re, ALfloat im);
 
+ALboolean CalcListenerParams(ALCcontext *ALContext);
 ALvoid CalcSourceParams(struct ALsource *ALSource, const ALCcontext *ALContext);
 ALvoid CalcNonAttnSourceParams(struct ALsource *ALSource, const ALCcontext *ALContext);
 
-MixerFunc SelectMixer(enum Resampler Resampler);
-MixerFunc SelectHrtfMixer(enum Resampler Resampler);
-
-ALvoid MixSource(struct ALsource *Source, ALCdevice *Device, ALuint SamplesToDo);
+ALvoid MixDirect(struct ALsource *Source, ALCdevice *Device, const MixBus *Bus,
+                 const ALfloat *RESTRICT data, ALuint srcchan,
+                 ALuint OutPos, ALuint SamplesToDo, ALuint BufferSize);
+#define DECL_TEMPLATE(N)                                                      \
+ALvoid MixDirect_Hrtf##N(struct ALsource *Source, ALCdevice *Device,          \
+                         const MixBus *Bus, const ALfloat *RESTRICT data,     \
+                         ALuint srcchan, ALuint OutPos, ALuint SamplesToDo,   \
+                         ALuint BufferSize);
+DECL_TEMPLATE(8)
+DECL_TEMPLATE(16)
+DECL_TEMPLATE(32)
+DECL_TEMPLATE(64)
+#undef DECL_TEMPLATE
+ALvoid MixDirect_HrtfFft(struct ALsource *Source, ALCdevice *Device, const MixBus *Bus,
+                         const ALfloat *RESTRICT data, ALuint srcchan,
+                         ALuint OutPos, ALuint SamplesToDo, ALuint BufferSize);
+ALvoid MixDirect_HrtfBed(struct ALsource *Source, ALCdevice *Device, const MixBus *Bus,
+                         const ALfloat *RESTRICT data, ALuint srcchan,
+                         ALuint OutPos, ALuint SamplesToDo, ALuint BufferSize);
+ALvoid MixSend(struct ALsource *Source, ALuint sendidx, const MixBus *Bus,
+               const ALfloat *RESTRICT data, ALuint srcchan,
+               ALuint OutPos, ALuint SamplesToDo, ALuint BufferSize);
+
+ALvoid MixSource(struct ALsource *Source, ALCdevice *Device, const MixBus *Bus,
+                 ALuint SamplesToDo);
+ALvoid ReplayMixLog(ALCdevice *Device, const MixLog *Log, ALuint First,
+                    ALuint Last);
+
+struct MixThreadPool *CreateMixThreadPool(ALuint count);
+ALvoid DestroyMixThreadPool(struct MixThreadPool *pool);
+ALvoid MixSourcesThreaded(struct MixThreadPool *pool, ALCdevice *Device,
+                          ALCcontext *Context, ALuint SamplesToDo);
 
 ALvoid aluMixData(ALCdevice *device, ALvoid *buffer, ALsizei size);
 ALvoid aluHandleDisconnect(ALCdevice *device);
 
 extern ALfloat ConeScale;
 extern ALfloat ZScale;
+extern ALfloat VirtualThreshold;
 
 #ifdef __cplusplus
 }
@@ -437,9 +437,10 @@ static ALvoid NoneUpdate(ALeffectState *State, ALCdevice *Device, const ALeffect
     (void)Device;
     (void)Slot;
 }
-static ALvoid NoneProcess(ALeffectState *State, ALuint SamplesToDo, const ALfloat *SamplesIn, ALfloat (*SamplesOut)[MAXCHANNELS])
+static ALvoid NoneProcess(ALeffectState *State, const ALCdevice *Device, ALuint SamplesToDo, const ALfloat *SamplesIn, ALfloat (*SamplesOut)[BUFFERSIZE])
 {
     (void)State;
+    (void)Device;
     (void)SamplesToDo;
     (void)SamplesIn;
     (void)SamplesOut;
@@ -607,6 +608,7 @@ ALenum InitEffectSlot(ALeffectslot *slot)
         slot->ClickRemoval[i] = 0.0f;
         slot->PendingClicks[i] = 0.0f;
     }
+    slot->SilentSamples = 0;
     slot->ref = 0;
 
     return AL_NO_ERROR;
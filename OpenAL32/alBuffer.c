@@ -24,6 +24,14 @@
 #include <stdio.h>
 #include <assert.h>
 #include <limits.h>
+#include <math.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include "alMain.h"
 #include "AL/al.h"
@@ -31,20 +39,68 @@
 #include "alError.h"
 #include "alBuffer.h"
 #include "alThunk.h"
+#include "alu.h"
 
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
 
-static ALenum LoadData(ALbuffer *ALBuf, ALuint freq, ALenum NewFormat, ALsizei frames, enum UserFmtChannels chans, enum UserFmtType type, const ALvoid *data, ALboolean storesrc);
+
+/* A sound bank file in memory, shared by the buffers made from it */
+typedef struct ALbank {
+    ALubyte *data;
+    size_t size;
+    ALboolean mapped;
+
+    volatile RefCount ref;
+} ALbank;
+
+#define BANK_HEADER_SIZE  16
+#define BANK_ENTRY_SIZE   24
+
+static __inline ALuint ReadLE(const ALubyte *data, ALuint bytes)
+{
+    ALuint ret = 0;
+    while(bytes > 0)
+    {
+        bytes--;
+        ret = (ret<<8) | data[bytes];
+    }
+    return ret;
+}
+
+static ALenum LoadData(ALbuffer *ALBuf, ALuint freq, ALenum NewFormat, ALsizei frames, enum UserFmtChannels chans, enum UserFmtType type, const ALvoid *data, ALboolean storesrc, ALuint DstFreq);
+static ALfloat *ResampleData(const ALvoid *data, enum UserFmtType type, ALuint numchans, ALsizei frames, ALuint freq, ALsizei dstframes, ALuint dstfreq);
+static ALenum LoadStaticData(ALbuffer *ALBuf, ALuint freq, ALenum format, ALsizei size, const ALvoid *data, ALBUFFERRELEASEPROCSOFT callback, ALvoid *userptr);
+static ALenum LoadCallback(ALbuffer *ALBuf, ALuint freq, ALenum format, ALBUFFERCALLBACKTYPESOFT callback, ALvoid *userptr);
+static void FreeData(ALbuffer *ALBuf);
 static void ConvertData(ALvoid *dst, enum UserFmtType dstType, const ALvoid *src, enum UserFmtType srcType, ALsizei numchans, ALsizei len);
 static ALboolean IsValidType(ALenum type);
 static ALboolean IsValidChannels(ALenum channels);
 static ALboolean DecomposeUserFormat(ALenum format, enum UserFmtChannels *chans, enum UserFmtType *type);
 static ALboolean DecomposeFormat(ALenum format, enum FmtChannels *chans, enum FmtType *type);
+static ALenum Int16Format(enum FmtChannels chans);
+static ALsizei StorageOffset(const ALbuffer *ALBuf, ALsizei frames);
+static ALbank *LoadBank(const ALchar *fname, ALsizei *count);
+static void ReleaseBank(ALbank *bank);
+static void AL_APIENTRY ReleaseBankData(ALuint buffer, const ALvoid *data, ALvoid *userptr);
+static void SwapBankData(ALubyte *data, ALsizei size, ALenum format);
 
 
 /*
  * Global Variables
  */
 
+ALboolean CompressedBuffers = AL_TRUE;
+ALboolean ResampleBuffers = AL_FALSE;
+
+/* Kaiser-windowed sinc used to resample buffers as they're loaded, given for
+ * BUFSINC_ZEROS zero crossings on one side with BUFSINC_RES points each */
+#define BUFSINC_ZEROS  32
+#define BUFSINC_RES    128
+#define BUFSINC_BETA   9.0
+static ALfloat BufferSinc[BUFSINC_ZEROS*BUFSINC_RES + 1];
+
 /* IMA ADPCM Stepsize table */
 static const long IMAStep_size[89] = {
        7,    8,    9,   10,   11,   12,   13,   14,   16,   17,   19,
@@ -72,7 +128,7 @@ static const long IMA4Index_adjust[16] = {
 
 /* A quick'n'dirty lookup table to decode a muLaw-encoded byte sample into a
  * signed 16-bit sample */
-static const ALshort muLawDecompressionTable[256] = {
+const ALshort muLawDecompressionTable[256] = {
     -32124,-31100,-30076,-29052,-28028,-27004,-25980,-24956,
     -23932,-22908,-21884,-20860,-19836,-18812,-17788,-16764,
     -15996,-15484,-14972,-14460,-13948,-13436,-12924,-12412,
@@ -132,7 +188,7 @@ static const char muLawCompressTable[256] = {
 
 /* A quick'n'dirty lookup table to decode an aLaw-encoded byte sample into a
  * signed 16-bit sample */
-static const ALshort aLawDecompressionTable[256] = {
+const ALshort aLawDecompressionTable[256] = {
      -5504, -5248, -6016, -5760, -4480, -4224, -4992, -4736,
      -7552, -7296, -8064, -7808, -6528, -6272, -7040, -6784,
      -2752, -2624, -3008, -2880, -2240, -2112, -2496, -2368,
@@ -286,7 +342,7 @@ AL_API ALvoid AL_APIENTRY alDeleteBuffers(ALsizei n, const ALuint *buffers)
             FreeThunkEntry(ALBuf->buffer);
 
             /* Release the memory used to store audio data */
-            free(ALBuf->data);
+            FreeData(ALBuf);
 
             /* Release buffer structure */
             memset(ALBuf, 0, sizeof(ALbuffer));
@@ -333,12 +389,14 @@ AL_API ALvoid AL_APIENTRY alBufferData(ALuint buffer,ALenum format,const ALvoid
     ALuint FrameSize;
     ALenum NewFormat;
     ALbuffer *ALBuf;
+    ALuint DstFreq;
     ALenum err;
 
     Context = GetContextRef();
     if(!Context) return;
 
     device = Context->Device;
+    DstFreq = (ResampleBuffers ? device->Frequency : 0);
     if((ALBuf=LookupBuffer(device, buffer)) == NULL)
         alSetError(Context, AL_INVALID_NAME);
     else if(size < 0 || freq < 0)
@@ -359,7 +417,7 @@ AL_API ALvoid AL_APIENTRY alBufferData(ALuint buffer,ALenum format,const ALvoid
                 err = AL_INVALID_VALUE;
             else
                 err = LoadData(ALBuf, freq, format, size/FrameSize,
-                               SrcChannels, SrcType, data, AL_TRUE);
+                               SrcChannels, SrcType, data, AL_TRUE, DstFreq);
             if(err != AL_NO_ERROR)
                 alSetError(Context, err);
             break;
@@ -383,7 +441,7 @@ AL_API ALvoid AL_APIENTRY alBufferData(ALuint buffer,ALenum format,const ALvoid
                 err = AL_INVALID_VALUE;
             else
                 err = LoadData(ALBuf, freq, NewFormat, size/FrameSize,
-                               SrcChannels, SrcType, data, AL_TRUE);
+                               SrcChannels, SrcType, data, AL_TRUE, DstFreq);
             if(err != AL_NO_ERROR)
                 alSetError(Context, err);
             break;
@@ -406,7 +464,7 @@ AL_API ALvoid AL_APIENTRY alBufferData(ALuint buffer,ALenum format,const ALvoid
                 err = AL_INVALID_VALUE;
             else
                 err = LoadData(ALBuf, freq, NewFormat, size/FrameSize,
-                               SrcChannels, SrcType, data, AL_TRUE);
+                               SrcChannels, SrcType, data, AL_TRUE, DstFreq);
             if(err != AL_NO_ERROR)
                 alSetError(Context, err);
             break;
@@ -432,7 +490,7 @@ AL_API ALvoid AL_APIENTRY alBufferData(ALuint buffer,ALenum format,const ALvoid
                 err = AL_INVALID_VALUE;
             else
                 err = LoadData(ALBuf, freq, NewFormat, size/FrameSize*65,
-                               SrcChannels, SrcType, data, AL_TRUE);
+                               SrcChannels, SrcType, data, AL_TRUE, DstFreq);
             if(err != AL_NO_ERROR)
                 alSetError(Context, err);
         }   break;
@@ -441,6 +499,207 @@ AL_API ALvoid AL_APIENTRY alBufferData(ALuint buffer,ALenum format,const ALvoid
     ALCcontext_DecRef(Context);
 }
 
+/*
+ *    alBufferDataStaticSOFT(ALuint buffer, ALenum format, const ALvoid *data,
+ *                           ALsizei size, ALsizei freq,
+ *                           ALBUFFERRELEASEPROCSOFT callback, ALvoid *userptr)
+ *
+ *    Makes the buffer use the app's data in place, without copying it. The
+ *    data has to be in a format the mixer can read as-is: one of the storage
+ *    formats taken by alBufferSamplesSOFT (where 8-bit samples are signed), or
+ *    IMA4, mu-law or A-law. It must stay valid and unchanged until callback is
+ *    called, which happens once the buffer stops using it (when the buffer is
+ *    deleted or given new data, or its device is closed). As these all need
+ *    the buffer to be out of use, that's after the last source using it lets
+ *    go.
+ */
+AL_API ALvoid AL_APIENTRY alBufferDataStaticSOFT(ALuint buffer, ALenum format,
+  const ALvoid *data, ALsizei size, ALsizei freq,
+  ALBUFFERRELEASEPROCSOFT callback, ALvoid *userptr)
+{
+    ALCcontext *Context;
+    ALbuffer *ALBuf;
+    ALenum err;
+
+    Context = GetContextRef();
+    if(!Context) return;
+
+    if((ALBuf=LookupBuffer(Context->Device, buffer)) == NULL)
+        alSetError(Context, AL_INVALID_NAME);
+    else if(size < 0 || freq <= 0 || (size > 0 && data == NULL))
+        alSetError(Context, AL_INVALID_VALUE);
+    else
+    {
+        err = LoadStaticData(ALBuf, freq, format, size, data, callback, userptr);
+        if(err != AL_NO_ERROR)
+            alSetError(Context, err);
+    }
+
+    ALCcontext_DecRef(Context);
+}
+
+/*
+ *    alBufferCallbackSOFT(ALuint buffer, ALenum format, ALsizei freq,
+ *                         ALBUFFERCALLBACKTYPESOFT callback, ALvoid *userptr)
+ *
+ *    Makes the buffer a stream fed by callback. A source playing it calls
+ *    callback from the mixer for just the samples it needs, which are written
+ *    to sampledata in the given format and the number of bytes written is
+ *    returned. Writing less than numbytes ends the stream, and the source
+ *    stops after playing what it got. The formats are the ones
+ *    alBufferDataStaticSOFT takes, except for the compressed ones. The
+ *    callback runs in the mixer, so it must not block or call into AL.
+ *    Such buffers can only be set with AL_BUFFER, and not queued.
+ */
+AL_API ALvoid AL_APIENTRY alBufferCallbackSOFT(ALuint buffer, ALenum format,
+  ALsizei freq, ALBUFFERCALLBACKTYPESOFT callback, ALvoid *userptr)
+{
+    ALCcontext *Context;
+    ALbuffer *ALBuf;
+    ALenum err;
+
+    Context = GetContextRef();
+    if(!Context) return;
+
+    if((ALBuf=LookupBuffer(Context->Device, buffer)) == NULL)
+        alSetError(Context, AL_INVALID_NAME);
+    else if(freq <= 0 || callback == NULL)
+        alSetError(Context, AL_INVALID_VALUE);
+    else
+    {
+        err = LoadCallback(ALBuf, freq, format, callback, userptr);
+        if(err != AL_NO_ERROR)
+            alSetError(Context, err);
+    }
+
+    ALCcontext_DecRef(Context);
+}
+
+/*
+ *    alLoadBankSOFT(const ALchar *filename, ALsizei n, ALuint *buffers)
+ *
+ *    Creates buffers for the first n sounds of a sound bank file (see
+ *    LoadBank for its layout), storing their names in buffers, and returns
+ *    the number of sounds in the bank. Passing 0 for n only gets the count.
+ *    The buffers play straight from the file's mapped pages, as with
+ *    alBufferDataStaticSOFT, and the file is unmapped once none of them use
+ *    it anymore. Returns 0 on error.
+ */
+AL_API ALsizei AL_APIENTRY alLoadBankSOFT(const ALchar *filename, ALsizei n, ALuint *buffers)
+{
+    ALCcontext *Context;
+    ALbank *bank;
+    ALsizei count = 0;
+    ALsizei i;
+
+    Context = GetContextRef();
+    if(!Context) return 0;
+
+    if(!filename || n < 0 || IsBadWritePtr((void*)buffers, n * sizeof(ALuint)))
+        alSetError(Context, AL_INVALID_VALUE);
+    else if((bank=LoadBank(filename, &count)) == NULL)
+        alSetError(Context, AL_INVALID_VALUE);
+    else if(n > count)
+    {
+        alSetError(Context, AL_INVALID_VALUE);
+        ReleaseBank(bank);
+        count = 0;
+    }
+    else
+    {
+        ALCdevice *device = Context->Device;
+        ALenum err = AL_NO_ERROR;
+
+        /* Each buffer is set up before it's made visible, so there's no
+         * looking up or contention. The buffers hold a reference on the bank
+         * each, handed back through their release callback. */
+        for(i = 0;i < n;i++)
+        {
+            const ALubyte *entry = &bank->data[BANK_HEADER_SIZE + i*BANK_ENTRY_SIZE];
+            ALenum format = ReadLE(&entry[0], 4);
+            ALuint freq = ReadLE(&entry[4], 4);
+            ALuint loopstart = ReadLE(&entry[8], 4);
+            ALuint loopend = ReadLE(&entry[12], 4);
+            ALuint offset = ReadLE(&entry[16], 4);
+            ALuint size = ReadLE(&entry[20], 4);
+            ALbuffer *buffer;
+
+            if(freq == 0 || freq > INT_MAX || size > INT_MAX ||
+               (ALuint64)offset+size > bank->size)
+            {
+                ERR("Sound %d of %s has a bad rate or data range\n", i, filename);
+                err = AL_INVALID_VALUE;
+                break;
+            }
+
+            buffer = calloc(1, sizeof(ALbuffer));
+            if(!buffer)
+            {
+                err = AL_OUT_OF_MEMORY;
+                break;
+            }
+            RWLockInit(&buffer->lock);
+
+            if(!bank->mapped && !IS_LITTLE_ENDIAN)
+                SwapBankData(&bank->data[offset], size, format);
+            err = LoadStaticData(buffer, freq, format, size, &bank->data[offset],
+                                 ReleaseBankData, bank);
+            if(err == AL_NO_ERROR)
+            {
+                IncrementRef(&bank->ref);
+                if(loopstart != 0 || loopend != 0)
+                {
+                    if(loopstart >= loopend || loopend > (ALuint)buffer->SampleLen)
+                    {
+                        ERR("Sound %d of %s has bad loop points\n", i, filename);
+                        err = AL_INVALID_VALUE;
+                    }
+                    else
+                    {
+                        buffer->LoopStart = loopstart;
+                        buffer->LoopEnd = loopend;
+                    }
+                }
+            }
+            else
+                ERR("Sound %d of %s has an unusable format or size\n", i, filename);
+            if(err == AL_NO_ERROR)
+                err = NewThunkEntry(&buffer->buffer);
+            if(err == AL_NO_ERROR)
+            {
+                err = InsertUIntMapEntry(&device->BufferMap, buffer->buffer, buffer);
+                if(err != AL_NO_ERROR)
+                    FreeThunkEntry(buffer->buffer);
+            }
+            if(err != AL_NO_ERROR)
+            {
+                FreeData(buffer);
+                memset(buffer, 0, sizeof(ALbuffer));
+                free(buffer);
+                break;
+            }
+
+            buffers[i] = buffer->buffer;
+        }
+
+        if(err != AL_NO_ERROR)
+        {
+            alSetError(Context, err);
+            alDeleteBuffers(i, buffers);
+            count = 0;
+        }
+        else
+            TRACE("Loaded %d of %d sounds from %s\n", n, count, filename);
+
+        /* Drop the loader's reference */
+        ReleaseBankData(0, bank->data, bank);
+    }
+
+    ALCcontext_DecRef(Context);
+
+    return count;
+}
+
 /*
  *    alBufferSubDataSOFT(ALuint buffer, ALenum format, const ALvoid *data,
  *                        ALsizei offset, ALsizei length)
@@ -478,11 +737,18 @@ AL_API ALvoid AL_APIENTRY alBufferSubDataSOFT(ALuint buffer,ALenum format,const
 
         if(SrcChannels != ALBuf->OriginalChannels || SrcType != ALBuf->OriginalType)
             alSetError(Context, AL_INVALID_ENUM);
+        else if(ALBuf->StaticData || ALBuf->Resampled)
+            alSetError(Context, AL_INVALID_OPERATION);
         else if(offset > ALBuf->OriginalSize ||
                 length > ALBuf->OriginalSize-offset ||
                 (offset%original_align) != 0 ||
                 (length%original_align) != 0)
             alSetError(Context, AL_INVALID_VALUE);
+        else if((long)ALBuf->FmtType == (long)SrcType)
+        {
+            /* The data is stored as given, so the offset already matches */
+            memcpy(&((ALubyte*)ALBuf->data)[offset], data, length);
+        }
         else
         {
             ALuint Channels = ChannelsFromFmt(ALBuf->FmtChannels);
@@ -536,7 +802,7 @@ AL_API void AL_APIENTRY alBufferSamplesSOFT(ALuint buffer,
     else
     {
         err = LoadData(ALBuf, samplerate, internalformat, samples,
-                       channels, type, data, AL_FALSE);
+                       channels, type, data, AL_FALSE, 0);
         if(err != AL_NO_ERROR)
             alSetError(Context, err);
     }
@@ -564,18 +830,20 @@ AL_API void AL_APIENTRY alBufferSubSamplesSOFT(ALuint buffer,
         alSetError(Context, AL_INVALID_ENUM);
     else
     {
-        ALuint FrameSize;
-
         WriteLock(&ALBuf->lock);
-        FrameSize = FrameSizeFromFmt(ALBuf->FmtChannels, ALBuf->FmtType);
         if(channels != (ALenum)ALBuf->FmtChannels)
             alSetError(Context, AL_INVALID_ENUM);
+        else if(ALBuf->StaticData || ALBuf->Resampled)
+            alSetError(Context, AL_INVALID_OPERATION);
         else if(offset > ALBuf->SampleLen || samples > ALBuf->SampleLen-offset)
             alSetError(Context, AL_INVALID_VALUE);
+        else if(ALBuf->FmtType == FmtIMA4 &&
+                ((offset%IMA4_BLOCK_LENGTH) != 0 || (samples%IMA4_BLOCK_LENGTH) != 0))
+            alSetError(Context, AL_INVALID_VALUE);
         else
         {
             /* offset -> byte offset */
-            offset *= FrameSize;
+            offset = StorageOffset(ALBuf, offset);
             ConvertData(&((ALubyte*)ALBuf->data)[offset], ALBuf->FmtType,
                         data, type,
                         ChannelsFromFmt(ALBuf->FmtChannels), samples);
@@ -606,20 +874,19 @@ AL_API void AL_APIENTRY alGetBufferSamplesSOFT(ALuint buffer,
         alSetError(Context, AL_INVALID_ENUM);
     else
     {
-        ALuint FrameSize;
-
         ReadLock(&ALBuf->lock);
-        FrameSize = FrameSizeFromFmt(ALBuf->FmtChannels, ALBuf->FmtType);
         if(channels != (ALenum)ALBuf->FmtChannels)
             alSetError(Context, AL_INVALID_ENUM);
         else if(offset > ALBuf->SampleLen || samples > ALBuf->SampleLen-offset)
             alSetError(Context, AL_INVALID_VALUE);
         else if(type == UserFmtIMA4 && (samples%65) != 0)
             alSetError(Context, AL_INVALID_VALUE);
+        else if(ALBuf->FmtType == FmtIMA4 && (offset%IMA4_BLOCK_LENGTH) != 0)
+            alSetError(Context, AL_INVALID_VALUE);
         else
         {
             /* offset -> byte offset */
-            offset *= FrameSize;
+            offset = StorageOffset(ALBuf, offset);
             ConvertData(data, type,
                         &((ALubyte*)ALBuf->data)[offset], ALBuf->FmtType,
                         ChannelsFromFmt(ALBuf->FmtChannels), samples);
@@ -951,7 +1218,12 @@ AL_API ALvoid AL_APIENTRY alGetBufferi(ALuint buffer, ALenum eParam, ALint *plVa
             break;
 
         case AL_BITS:
-            *plValue = BytesFromFmt(pBuffer->FmtType) * 8;
+            /* Compressed data is reported as the 16-bit samples it decodes
+             * to, so lengths worked out from the size stay right */
+            if(IsCompressedFmt(pBuffer->FmtType))
+                *plValue = 16;
+            else
+                *plValue = BytesFromFmt(pBuffer->FmtType) * 8;
             break;
 
         case AL_CHANNELS:
@@ -960,8 +1232,12 @@ AL_API ALvoid AL_APIENTRY alGetBufferi(ALuint buffer, ALenum eParam, ALint *plVa
 
         case AL_SIZE:
             ReadLock(&pBuffer->lock);
-            *plValue = pBuffer->SampleLen *
-                       FrameSizeFromFmt(pBuffer->FmtChannels, pBuffer->FmtType);
+            if(IsCompressedFmt(pBuffer->FmtType))
+                *plValue = pBuffer->SampleLen * sizeof(ALshort) *
+                           ChannelsFromFmt(pBuffer->FmtChannels);
+            else
+                *plValue = pBuffer->SampleLen *
+                           FrameSizeFromFmt(pBuffer->FmtChannels, pBuffer->FmtType);
             ReadUnlock(&pBuffer->lock);
             break;
 
@@ -1062,9 +1338,6 @@ AL_API void AL_APIENTRY alGetBufferiv(ALuint buffer, ALenum eParam, ALint* plVal
 }
 
 
-typedef ALubyte ALmulaw;
-typedef ALubyte ALalaw;
-typedef ALubyte ALima4;
 typedef struct {
     ALbyte b[3];
 } ALbyte3;
@@ -1128,7 +1401,7 @@ static ALalaw EncodeALaw(ALshort val)
     return ((exp<<4) | mant) ^ (sign^0x55);
 }
 
-static void DecodeIMA4Block(ALshort *dst, const ALima4 *src, ALint numchans)
+void DecodeIMA4Block(ALshort *dst, const ALima4 *src, ALint numchans)
 {
     ALint sample[MAXCHANNELS], index[MAXCHANNELS];
     ALuint code[MAXCHANNELS];
@@ -1853,8 +2126,8 @@ DECL_TEMPLATE(ALdouble)
 DECL_TEMPLATE(ALmulaw)
 DECL_TEMPLATE(ALalaw)
 static void Convert_ALima4_ALima4(ALima4 *dst, const ALima4 *src,
-                                  ALuint numchans, ALuint numblocks)
-{ memcpy(dst, src, numblocks*36*numchans); }
+                                  ALuint numchans, ALuint len)
+{ memcpy(dst, src, len/65*36*numchans); }
 DECL_TEMPLATE(ALbyte3)
 DECL_TEMPLATE(ALubyte3)
 
@@ -1972,6 +2245,49 @@ static void ConvertData(ALvoid *dst, enum UserFmtType dstType, const ALvoid *src
 }
 
 
+/* App-owned data taken off a buffer, to be handed back once it's unlocked */
+typedef struct {
+    const ALvoid *Data;
+    ALBUFFERRELEASEPROCSOFT Callback;
+    ALvoid *Param;
+} StaticRelease;
+
+/* Detaches app-owned data from a locked buffer, if it has any */
+static void TakeStaticData(ALbuffer *ALBuf, StaticRelease *release)
+{
+    release->Data = NULL;
+    release->Callback = NULL;
+    release->Param = NULL;
+    if(ALBuf->StaticData)
+    {
+        release->Data = ALBuf->data;
+        release->Callback = ALBuf->ReleaseCallback;
+        release->Param = ALBuf->ReleaseParam;
+
+        ALBuf->data = NULL;
+        ALBuf->StaticData = AL_FALSE;
+        ALBuf->ReleaseCallback = NULL;
+        ALBuf->ReleaseParam = NULL;
+    }
+}
+
+static void GiveBackStaticData(ALuint buffer, const StaticRelease *release)
+{
+    if(release->Callback)
+        release->Callback(buffer, release->Data, release->Param);
+}
+
+/* Releases the storage of a buffer that's being destroyed */
+static void FreeData(ALbuffer *ALBuf)
+{
+    StaticRelease release;
+
+    TakeStaticData(ALBuf, &release);
+    free(ALBuf->data);
+    ALBuf->data = NULL;
+    GiveBackStaticData(ALBuf->buffer, &release);
+}
+
 /*
  * LoadData
  *
@@ -1979,11 +2295,14 @@ static void ConvertData(ALvoid *dst, enum UserFmtType dstType, const ALvoid *src
  * Currently, the new format must have the same channel configuration as the
  * original format.
  */
-static ALenum LoadData(ALbuffer *ALBuf, ALuint freq, ALenum NewFormat, ALsizei frames, enum UserFmtChannels SrcChannels, enum UserFmtType SrcType, const ALvoid *data, ALboolean storesrc)
+static ALenum LoadData(ALbuffer *ALBuf, ALuint freq, ALenum NewFormat, ALsizei frames, enum UserFmtChannels SrcChannels, enum UserFmtType SrcType, const ALvoid *data, ALboolean storesrc, ALuint DstFreq)
 {
     ALuint NewChannels, NewBytes;
     enum FmtChannels DstChannels;
     enum FmtType DstType;
+    StaticRelease release;
+    ALfloat *resampled = NULL;
+    ALsizei dstframes;
     ALuint64 newsize;
     ALvoid *temp;
 
@@ -1991,34 +2310,78 @@ static ALenum LoadData(ALbuffer *ALBuf, ALuint freq, ALenum NewFormat, ALsizei f
        (long)SrcChannels != (long)DstChannels)
         return AL_INVALID_ENUM;
 
+    /* Codecs the mixer can decode on the fly keep their compressed data,
+     * unless it's going to be resampled */
+    if(DstFreq == freq || freq == 0 || data == NULL || frames == 0)
+        DstFreq = 0;
+    if(storesrc && CompressedBuffers && !DstFreq &&
+       (SrcType == UserFmtMulaw || SrcType == UserFmtAlaw ||
+        SrcType == UserFmtIMA4))
+        DstType = (enum FmtType)SrcType;
+
     NewChannels = ChannelsFromFmt(DstChannels);
     NewBytes = BytesFromFmt(DstType);
 
-    newsize = frames;
-    newsize *= NewBytes;
+    dstframes = frames;
+    if(DstFreq)
+    {
+        newsize = ((ALuint64)frames*DstFreq + freq-1) / freq;
+        if(newsize > INT_MAX)
+            return AL_OUT_OF_MEMORY;
+        dstframes = (ALsizei)newsize;
+    }
+
+    if(DstType == FmtIMA4)
+    {
+        newsize = dstframes / IMA4_BLOCK_LENGTH;
+        newsize *= IMA4_BLOCK_SIZE;
+    }
+    else
+    {
+        newsize = dstframes;
+        newsize *= NewBytes;
+    }
     newsize *= NewChannels;
     if(newsize > INT_MAX)
         return AL_OUT_OF_MEMORY;
 
+    /* Done before taking the lock, as it takes a while */
+    if(DstFreq)
+    {
+        resampled = ResampleData(data, SrcType, NewChannels, frames, freq,
+                                 dstframes, DstFreq);
+        if(!resampled)
+            return AL_OUT_OF_MEMORY;
+    }
+
     WriteLock(&ALBuf->lock);
     if(ALBuf->ref != 0)
     {
         WriteUnlock(&ALBuf->lock);
+        free(resampled);
         return AL_INVALID_OPERATION;
     }
 
-    temp = realloc(ALBuf->data, (size_t)newsize);
+    /* App-owned data can't be resized, so it's replaced */
+    temp = realloc(ALBuf->StaticData ? NULL : ALBuf->data, (size_t)newsize);
     if(!temp && newsize)
     {
         WriteUnlock(&ALBuf->lock);
+        free(resampled);
         return AL_OUT_OF_MEMORY;
     }
+    TakeStaticData(ALBuf, &release);
     ALBuf->data = temp;
+    ALBuf->Callback = NULL;
+    ALBuf->CallbackParam = NULL;
 
-    if(data != NULL)
+    if(resampled)
+        ConvertData(ALBuf->data, (enum UserFmtType)DstType, resampled, UserFmtFloat,
+                    NewChannels, dstframes);
+    else if(data != NULL)
         ConvertData(ALBuf->data, DstType, data, SrcType, NewChannels, frames);
 
-    if(storesrc)
+    if(storesrc && !resampled)
     {
         ALBuf->OriginalChannels = SrcChannels;
         ALBuf->OriginalType     = SrcType;
@@ -2031,9 +2394,190 @@ static ALenum LoadData(ALbuffer *ALBuf, ALuint freq, ALenum NewFormat, ALsizei f
     {
         ALBuf->OriginalChannels = DstChannels;
         ALBuf->OriginalType     = DstType;
-        ALBuf->OriginalSize     = frames * NewBytes * NewChannels;
+        ALBuf->OriginalSize     = dstframes * NewBytes * NewChannels;
+    }
+    ALBuf->Resampled = (resampled != NULL);
+
+    ALBuf->Frequency = (resampled ? DstFreq : freq);
+    ALBuf->FmtChannels = DstChannels;
+    ALBuf->FmtType = DstType;
+    ALBuf->Format = NewFormat;
+
+    ALBuf->SampleLen = dstframes;
+    ALBuf->LoopStart = 0;
+    ALBuf->LoopEnd = ALBuf->SampleLen;
+
+    WriteUnlock(&ALBuf->lock);
+
+    free(resampled);
+    GiveBackStaticData(ALBuf->buffer, &release);
+    return AL_NO_ERROR;
+}
+
+/*
+ * ResampleData
+ *
+ * Converts the data to dstframes of float samples at dstfreq, using a sinc
+ * filter that also band-limits it when the rate is lowered. Samples outside
+ * the data are taken as silence. Returns NULL when out of memory.
+ */
+static ALfloat *ResampleData(const ALvoid *data, enum UserFmtType type, ALuint numchans, ALsizei frames, ALuint freq, ALsizei dstframes, ALuint dstfreq)
+{
+    /* Cutoff as a fraction of the source's Nyquist frequency, a bit below
+     * the lower of the two rates' to fit the filter's transition band */
+    const ALfloat cutoff = minf(1.0f, (ALfloat)dstfreq/(ALfloat)freq) * 0.95f;
+    const ALsizei width = (ALsizei)ceil(BUFSINC_ZEROS / cutoff);
+    ALfloat *src, *dst, *weights;
+    ALsizei i, k, first, last;
+    ALuint c;
+
+    src = malloc((size_t)frames * numchans * sizeof(ALfloat));
+    dst = malloc((size_t)dstframes * numchans * sizeof(ALfloat));
+    weights = malloc((width*2 + 1) * sizeof(ALfloat));
+    if(!src || !dst || !weights)
+    {
+        free(src);
+        free(dst);
+        free(weights);
+        return NULL;
+    }
+    ConvertData(src, UserFmtFloat, data, type, numchans, frames);
+
+    for(i = 0;i < dstframes;i++)
+    {
+        ALuint64 pos = (ALuint64)i * freq;
+        ALsizei idx = (ALsizei)(pos / dstfreq);
+        ALfloat frac = (ALfloat)(pos % dstfreq) / (ALfloat)dstfreq;
+
+        first = maxi(idx-width+1, 0);
+        last = mini(idx+width, frames-1);
+        for(k = first;k <= last;k++)
+        {
+            ALfloat x = (ALfloat)fabs((k-idx) - frac) * cutoff * BUFSINC_RES;
+            ALsizei n = (ALsizei)x;
+            ALfloat w = 0.0f;
+            if(n < BUFSINC_ZEROS*BUFSINC_RES)
+                w = lerp(BufferSinc[n], BufferSinc[n+1], x-n) * cutoff;
+            weights[k-first] = w;
+        }
+
+        for(c = 0;c < numchans;c++)
+        {
+            ALfloat sum = 0.0f;
+            for(k = first;k <= last;k++)
+                sum += weights[k-first] * src[k*numchans + c];
+            dst[i*numchans + c] = sum;
+        }
     }
 
+    free(weights);
+    free(src);
+    return dst;
+}
+
+/* Zeroth order modified Bessel function of the first kind, for the Kaiser
+ * window */
+static ALdouble BesselI0(ALdouble x)
+{
+    ALdouble term = 1.0;
+    ALdouble sum = 1.0;
+    ALuint k;
+
+    for(k = 1;term > sum*1e-12;k++)
+    {
+        ALdouble t = x / (2.0*k);
+        term *= t * t;
+        sum += term;
+    }
+    return sum;
+}
+
+void InitBufferResampler(void)
+{
+    ALuint i;
+
+    for(i = 0;i <= BUFSINC_ZEROS*BUFSINC_RES;i++)
+    {
+        ALdouble x = (ALdouble)i / BUFSINC_RES;
+        ALdouble r = x / BUFSINC_ZEROS;
+        ALdouble w = BesselI0(BUFSINC_BETA * sqrt(1.0 - r*r)) /
+                     BesselI0(BUFSINC_BETA);
+        BufferSinc[i] = (ALfloat)((i == 0) ? w : w * sin(M_PI*x) / (M_PI*x));
+    }
+}
+
+/*
+ * LoadStaticData
+ *
+ * Points the buffer at the app's data, which is used as-is.
+ */
+static ALenum LoadStaticData(ALbuffer *ALBuf, ALuint freq, ALenum format, ALsizei size, const ALvoid *data, ALBUFFERRELEASEPROCSOFT callback, ALvoid *userptr)
+{
+    enum UserFmtChannels SrcChannels;
+    enum UserFmtType SrcType;
+    enum FmtChannels DstChannels;
+    enum FmtType DstType;
+    StaticRelease release;
+    ALenum NewFormat;
+    ALuint FrameSize;
+    ALsizei frames;
+
+    if(DecomposeFormat(format, &DstChannels, &DstType) != AL_FALSE)
+    {
+        NewFormat = format;
+        FrameSize = FrameSizeFromFmt(DstChannels, DstType);
+        /* The mixer reads the samples in place, so they must be aligned */
+        if(((size_t)data % BytesFromFmt(DstType)) != 0)
+            return AL_INVALID_VALUE;
+    }
+    else if(DecomposeUserFormat(format, &SrcChannels, &SrcType) != AL_FALSE &&
+            (SrcType == UserFmtMulaw || SrcType == UserFmtAlaw ||
+             SrcType == UserFmtIMA4))
+    {
+        DstChannels = (enum FmtChannels)SrcChannels;
+        DstType = (enum FmtType)SrcType;
+        /* Compressed data reports the 16-bit format it decodes to, as with
+         * alBufferData */
+        NewFormat = Int16Format(DstChannels);
+        if(DstType == FmtIMA4)
+            FrameSize = IMA4_BLOCK_SIZE * ChannelsFromFmt(DstChannels);
+        else
+            FrameSize = FrameSizeFromFmt(DstChannels, DstType);
+    }
+    else
+        return AL_INVALID_ENUM;
+
+    if((size%FrameSize) != 0)
+        return AL_INVALID_VALUE;
+    frames = size / FrameSize;
+    if(DstType == FmtIMA4)
+    {
+        if(frames > INT_MAX/IMA4_BLOCK_LENGTH)
+            return AL_INVALID_VALUE;
+        frames *= IMA4_BLOCK_LENGTH;
+    }
+
+    WriteLock(&ALBuf->lock);
+    if(ALBuf->ref != 0)
+    {
+        WriteUnlock(&ALBuf->lock);
+        return AL_INVALID_OPERATION;
+    }
+
+    TakeStaticData(ALBuf, &release);
+    free(ALBuf->data);
+    ALBuf->data = (ALvoid*)data;
+    ALBuf->StaticData = AL_TRUE;
+    ALBuf->ReleaseCallback = callback;
+    ALBuf->ReleaseParam = userptr;
+    ALBuf->Callback = NULL;
+    ALBuf->CallbackParam = NULL;
+    ALBuf->Resampled = AL_FALSE;
+
+    ALBuf->OriginalChannels = (enum UserFmtChannels)DstChannels;
+    ALBuf->OriginalType     = (enum UserFmtType)DstType;
+    ALBuf->OriginalSize     = size;
+
     ALBuf->Frequency = freq;
     ALBuf->FmtChannels = DstChannels;
     ALBuf->FmtType = DstType;
@@ -2044,9 +2588,215 @@ static ALenum LoadData(ALbuffer *ALBuf, ALuint freq, ALenum NewFormat, ALsizei f
     ALBuf->LoopEnd = ALBuf->SampleLen;
 
     WriteUnlock(&ALBuf->lock);
+
+    GiveBackStaticData(ALBuf->buffer, &release);
     return AL_NO_ERROR;
 }
 
+/*
+ * LoadCallback
+ *
+ * Drops the buffer's data for a callback that the playing source pulls
+ * samples from.
+ */
+static ALenum LoadCallback(ALbuffer *ALBuf, ALuint freq, ALenum format, ALBUFFERCALLBACKTYPESOFT callback, ALvoid *userptr)
+{
+    enum FmtChannels DstChannels;
+    enum FmtType DstType;
+    StaticRelease release;
+
+    if(DecomposeFormat(format, &DstChannels, &DstType) == AL_FALSE)
+        return AL_INVALID_ENUM;
+
+    WriteLock(&ALBuf->lock);
+    if(ALBuf->ref != 0)
+    {
+        WriteUnlock(&ALBuf->lock);
+        return AL_INVALID_OPERATION;
+    }
+
+    TakeStaticData(ALBuf, &release);
+    free(ALBuf->data);
+    ALBuf->data = NULL;
+    ALBuf->Callback = callback;
+    ALBuf->CallbackParam = userptr;
+    ALBuf->Resampled = AL_FALSE;
+
+    ALBuf->OriginalChannels = (enum UserFmtChannels)DstChannels;
+    ALBuf->OriginalType     = (enum UserFmtType)DstType;
+    ALBuf->OriginalSize     = 0;
+
+    ALBuf->Frequency = freq;
+    ALBuf->FmtChannels = DstChannels;
+    ALBuf->FmtType = DstType;
+    ALBuf->Format = format;
+
+    ALBuf->SampleLen = 0;
+    ALBuf->LoopStart = 0;
+    ALBuf->LoopEnd = 0;
+
+    WriteUnlock(&ALBuf->lock);
+
+    GiveBackStaticData(ALBuf->buffer, &release);
+    return AL_NO_ERROR;
+}
+
+/*
+ * LoadBank
+ *
+ * Gets a sound bank file in memory, mapping it if the data can be used as-is
+ * (which needs a little-endian host), and checks its header and index. A
+ * bank holds any number of sounds, packed for loading in one go. All values
+ * are little-endian.
+ *
+ *   Header:
+ *     char   magic[8];    "ALSBANK1"
+ *     uint32 count;       Number of sounds
+ *     uint32 reserved;    0
+ *   Index, count entries of:
+ *     uint32 format;      AL format enum, which gives the channels and
+ *                         sample type (eg. AL_FORMAT_STEREO16)
+ *     uint32 frequency;
+ *     uint32 loopStart;   Loop points, in sample frames. Both being 0 loops
+ *     uint32 loopEnd;     the whole sound.
+ *     uint32 offset;      Byte offset of the sound's data in the file
+ *     uint32 size;        Byte length of the sound's data
+ *   Sample data
+ *
+ * The formats are the ones alBufferDataStaticSOFT takes, so 8-bit samples
+ * are signed. Each sound's data should start on a 16-byte boundary (it must
+ * at least be aligned to its sample size), and sounds mustn't share data.
+ */
+static ALbank *LoadBank(const ALchar *fname, ALsizei *count)
+{
+    ALbank *bank;
+    ALuint total;
+    long size;
+    FILE *f;
+
+    bank = calloc(1, sizeof(ALbank));
+    if(!bank)
+        return NULL;
+    bank->ref = 1;
+
+#ifdef HAVE_SYS_MMAN_H
+    if(IS_LITTLE_ENDIAN)
+    {
+        struct stat st;
+        int fd;
+
+        fd = open(fname, O_RDONLY);
+        if(fd >= 0)
+        {
+            if(fstat(fd, &st) == 0 && st.st_size > 0)
+            {
+                void *ptr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+                if(ptr != MAP_FAILED)
+                {
+                    bank->data = ptr;
+                    bank->size = st.st_size;
+                    bank->mapped = AL_TRUE;
+                }
+            }
+            close(fd);
+        }
+    }
+#endif
+
+    if(!bank->data)
+    {
+        f = fopen(fname, "rb");
+        if(f == NULL)
+        {
+            ERR("Could not open %s\n", fname);
+            free(bank);
+            return NULL;
+        }
+
+        if(fseek(f, 0, SEEK_END) == 0 && (size=ftell(f)) > 0 && fseek(f, 0, SEEK_SET) == 0)
+        {
+            bank->data = malloc(size);
+            if(bank->data && fread(bank->data, 1, size, f) == (size_t)size)
+                bank->size = size;
+            else
+            {
+                free(bank->data);
+                bank->data = NULL;
+            }
+        }
+        fclose(f);
+
+        if(!bank->data)
+        {
+            ERR("Failed to read %s\n", fname);
+            free(bank);
+            return NULL;
+        }
+    }
+
+    if(bank->size < BANK_HEADER_SIZE || memcmp(bank->data, "ALSBANK1", 8) != 0)
+    {
+        ERR("%s is not a sound bank\n", fname);
+        ReleaseBank(bank);
+        return NULL;
+    }
+    total = ReadLE(&bank->data[8], 4);
+    if(total > INT_MAX/BANK_ENTRY_SIZE ||
+       bank->size < BANK_HEADER_SIZE + (size_t)total*BANK_ENTRY_SIZE)
+    {
+        ERR("%s has a bad sound count, %u\n", fname, total);
+        ReleaseBank(bank);
+        return NULL;
+    }
+
+    *count = total;
+    return bank;
+}
+
+static void ReleaseBank(ALbank *bank)
+{
+#ifdef HAVE_SYS_MMAN_H
+    if(bank->mapped)
+        munmap(bank->data, bank->size);
+    else
+#endif
+        free(bank->data);
+    free(bank);
+}
+
+/* Release callback for the buffers using a bank's data */
+static void AL_APIENTRY ReleaseBankData(ALuint buffer, const ALvoid *data, ALvoid *userptr)
+{
+    ALbank *bank = userptr;
+
+    (void)buffer;
+    (void)data;
+    if(DecrementRef(&bank->ref) == 0)
+        ReleaseBank(bank);
+}
+
+/* Swaps a sound's samples to the host's byte order, for banks read on
+ * big-endian hosts. Compressed data is made of bytes, and is left alone. */
+static void SwapBankData(ALubyte *data, ALsizei size, ALenum format)
+{
+    enum FmtChannels chans;
+    enum FmtType type;
+    ALsizei bytes, i, j;
+
+    if(DecomposeFormat(format, &chans, &type) == AL_FALSE)
+        return;
+    bytes = BytesFromFmt(type);
+    for(i = 0;i+bytes <= size;i += bytes)
+    {
+        for(j = 0;j < bytes/2;j++)
+        {
+            ALubyte tmp = data[i+j];
+            data[i+j] = data[i+bytes-1-j];
+            data[i+bytes-1-j] = tmp;
+        }
+    }
+}
+
 
 ALuint BytesFromUserFmt(enum UserFmtType type)
 {
@@ -2156,9 +2906,21 @@ ALuint BytesFromFmt(enum FmtType type)
     case FmtByte: return sizeof(ALbyte);
     case FmtShort: return sizeof(ALshort);
     case FmtFloat: return sizeof(ALfloat);
+    case FmtMulaw: return sizeof(ALmulaw);
+    case FmtAlaw: return sizeof(ALalaw);
+    case FmtIMA4: break; /* not handled here */
     }
     return 0;
 }
+/* Returns the byte offset of the given sample frame in the buffer's storage.
+ * IMA4 storage can only be addressed at block boundaries. */
+static ALsizei StorageOffset(const ALbuffer *ALBuf, ALsizei frames)
+{
+    ALsizei channels = ChannelsFromFmt(ALBuf->FmtChannels);
+    if(ALBuf->FmtType == FmtIMA4)
+        return frames/IMA4_BLOCK_LENGTH * IMA4_BLOCK_SIZE * channels;
+    return frames * BytesFromFmt(ALBuf->FmtType) * channels;
+}
 ALuint ChannelsFromFmt(enum FmtChannels chans)
 {
     switch(chans)
@@ -2173,6 +2935,20 @@ ALuint ChannelsFromFmt(enum FmtChannels chans)
     }
     return 0;
 }
+static ALenum Int16Format(enum FmtChannels chans)
+{
+    switch(chans)
+    {
+    case FmtMono: return AL_MONO16_SOFT;
+    case FmtStereo: return AL_STEREO16_SOFT;
+    case FmtRear: return AL_REAR16_SOFT;
+    case FmtQuad: return AL_QUAD16_SOFT;
+    case FmtX51: return AL_5POINT1_16_SOFT;
+    case FmtX61: return AL_6POINT1_16_SOFT;
+    case FmtX71: return AL_7POINT1_16_SOFT;
+    }
+    return AL_NONE;
+}
 static ALboolean DecomposeFormat(ALenum format, enum FmtChannels *chans, enum FmtType *type)
 {
     static const struct {
@@ -2276,7 +3052,7 @@ ALvoid ReleaseALBuffers(ALCdevice *device)
         ALbuffer *temp = device->BufferMap.array[i].value;
         device->BufferMap.array[i].value = NULL;
 
-        free(temp->data);
+        FreeData(temp);
 
         FreeThunkEntry(temp->buffer);
         memset(temp, 0, sizeof(ALbuffer));
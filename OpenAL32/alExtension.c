@@ -76,6 +76,7 @@ static const ALenums enumeration[] = {
     { "AL_UNDETERMINED",                      AL_UNDETERMINED                     },
     { "AL_METERS_PER_UNIT",                   AL_METERS_PER_UNIT                  },
     { "AL_DIRECT_CHANNELS_SOFT",              AL_DIRECT_CHANNELS_SOFT             },
+    { "AL_SOURCE_PRIORITY_SOFT",              AL_SOURCE_PRIORITY_SOFT             },
 
     // Source EFX Properties
     { "AL_DIRECT_FILTER",                     AL_DIRECT_FILTER                    },
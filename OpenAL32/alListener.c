@@ -76,12 +76,12 @@ AL_API ALvoid AL_APIENTRY alListener3f(ALenum eParam, ALfloat flValue1, ALfloat
         case AL_POSITION:
             if(isfinite(flValue1) && isfinite(flValue2) && isfinite(flValue3))
             {
-                LockContext(Context);
+                BeginPropWrite(&Context->Listener.PropSeq);
                 Context->Listener.Position[0] = flValue1;
                 Context->Listener.Position[1] = flValue2;
                 Context->Listener.Position[2] = flValue3;
+                EndPropWrite(&Context->Listener.PropSeq);
                 Context->UpdateSources = AL_TRUE;
-                UnlockContext(Context);
             }
             else
                 alSetError(Context, AL_INVALID_VALUE);
@@ -90,12 +90,12 @@ AL_API ALvoid AL_APIENTRY alListener3f(ALenum eParam, ALfloat flValue1, ALfloat
         case AL_VELOCITY:
             if(isfinite(flValue1) && isfinite(flValue2) && isfinite(flValue3))
             {
-                LockContext(Context);
+                BeginPropWrite(&Context->Listener.PropSeq);
                 Context->Listener.Velocity[0] = flValue1;
                 Context->Listener.Velocity[1] = flValue2;
                 Context->Listener.Velocity[2] = flValue3;
+                EndPropWrite(&Context->Listener.PropSeq);
                 Context->UpdateSources = AL_TRUE;
-                UnlockContext(Context);
             }
             else
                 alSetError(Context, AL_INVALID_VALUE);
@@ -157,7 +157,7 @@ AL_API ALvoid AL_APIENTRY alListenerfv(ALenum eParam, const ALfloat *pflValues)
                     aluCrossproduct(N, V, U);
                     aluNormalize(U);
 
-                    LockContext(Context);
+                    BeginPropWrite(&Context->Listener.PropSeq);
                     Context->Listener.Forward[0] = pflValues[0];
                     Context->Listener.Forward[1] = pflValues[1];
                     Context->Listener.Forward[2] = pflValues[2];
@@ -180,8 +180,8 @@ AL_API ALvoid AL_APIENTRY alListenerfv(ALenum eParam, const ALfloat *pflValues)
                     Context->Listener.Matrix[3][1] =  0.0f;
                     Context->Listener.Matrix[3][2] =  0.0f;
                     Context->Listener.Matrix[3][3] =  1.0f;
+                    EndPropWrite(&Context->Listener.PropSeq);
                     Context->UpdateSources = AL_TRUE;
-                    UnlockContext(Context);
                 }
                 else
                     alSetError(Context, AL_INVALID_VALUE);
@@ -324,6 +324,7 @@ AL_API ALvoid AL_APIENTRY alGetListenerf(ALenum eParam, ALfloat *pflValue)
 AL_API ALvoid AL_APIENTRY alGetListener3f(ALenum eParam, ALfloat *pflValue1, ALfloat *pflValue2, ALfloat *pflValue3)
 {
     ALCcontext *Context;
+    int seq;
 
     Context = GetContextRef();
     if(!Context) return;
@@ -333,19 +334,21 @@ AL_API ALvoid AL_APIENTRY alGetListener3f(ALenum eParam, ALfloat *pflValue1, ALf
         switch(eParam)
         {
             case AL_POSITION:
-                LockContext(Context);
-                *pflValue1 = Context->Listener.Position[0];
-                *pflValue2 = Context->Listener.Position[1];
-                *pflValue3 = Context->Listener.Position[2];
-                UnlockContext(Context);
+                do {
+                    seq = BeginPropRead(&Context->Listener.PropSeq);
+                    *pflValue1 = Context->Listener.Position[0];
+                    *pflValue2 = Context->Listener.Position[1];
+                    *pflValue3 = Context->Listener.Position[2];
+                } while(!EndPropRead(&Context->Listener.PropSeq, seq));
                 break;
 
             case AL_VELOCITY:
-                LockContext(Context);
-                *pflValue1 = Context->Listener.Velocity[0];
-                *pflValue2 = Context->Listener.Velocity[1];
-                *pflValue3 = Context->Listener.Velocity[2];
-                UnlockContext(Context);
+                do {
+                    seq = BeginPropRead(&Context->Listener.PropSeq);
+                    *pflValue1 = Context->Listener.Velocity[0];
+                    *pflValue2 = Context->Listener.Velocity[1];
+                    *pflValue3 = Context->Listener.Velocity[2];
+                } while(!EndPropRead(&Context->Listener.PropSeq, seq));
                 break;
 
             default:
@@ -363,6 +366,7 @@ AL_API ALvoid AL_APIENTRY alGetListener3f(ALenum eParam, ALfloat *pflValue1, ALf
 AL_API ALvoid AL_APIENTRY alGetListenerfv(ALenum eParam, ALfloat *pflValues)
 {
     ALCcontext *Context;
+    int seq;
 
     switch(eParam)
     {
@@ -385,15 +389,16 @@ AL_API ALvoid AL_APIENTRY alGetListenerfv(ALenum eParam, ALfloat *pflValues)
         switch(eParam)
         {
             case AL_ORIENTATION:
-                LockContext(Context);
                 // AT then UP
-                pflValues[0] = Context->Listener.Forward[0];
-                pflValues[1] = Context->Listener.Forward[1];
-                pflValues[2] = Context->Listener.Forward[2];
-                pflValues[3] = Context->Listener.Up[0];
-                pflValues[4] = Context->Listener.Up[1];
-                pflValues[5] = Context->Listener.Up[2];
-                UnlockContext(Context);
+                do {
+                    seq = BeginPropRead(&Context->Listener.PropSeq);
+                    pflValues[0] = Context->Listener.Forward[0];
+                    pflValues[1] = Context->Listener.Forward[1];
+                    pflValues[2] = Context->Listener.Forward[2];
+                    pflValues[3] = Context->Listener.Up[0];
+                    pflValues[4] = Context->Listener.Up[1];
+                    pflValues[5] = Context->Listener.Up[2];
+                } while(!EndPropRead(&Context->Listener.PropSeq, seq));
                 break;
 
             default:
@@ -434,6 +439,7 @@ AL_API ALvoid AL_APIENTRY alGetListeneri(ALenum eParam, ALint *plValue)
 AL_API void AL_APIENTRY alGetListener3i(ALenum eParam, ALint *plValue1, ALint *plValue2, ALint *plValue3)
 {
     ALCcontext *Context;
+    int seq;
 
     Context = GetContextRef();
     if(!Context) return;
@@ -443,19 +449,21 @@ AL_API void AL_APIENTRY alGetListener3i(ALenum eParam, ALint *plValue1, ALint *p
         switch (eParam)
         {
             case AL_POSITION:
-                LockContext(Context);
-                *plValue1 = (ALint)Context->Listener.Position[0];
-                *plValue2 = (ALint)Context->Listener.Position[1];
-                *plValue3 = (ALint)Context->Listener.Position[2];
-                UnlockContext(Context);
+                do {
+                    seq = BeginPropRead(&Context->Listener.PropSeq);
+                    *plValue1 = (ALint)Context->Listener.Position[0];
+                    *plValue2 = (ALint)Context->Listener.Position[1];
+                    *plValue3 = (ALint)Context->Listener.Position[2];
+                } while(!EndPropRead(&Context->Listener.PropSeq, seq));
                 break;
 
             case AL_VELOCITY:
-                LockContext(Context);
-                *plValue1 = (ALint)Context->Listener.Velocity[0];
-                *plValue2 = (ALint)Context->Listener.Velocity[1];
-                *plValue3 = (ALint)Context->Listener.Velocity[2];
-                UnlockContext(Context);
+                do {
+                    seq = BeginPropRead(&Context->Listener.PropSeq);
+                    *plValue1 = (ALint)Context->Listener.Velocity[0];
+                    *plValue2 = (ALint)Context->Listener.Velocity[1];
+                    *plValue3 = (ALint)Context->Listener.Velocity[2];
+                } while(!EndPropRead(&Context->Listener.PropSeq, seq));
                 break;
 
             default:
@@ -473,6 +481,7 @@ AL_API void AL_APIENTRY alGetListener3i(ALenum eParam, ALint *plValue1, ALint *p
 AL_API void AL_APIENTRY alGetListeneriv(ALenum eParam, ALint* plValues)
 {
     ALCcontext *Context;
+    int seq;
 
     switch(eParam)
     {
@@ -490,15 +499,16 @@ AL_API void AL_APIENTRY alGetListeneriv(ALenum eParam, ALint* plValues)
         switch(eParam)
         {
             case AL_ORIENTATION:
-                LockContext(Context);
                 // AT then UP
-                plValues[0] = (ALint)Context->Listener.Forward[0];
-                plValues[1] = (ALint)Context->Listener.Forward[1];
-                plValues[2] = (ALint)Context->Listener.Forward[2];
-                plValues[3] = (ALint)Context->Listener.Up[0];
-                plValues[4] = (ALint)Context->Listener.Up[1];
-                plValues[5] = (ALint)Context->Listener.Up[2];
-                UnlockContext(Context);
+                do {
+                    seq = BeginPropRead(&Context->Listener.PropSeq);
+                    plValues[0] = (ALint)Context->Listener.Forward[0];
+                    plValues[1] = (ALint)Context->Listener.Forward[1];
+                    plValues[2] = (ALint)Context->Listener.Forward[2];
+                    plValues[3] = (ALint)Context->Listener.Up[0];
+                    plValues[4] = (ALint)Context->Listener.Up[1];
+                    plValues[5] = (ALint)Context->Listener.Up[2];
+                } while(!EndPropRead(&Context->Listener.PropSeq, seq));
                 break;
 
             default:
@@ -38,11 +38,13 @@ const ALsizei ResamplerPadding[ResamplerMax] = {
     0, /* Point */
     1, /* Linear */
     2, /* Cubic */
+    4, /* Sinc */
 };
 const ALsizei ResamplerPrePadding[ResamplerMax] = {
     0, /* Point */
     0, /* Linear */
     1, /* Cubic */
+    3, /* Sinc */
 };
 
 
@@ -145,6 +147,7 @@ AL_API ALvoid AL_APIENTRY alDeleteSources(ALsizei n, const ALuint *sources)
                 {
                     Context->ActiveSourceCount--;
                     *srclist = *(--srclistend);
+                    Context->Device->RankVoices = AL_TRUE;
                     break;
                 }
                 srclist++;
@@ -169,6 +172,13 @@ AL_API ALvoid AL_APIENTRY alDeleteSources(ALsizei n, const ALuint *sources)
                 Source->Send[j].Slot = NULL;
             }
 
+            free(Source->Hrtf);
+            Source->Hrtf = NULL;
+            free(Source->HrtfFft);
+            Source->HrtfFft = NULL;
+            free(Source->CallbackData);
+            Source->CallbackData = NULL;
+
             memset(Source,0,sizeof(ALsource));
             free(Source);
         }
@@ -346,6 +356,16 @@ AL_API ALvoid AL_APIENTRY alSourcef(ALuint source, ALenum eParam, ALfloat flValu
                     alSetError(pContext, AL_INVALID_VALUE);
                 break;
 
+            case AL_SOURCE_PRIORITY_SOFT:
+                if(flValue >= 0.0f)
+                {
+                    Source->Priority = flValue;
+                    Source->NeedsUpdate = AL_TRUE;
+                }
+                else
+                    alSetError(pContext, AL_INVALID_VALUE);
+                break;
+
             case AL_SEC_OFFSET:
             case AL_SAMPLE_OFFSET:
             case AL_BYTE_OFFSET:
@@ -402,11 +422,11 @@ AL_API ALvoid AL_APIENTRY alSource3f(ALuint source, ALenum eParam, ALfloat flVal
             case AL_POSITION:
                 if(isfinite(flValue1) && isfinite(flValue2) && isfinite(flValue3))
                 {
-                    LockContext(pContext);
+                    BeginPropWrite(&Source->PropSeq);
                     Source->vPosition[0] = flValue1;
                     Source->vPosition[1] = flValue2;
                     Source->vPosition[2] = flValue3;
-                    UnlockContext(pContext);
+                    EndPropWrite(&Source->PropSeq);
                     Source->NeedsUpdate = AL_TRUE;
                 }
                 else
@@ -416,11 +436,11 @@ AL_API ALvoid AL_APIENTRY alSource3f(ALuint source, ALenum eParam, ALfloat flVal
             case AL_VELOCITY:
                 if(isfinite(flValue1) && isfinite(flValue2) && isfinite(flValue3))
                 {
-                    LockContext(pContext);
+                    BeginPropWrite(&Source->PropSeq);
                     Source->vVelocity[0] = flValue1;
                     Source->vVelocity[1] = flValue2;
                     Source->vVelocity[2] = flValue3;
-                    UnlockContext(pContext);
+                    EndPropWrite(&Source->PropSeq);
                     Source->NeedsUpdate = AL_TRUE;
                 }
                 else
@@ -430,11 +450,11 @@ AL_API ALvoid AL_APIENTRY alSource3f(ALuint source, ALenum eParam, ALfloat flVal
             case AL_DIRECTION:
                 if(isfinite(flValue1) && isfinite(flValue2) && isfinite(flValue3))
                 {
-                    LockContext(pContext);
+                    BeginPropWrite(&Source->PropSeq);
                     Source->vOrientation[0] = flValue1;
                     Source->vOrientation[1] = flValue2;
                     Source->vOrientation[2] = flValue3;
-                    UnlockContext(pContext);
+                    EndPropWrite(&Source->PropSeq);
                     Source->NeedsUpdate = AL_TRUE;
                 }
                 else
@@ -477,6 +497,7 @@ AL_API ALvoid AL_APIENTRY alSourcefv(ALuint source, ALenum eParam, const ALfloat
             case AL_BYTE_OFFSET:
             case AL_AIR_ABSORPTION_FACTOR:
             case AL_ROOM_ROLLOFF_FACTOR:
+            case AL_SOURCE_PRIORITY_SOFT:
                 alSourcef(source, eParam, pflValues[0]);
                 return;
 
@@ -525,6 +546,7 @@ AL_API ALvoid AL_APIENTRY alSourcei(ALuint source,ALenum eParam,ALint lValue)
         case AL_CONE_INNER_ANGLE:
         case AL_CONE_OUTER_ANGLE:
         case AL_REFERENCE_DISTANCE:
+        case AL_SOURCE_PRIORITY_SOFT:
             alSourcef(source, eParam, (ALfloat)lValue);
             return;
     }
@@ -564,6 +586,39 @@ AL_API ALvoid AL_APIENTRY alSourcei(ALuint source,ALenum eParam,ALint lValue)
 
                     if(lValue == 0 || (buffer=LookupBuffer(device, lValue)) != NULL)
                     {
+                        /* Callback buffers are streamed through a space held
+                         * by the source, made before the mixer sees it. The
+                         * buffer is referenced before it's unlocked, so it
+                         * can't be reloaded between the check and the use */
+                        ALubyte *CallbackData = NULL;
+                        ALboolean NeedsData = AL_FALSE;
+                        if(buffer)
+                        {
+                            ReadLock(&buffer->lock);
+                            // Increment reference counter for buffer
+                            IncrementRef(&buffer->ref);
+                            if(buffer->Callback)
+                            {
+                                ALuint chans = ChannelsFromFmt(buffer->FmtChannels);
+                                NeedsData = AL_TRUE;
+                                CallbackData = malloc(CALLBACK_FRAMES(chans) *
+                                                      FrameSizeFromFmt(buffer->FmtChannels,
+                                                                       buffer->FmtType));
+                            }
+                            ReadUnlock(&buffer->lock);
+                        }
+                        if(NeedsData && !CallbackData)
+                        {
+                            DecrementRef(&buffer->ref);
+                            UnlockContext(pContext);
+                            alSetError(pContext, AL_OUT_OF_MEMORY);
+                            break;
+                        }
+                        free(Source->CallbackData);
+                        Source->CallbackData = CallbackData;
+                        Source->CallbackFill = 0;
+                        Source->CallbackEnded = AL_FALSE;
+
                         Source->BuffersInQueue = 0;
                         Source->BuffersPlayed = 0;
 
@@ -578,8 +633,6 @@ AL_API ALvoid AL_APIENTRY alSourcei(ALuint source,ALenum eParam,ALint lValue)
                             BufferListItem->buffer = buffer;
                             BufferListItem->next = NULL;
                             BufferListItem->prev = NULL;
-                            // Increment reference counter for buffer
-                            IncrementRef(&buffer->ref);
 
                             oldlist = ExchangePtr((XchgPtr*)&Source->queue, BufferListItem);
                             Source->BuffersInQueue = 1;
@@ -837,6 +890,7 @@ AL_API void AL_APIENTRY alSourceiv(ALuint source, ALenum eParam, const ALint* pl
             case AL_AUXILIARY_SEND_FILTER_GAINHF_AUTO:
             case AL_DISTANCE_MODEL:
             case AL_DIRECT_CHANNELS_SOFT:
+            case AL_SOURCE_PRIORITY_SOFT:
                 alSourcei(source, eParam, plValues[0]);
                 return;
 
@@ -956,6 +1010,10 @@ AL_API ALvoid AL_APIENTRY alGetSourcef(ALuint source, ALenum eParam, ALfloat *pf
                     *pflValue = Source->DopplerFactor;
                     break;
 
+                case AL_SOURCE_PRIORITY_SOFT:
+                    *pflValue = Source->Priority;
+                    break;
+
                 default:
                     alSetError(pContext, AL_INVALID_ENUM);
                     break;
@@ -975,6 +1033,7 @@ AL_API ALvoid AL_APIENTRY alGetSource3f(ALuint source, ALenum eParam, ALfloat* p
 {
     ALCcontext *pContext;
     ALsource   *Source;
+    int        seq;
 
     pContext = GetContextRef();
     if(!pContext) return;
@@ -986,27 +1045,30 @@ AL_API ALvoid AL_APIENTRY alGetSource3f(ALuint source, ALenum eParam, ALfloat* p
             switch(eParam)
             {
                 case AL_POSITION:
-                    LockContext(pContext);
-                    *pflValue1 = Source->vPosition[0];
-                    *pflValue2 = Source->vPosition[1];
-                    *pflValue3 = Source->vPosition[2];
-                    UnlockContext(pContext);
+                    do {
+                        seq = BeginPropRead(&Source->PropSeq);
+                        *pflValue1 = Source->vPosition[0];
+                        *pflValue2 = Source->vPosition[1];
+                        *pflValue3 = Source->vPosition[2];
+                    } while(!EndPropRead(&Source->PropSeq, seq));
                     break;
 
                 case AL_VELOCITY:
-                    LockContext(pContext);
-                    *pflValue1 = Source->vVelocity[0];
-                    *pflValue2 = Source->vVelocity[1];
-                    *pflValue3 = Source->vVelocity[2];
-                    UnlockContext(pContext);
+                    do {
+                        seq = BeginPropRead(&Source->PropSeq);
+                        *pflValue1 = Source->vVelocity[0];
+                        *pflValue2 = Source->vVelocity[1];
+                        *pflValue3 = Source->vVelocity[2];
+                    } while(!EndPropRead(&Source->PropSeq, seq));
                     break;
 
                 case AL_DIRECTION:
-                    LockContext(pContext);
-                    *pflValue1 = Source->vOrientation[0];
-                    *pflValue2 = Source->vOrientation[1];
-                    *pflValue3 = Source->vOrientation[2];
-                    UnlockContext(pContext);
+                    do {
+                        seq = BeginPropRead(&Source->PropSeq);
+                        *pflValue1 = Source->vOrientation[0];
+                        *pflValue2 = Source->vOrientation[1];
+                        *pflValue3 = Source->vOrientation[2];
+                    } while(!EndPropRead(&Source->PropSeq, seq));
                     break;
 
                 default:
@@ -1050,6 +1112,7 @@ AL_API ALvoid AL_APIENTRY alGetSourcefv(ALuint source, ALenum eParam, ALfloat *p
         case AL_CONE_OUTER_GAINHF:
         case AL_AIR_ABSORPTION_FACTOR:
         case AL_ROOM_ROLLOFF_FACTOR:
+        case AL_SOURCE_PRIORITY_SOFT:
             alGetSourcef(source, eParam, pflValues);
             return;
 
@@ -1213,6 +1276,10 @@ AL_API ALvoid AL_APIENTRY alGetSourcei(ALuint source, ALenum eParam, ALint *plVa
                     *plValue = Source->DirectChannels;
                     break;
 
+                case AL_SOURCE_PRIORITY_SOFT:
+                    *plValue = (ALint)Source->Priority;
+                    break;
+
                 case AL_DISTANCE_MODEL:
                     *plValue = Source->DistanceModel;
                     break;
@@ -1236,6 +1303,7 @@ AL_API void AL_APIENTRY alGetSource3i(ALuint source, ALenum eParam, ALint* plVal
 {
     ALCcontext  *pContext;
     ALsource    *Source;
+    int         seq;
 
     pContext = GetContextRef();
     if(!pContext) return;
@@ -1247,27 +1315,30 @@ AL_API void AL_APIENTRY alGetSource3i(ALuint source, ALenum eParam, ALint* plVal
             switch(eParam)
             {
                 case AL_POSITION:
-                    LockContext(pContext);
-                    *plValue1 = (ALint)Source->vPosition[0];
-                    *plValue2 = (ALint)Source->vPosition[1];
-                    *plValue3 = (ALint)Source->vPosition[2];
-                    UnlockContext(pContext);
+                    do {
+                        seq = BeginPropRead(&Source->PropSeq);
+                        *plValue1 = (ALint)Source->vPosition[0];
+                        *plValue2 = (ALint)Source->vPosition[1];
+                        *plValue3 = (ALint)Source->vPosition[2];
+                    } while(!EndPropRead(&Source->PropSeq, seq));
                     break;
 
                 case AL_VELOCITY:
-                    LockContext(pContext);
-                    *plValue1 = (ALint)Source->vVelocity[0];
-                    *plValue2 = (ALint)Source->vVelocity[1];
-                    *plValue3 = (ALint)Source->vVelocity[2];
-                    UnlockContext(pContext);
+                    do {
+                        seq = BeginPropRead(&Source->PropSeq);
+                        *plValue1 = (ALint)Source->vVelocity[0];
+                        *plValue2 = (ALint)Source->vVelocity[1];
+                        *plValue3 = (ALint)Source->vVelocity[2];
+                    } while(!EndPropRead(&Source->PropSeq, seq));
                     break;
 
                 case AL_DIRECTION:
-                    LockContext(pContext);
-                    *plValue1 = (ALint)Source->vOrientation[0];
-                    *plValue2 = (ALint)Source->vOrientation[1];
-                    *plValue3 = (ALint)Source->vOrientation[2];
-                    UnlockContext(pContext);
+                    do {
+                        seq = BeginPropRead(&Source->PropSeq);
+                        *plValue1 = (ALint)Source->vOrientation[0];
+                        *plValue2 = (ALint)Source->vOrientation[1];
+                        *plValue3 = (ALint)Source->vOrientation[2];
+                    } while(!EndPropRead(&Source->PropSeq, seq));
                     break;
 
                 default:
@@ -1316,6 +1387,7 @@ AL_API void AL_APIENTRY alGetSourceiv(ALuint source, ALenum eParam, ALint* plVal
         case AL_AUXILIARY_SEND_FILTER_GAINHF_AUTO:
         case AL_DISTANCE_MODEL:
         case AL_DIRECT_CHANNELS_SOFT:
+        case AL_SOURCE_PRIORITY_SOFT:
             alGetSourcei(source, eParam, plValues);
             return;
 
@@ -1662,6 +1734,14 @@ AL_API ALvoid AL_APIENTRY alSourceQueueBuffers(ALuint source, ALsizei n, const A
         // Increment reference counter for buffer
         IncrementRef(&buffer->ref);
         ReadLock(&buffer->lock);
+        if(buffer->Callback)
+        {
+            /* Callback buffers stream by themselves, and can't be queued */
+            ReadUnlock(&buffer->lock);
+            UnlockContext(Context);
+            alSetError(Context, AL_INVALID_OPERATION);
+            goto error;
+        }
         if(BufferFmt == NULL)
         {
             BufferFmt = buffer;
@@ -1823,6 +1903,7 @@ static ALvoid InitSourceParams(ALsource *Source)
     Source->RoomRolloffFactor = 0.0f;
     Source->DopplerFactor = 1.0f;
     Source->DirectChannels = AL_FALSE;
+    Source->Priority = 1.0f;
 
     Source->DistanceModel = DefaultDistanceModel;
 
@@ -1864,7 +1945,8 @@ ALvoid SetSourceState(ALsource *Source, ALCcontext *Context, ALenum state)
         BufferList = Source->queue;
         while(BufferList)
         {
-            if(BufferList->buffer != NULL && BufferList->buffer->SampleLen)
+            if(BufferList->buffer != NULL &&
+               (BufferList->buffer->SampleLen || BufferList->buffer->Callback))
                 break;
             BufferList = BufferList->next;
         }
@@ -1875,12 +1957,9 @@ ALvoid SetSourceState(ALsource *Source, ALCcontext *Context, ALenum state)
             {
                 for(k = 0;k < SRC_HISTORY_LENGTH;k++)
                     Source->HrtfHistory[j][k] = 0.0f;
-                for(k = 0;k < HRIR_LENGTH;k++)
-                {
-                    Source->HrtfValues[j][k][0] = 0.0f;
-                    Source->HrtfValues[j][k][1] = 0.0f;
-                }
             }
+            ClearHrtfState(Source->Hrtf);
+            ClearHrtfFftState(Source->HrtfFft);
         }
 
         if(Source->state != AL_PAUSED)
@@ -1889,6 +1968,8 @@ ALvoid SetSourceState(ALsource *Source, ALCcontext *Context, ALenum state)
             Source->position = 0;
             Source->position_fraction = 0;
             Source->BuffersPlayed = 0;
+            Source->CallbackFill = 0;
+            Source->CallbackEnded = AL_FALSE;
         }
         else
             Source->state = AL_PLAYING;
@@ -1911,7 +1992,10 @@ ALvoid SetSourceState(ALsource *Source, ALCcontext *Context, ALenum state)
                 break;
         }
         if(j == Context->ActiveSourceCount)
+        {
             Context->ActiveSources[Context->ActiveSourceCount++] = Source;
+            Context->Device->RankVoices = AL_TRUE;
+        }
     }
     else if(state == AL_PAUSED)
     {
@@ -1976,7 +2060,9 @@ static ALvoid GetSourceOffset(ALsource *Source, ALenum name, ALdouble *offset, A
         BufferList = BufferList->next;
     }
 
-    if((Source->state != AL_PLAYING && Source->state != AL_PAUSED) || !Buffer)
+    /* Callback buffers don't have a length to measure offsets in */
+    if((Source->state != AL_PLAYING && Source->state != AL_PAUSED) || !Buffer ||
+       Buffer->Callback)
     {
         offset[0] = 0.0;
         offset[1] = 0.0;
@@ -2209,6 +2295,13 @@ ALvoid ReleaseALSources(ALCcontext *Context)
             temp->Send[j].Slot = NULL;
         }
 
+        free(temp->Hrtf);
+        temp->Hrtf = NULL;
+        free(temp->HrtfFft);
+        temp->HrtfFft = NULL;
+        free(temp->CallbackData);
+        temp->CallbackData = NULL;
+
         // Release source structure
         FreeThunkEntry(temp->source);
         memset(temp, 0, sizeof(ALsource));
@@ -592,8 +592,12 @@ AL_API ALvoid AL_APIENTRY alDeferUpdatesSOFT(void)
         LockContext(Context);
         Context->DeferUpdates = AL_TRUE;
 
-        /* Make sure all pending updates are performed */
+        /* Make sure all pending updates are performed. If the listener is
+         * being changed meanwhile, the mixer catches up once updates are
+         * processed again. */
         UpdateSources = ExchangeInt(&Context->UpdateSources, AL_FALSE);
+        if(UpdateSources && !CalcListenerParams(Context))
+            Context->UpdateSources = AL_TRUE;
 
         src = Context->ActiveSources;
         src_end = src + Context->ActiveSourceCount;
@@ -603,11 +607,15 @@ AL_API ALvoid AL_APIENTRY alDeferUpdatesSOFT(void)
             {
                 Context->ActiveSourceCount--;
                 *src = *(--src_end);
+                Context->Device->RankVoices = AL_TRUE;
                 continue;
             }
 
             if(ExchangeInt(&(*src)->NeedsUpdate, AL_FALSE) || UpdateSources)
+            {
                 ALsource_Update(*src, Context);
+                Context->Device->RankVoices = AL_TRUE;
+            }
 
             src++;
         }
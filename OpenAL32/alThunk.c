@@ -29,12 +29,17 @@
 static ALenum *ThunkArray;
 static ALuint  ThunkArraySize;
 static RWLock  ThunkLock;
+/* Where the next search for a free entry starts. Names are usually handed
+ * out in runs, so starting after the last one avoids rescanning all the ones
+ * in use. */
+static volatile ALuint ThunkNextFree;
 
 void ThunkInit(void)
 {
     RWLockInit(&ThunkLock);
     ThunkArraySize = 1;
     ThunkArray = calloc(1, ThunkArraySize * sizeof(*ThunkArray));
+    ThunkNextFree = 0;
 }
 
 void ThunkExit(void)
@@ -47,13 +52,16 @@ void ThunkExit(void)
 ALenum NewThunkEntry(ALuint *index)
 {
     ALenum *NewList;
-    ALuint i;
+    ALuint start, i, j;
 
     ReadLock(&ThunkLock);
-    for(i = 0;i < ThunkArraySize;i++)
+    start = ThunkNextFree;
+    for(j = 0;j < ThunkArraySize;j++)
     {
+        i = (start+j) % ThunkArraySize;
         if(ExchangeInt(&ThunkArray[i], AL_TRUE) == AL_FALSE)
         {
+            ThunkNextFree = i+1;
             ReadUnlock(&ThunkLock);
             *index = i+1;
             return AL_NO_ERROR;
@@ -73,7 +81,10 @@ ALenum NewThunkEntry(ALuint *index)
     ThunkArraySize *= 2;
     ThunkArray = NewList;
 
+    /* The first of the new entries */
+    i = ThunkArraySize/2;
     ThunkArray[i] = AL_TRUE;
+    ThunkNextFree = i+1;
     WriteUnlock(&ThunkLock);
 
     *index = i+1;
@@ -0,0 +1,748 @@
+/*
+ * OpenAL Mixer Benchmark
+ *
+ * Copyright (c) 2026 by authors.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Renders through a loopback device and reports how long the mixer takes.
+ *
+ * Each run plays a number of looping sources for a while and prints one CSV
+ * line with its settings, the time taken per output sample frame, and how
+ * many of those voices one core could mix in real time. By default the
+ * source count, storage type, channel count, send count and effect are each
+ * swept in turn from a baseline. Giving an option pins that setting.
+ *
+ * The resampler and HRTF are global config options, which the library reads
+ * once per process. So unless both are given, the program runs itself once
+ * for each combination, with a temporary config file for each. */
+
+#define AL_ALEXT_PROTOTYPES
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#include <sys/time.h>
+#endif
+
+#include "AL/alc.h"
+#include "AL/al.h"
+#include "AL/alext.h"
+#include "AL/efx.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define OUTPUT_RATE  44100
+#define BUFFER_RATE  22050
+#define UPDATE_SIZE  1024
+#define MAX_RUN_SENDS 4
+
+
+static const char *const Resamplers[] = { "point", "linear", "cubic", "sinc" };
+static const char *const HrtfModes[] = { "off", "on", "fft", "bed" };
+
+static const char *const StorageNames[] = {
+    "int8", "int16", "float32", "mulaw", "ima4"
+};
+static const char *const EffectNames[] = {
+    "none", "reverb", "eaxreverb", "echo", "modulator", "dedicated"
+};
+static const ALenum EffectTypes[] = {
+    AL_EFFECT_NULL, AL_EFFECT_REVERB, AL_EFFECT_EAXREVERB, AL_EFFECT_ECHO,
+    AL_EFFECT_RING_MODULATOR, AL_EFFECT_DEDICATED_DIALOGUE
+};
+
+#define COUNTOF(x) (sizeof(x)/sizeof((x)[0]))
+
+/* Values swept for each dimension. The first is the baseline. */
+static ALuint SourceCounts[] = { 64, 1, 16, 256 };
+static ALuint Storages[] = { 1, 0, 2, 3, 4 };
+static ALuint ChannelCounts[] = { 1, 2 };
+static ALuint SendCounts[] = { 0, 1, 2, 4 };
+static ALuint Effects[] = { 0, 1, 2, 3, 4, 5 };
+
+typedef struct {
+    ALuint *Values;
+    ALuint Count;
+} Dimension;
+
+enum {
+    DimSources,
+    DimStorage,
+    DimChannels,
+    DimSends,
+    DimEffect,
+
+    DimCount
+};
+
+static Dimension Dims[DimCount] = {
+    { SourceCounts, COUNTOF(SourceCounts) },
+    { Storages, COUNTOF(Storages) },
+    { ChannelCounts, COUNTOF(ChannelCounts) },
+    { SendCounts, COUNTOF(SendCounts) },
+    { Effects, COUNTOF(Effects) },
+};
+
+static const char *Resampler = NULL;
+static const char *Hrtf = NULL;
+static unsigned HrtfSize = 0;
+static unsigned ReverbDecimate = 0;
+static double Seconds = 1.0;
+
+
+static double GetTime(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart / (double)freq.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec/1000000000.0;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec/1000000.0;
+#endif
+}
+
+static int FindName(const char *const *names, size_t count, const char *name)
+{
+    size_t i;
+    for(i = 0;i < count;i++)
+    {
+        if(strcmp(names[i], name) == 0)
+            return (int)i;
+    }
+    return -1;
+}
+
+
+/* Encodes a 16-bit sample as G.711 mu-law */
+static ALubyte EncodeMulaw(ALshort sample)
+{
+    int val = sample;
+    int sign = 0, exp, mant;
+
+    if(val < 0)
+    {
+        sign = 0x80;
+        val = -val;
+    }
+    if(val > 32635) val = 32635;
+    val += 0x84;
+
+    for(exp = 7;exp > 0 && !(val&(0x4000>>(7-exp)));exp--)
+        ;
+    mant = (val >> (exp+3)) & 0x0f;
+    return (ALubyte)~(sign | (exp<<4) | mant);
+}
+
+/* Encodes interleaved 16-bit samples as IMA4 blocks of 65 sample frames */
+static void EncodeIMA4(ALubyte *dst, const ALshort *src, ALuint channels,
+                       ALuint blocks)
+{
+    static const int steps[89] = {
+            7,     8,     9,    10,    11,    12,    13,    14,    16,    17,
+           19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+           50,    55,    60,    66,    73,    80,    88,    97,   107,   118,
+          130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+          337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+          876,   963,  1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+         2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+         5894,  6484,  7132,  7845,  8630,  9493, 10442, 11487, 12635, 13899,
+        15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+    };
+    static const int adjust[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+    int sample[2] = { 0, 0 }, index[2] = { 0, 0 };
+    ALuint b, c, g, k;
+
+    for(b = 0;b < blocks;b++)
+    {
+        for(c = 0;c < channels;c++)
+        {
+            sample[c] = src[c];
+            *(dst++) = sample[c]&0xff;
+            *(dst++) = (sample[c]>>8)&0xff;
+            *(dst++) = index[c]&0xff;
+            *(dst++) = 0;
+        }
+        src += channels;
+
+        for(g = 0;g < 8;g++)
+        {
+            for(c = 0;c < channels;c++)
+            {
+                for(k = 0;k < 8;k += 2)
+                {
+                    int nibbles[2], n;
+                    for(n = 0;n < 2;n++)
+                    {
+                        int step = steps[index[c]];
+                        int diff = src[(k+n)*channels + c] - sample[c];
+                        int code = 0;
+
+                        /* Each code decodes to (code*2 + 1) * step/8 */
+                        if(diff < 0) { code = 8; diff = -diff; }
+                        code |= (diff*4/step < 7) ? diff*4/step : 7;
+
+                        diff = ((code&7)*2 + 1) * step / 8;
+                        sample[c] += (code&8) ? -diff : diff;
+                        if(sample[c] < -32768) sample[c] = -32768;
+                        if(sample[c] > 32767) sample[c] = 32767;
+
+                        index[c] += adjust[code&7];
+                        if(index[c] < 0) index[c] = 0;
+                        if(index[c] > 88) index[c] = 88;
+                        nibbles[n] = code;
+                    }
+                    *(dst++) = (ALubyte)(nibbles[0] | (nibbles[1]<<4));
+                }
+            }
+            src += 8*channels;
+        }
+    }
+}
+
+/* Makes a one second looping buffer holding a few sines, in the requested
+ * storage type and channel count */
+static ALuint MakeBuffer(ALuint storage, ALuint channels)
+{
+    static const ALenum formats[5][2] = {
+        { AL_FORMAT_MONO8,  AL_FORMAT_STEREO8  },
+        { AL_FORMAT_MONO16, AL_FORMAT_STEREO16 },
+        { AL_FORMAT_MONO_FLOAT32, AL_FORMAT_STEREO_FLOAT32 },
+        { AL_FORMAT_MONO_MULAW, AL_FORMAT_STEREO_MULAW },
+        { AL_FORMAT_MONO_IMA4, AL_FORMAT_STEREO_IMA4 },
+    };
+    /* IMA4 buffers are whole blocks of 65 sample frames */
+    ALuint blocks = BUFFER_RATE / 65;
+    ALuint samples = ((storage == 4) ? blocks*65 : BUFFER_RATE) * channels;
+    ALsizei size = 0;
+    ALuint buffer = 0;
+    void *data;
+    ALuint i;
+
+    data = malloc(samples * sizeof(ALfloat));
+    if(!data) return 0;
+
+    for(i = 0;i < samples;i++)
+    {
+        ALuint frame = i / channels;
+        double s = (sin(frame * 2.0*M_PI * 220.0/BUFFER_RATE) +
+                    sin(frame * 2.0*M_PI * 1375.0/BUFFER_RATE) +
+                    sin(frame * 2.0*M_PI * (4400.0+i%channels*10.0)/BUFFER_RATE)) / 3.0;
+        switch(storage)
+        {
+            case 0:
+                ((ALubyte*)data)[i] = (ALubyte)(s*127.0 + 128.0);
+                size = samples;
+                break;
+            case 1:
+                ((ALshort*)data)[i] = (ALshort)(s*32767.0);
+                size = samples * sizeof(ALshort);
+                break;
+            case 2:
+                ((ALfloat*)data)[i] = (ALfloat)s;
+                size = samples * sizeof(ALfloat);
+                break;
+            case 3:
+                ((ALubyte*)data)[i] = EncodeMulaw((ALshort)(s*32767.0));
+                size = samples;
+                break;
+            case 4:
+                ((ALshort*)data)[i] = (ALshort)(s*32767.0);
+                break;
+        }
+    }
+    if(storage == 4)
+    {
+        /* The blocks take less room than the samples, so they're written
+         * over them */
+        ALshort *pcm = malloc(samples * sizeof(ALshort));
+        if(!pcm)
+        {
+            free(data);
+            return 0;
+        }
+        memcpy(pcm, data, samples * sizeof(ALshort));
+        EncodeIMA4(data, pcm, channels, blocks);
+        size = blocks * 36 * channels;
+        free(pcm);
+    }
+
+    alGenBuffers(1, &buffer);
+    alBufferData(buffer, formats[storage][channels-1], data, size, BUFFER_RATE);
+    free(data);
+
+    if(alGetError() != AL_NO_ERROR)
+    {
+        alDeleteBuffers(1, &buffer);
+        return 0;
+    }
+    return buffer;
+}
+
+/* Plays the given setup on the device and prints its CSV line. Returns 0 if
+ * the setup could not be created. */
+static int RunBench(ALCdevice *device, const ALuint *params)
+{
+    const ALuint numSources = params[DimSources];
+    const ALuint storage = params[DimStorage];
+    const ALuint channels = params[DimChannels];
+    const ALuint numSends = params[DimSends];
+    const ALuint effect = params[DimEffect];
+    ALCint attrs[] = {
+        ALC_FORMAT_CHANNELS_SOFT, ALC_STEREO_SOFT,
+        ALC_FORMAT_TYPE_SOFT, ALC_FLOAT_SOFT,
+        ALC_FREQUENCY, OUTPUT_RATE,
+        ALC_MONO_SOURCES, 512,
+        ALC_STEREO_SOURCES, 512,
+        ALC_MAX_AUXILIARY_SENDS, MAX_RUN_SENDS,
+        0
+    };
+    ALuint slots[MAX_RUN_SENDS] = { 0, 0, 0, 0 };
+    ALuint effectObj = 0;
+    ALuint buffer = 0;
+    ALuint *sources;
+    ALCcontext *context;
+    ALfloat *output;
+    ALuint frames, done;
+    double start, elapsed;
+    double nsPerSample, voicesPerCore;
+    ALuint i, j;
+    int ok = 0;
+
+    context = alcCreateContext(device, attrs);
+    if(!context || !alcMakeContextCurrent(context))
+    {
+        fprintf(stderr, "Failed to set up a context\n");
+        if(context) alcDestroyContext(context);
+        return 0;
+    }
+
+    sources = calloc(numSources, sizeof(*sources));
+    output = malloc(UPDATE_SIZE * 2 * sizeof(*output));
+    if(!sources || !output)
+        goto done;
+
+    buffer = MakeBuffer(storage, channels);
+    if(!buffer)
+    {
+        fprintf(stderr, "Failed to create a %s buffer\n", StorageNames[storage]);
+        goto done;
+    }
+
+    if(effect != 0)
+    {
+        alGenEffects(1, &effectObj);
+        alEffecti(effectObj, AL_EFFECT_TYPE, EffectTypes[effect]);
+        alGenAuxiliaryEffectSlots(numSends, slots);
+        for(i = 0;i < numSends;i++)
+            alAuxiliaryEffectSloti(slots[i], AL_EFFECTSLOT_EFFECT, effectObj);
+        if(alGetError() != AL_NO_ERROR)
+        {
+            fprintf(stderr, "Failed to set up %u %s slot(s)\n", numSends,
+                    EffectNames[effect]);
+            goto done;
+        }
+    }
+
+    alGenSources(numSources, sources);
+    if(alGetError() != AL_NO_ERROR)
+    {
+        fprintf(stderr, "Failed to create %u sources\n", numSources);
+        memset(sources, 0, numSources*sizeof(*sources));
+        goto done;
+    }
+    for(i = 0;i < numSources;i++)
+    {
+        /* Spread the sources around the listener, with slightly different
+         * pitches so they don't all resample the same way */
+        double angle = 2.0*M_PI * i / numSources;
+        alSource3f(sources[i], AL_POSITION, (ALfloat)sin(angle), 0.0f,
+                   (ALfloat)-cos(angle));
+        alSourcef(sources[i], AL_PITCH, 0.9f + 0.2f*i/numSources);
+        alSourcef(sources[i], AL_GAIN, 1.0f/numSources);
+        alSourcei(sources[i], AL_LOOPING, AL_TRUE);
+        alSourcei(sources[i], AL_BUFFER, buffer);
+        for(j = 0;j < numSends;j++)
+            alSource3i(sources[i], AL_AUXILIARY_SEND_FILTER, slots[j], j,
+                       AL_FILTER_NULL);
+    }
+    alSourcePlayv(numSources, sources);
+    if(alGetError() != AL_NO_ERROR)
+    {
+        fprintf(stderr, "Failed to start the sources\n");
+        goto done;
+    }
+
+    /* Warm up before timing */
+    for(i = 0;i < 8;i++)
+        alcRenderSamplesSOFT(device, output, UPDATE_SIZE);
+
+    frames = (ALuint)(Seconds * OUTPUT_RATE);
+    start = GetTime();
+    for(done = 0;done < frames;done += UPDATE_SIZE)
+        alcRenderSamplesSOFT(device, output, UPDATE_SIZE);
+    elapsed = GetTime() - start;
+
+    nsPerSample = elapsed * 1000000000.0 / done;
+    voicesPerCore = numSources * (1000000000.0/OUTPUT_RATE) / nsPerSample;
+
+    printf("%s,%s,%u,%s,%u,%u,%s,%u,%.3f,%.1f\n", Resampler, Hrtf,
+           numSources, StorageNames[storage], channels, numSends,
+           EffectNames[effect], done, nsPerSample, voicesPerCore);
+    fflush(stdout);
+    ok = 1;
+
+done:
+    if(sources)
+    {
+        alSourceStopv(numSources, sources);
+        for(i = 0;i < numSources;i++)
+        {
+            if(sources[i])
+                alDeleteSources(1, &sources[i]);
+        }
+    }
+    if(effect != 0)
+    {
+        alDeleteAuxiliaryEffectSlots(numSends, slots);
+        alDeleteEffects(1, &effectObj);
+    }
+    if(buffer)
+        alDeleteBuffers(1, &buffer);
+    alGetError();
+
+    alcMakeContextCurrent(NULL);
+    alcDestroyContext(context);
+    free(sources);
+    free(output);
+    return ok;
+}
+
+/* Sends need an effect to feed, and an effect needs a send. Returns 0 if
+ * the resulting setup was already run. */
+static int PrepareRun(ALuint *params, ALuint (*runs)[DimCount], ALuint *numRuns)
+{
+    ALuint i;
+
+    if(params[DimSends] > 0 && params[DimEffect] == 0)
+        params[DimEffect] = 1;
+    if(params[DimEffect] != 0 && params[DimSends] == 0)
+        params[DimSends] = 1;
+
+    for(i = 0;i < *numRuns;i++)
+    {
+        if(memcmp(runs[i], params, sizeof(runs[i])) == 0)
+            return 0;
+    }
+    memcpy(runs[(*numRuns)++], params, sizeof(runs[0]));
+    return 1;
+}
+
+/* Runs the baseline, then each dimension's other values in turn */
+static int RunSweep(void)
+{
+    ALuint runs[1 + COUNTOF(SourceCounts) + COUNTOF(Storages) +
+                COUNTOF(ChannelCounts) + COUNTOF(SendCounts) +
+                COUNTOF(Effects)][DimCount];
+    ALuint params[DimCount];
+    ALuint numRuns = 0;
+    ALCdevice *device;
+    ALuint d, v;
+    int ok = 1;
+
+    device = alcLoopbackOpenDeviceSOFT(NULL);
+    if(!device)
+    {
+        fprintf(stderr, "Failed to open a loopback device\n");
+        return 0;
+    }
+
+    for(d = 0;d < DimCount;d++)
+    {
+        for(v = 0;v < Dims[d].Count;v++)
+        {
+            ALuint i;
+            for(i = 0;i < DimCount;i++)
+                params[i] = Dims[i].Values[0];
+            params[d] = Dims[d].Values[v];
+
+            if(PrepareRun(params, runs, &numRuns))
+                ok &= RunBench(device, params);
+        }
+    }
+
+    alcCloseDevice(device);
+    return ok;
+}
+
+
+static const char *GetTempDir(void)
+{
+    const char *str;
+#ifdef _WIN32
+    if((str=getenv("TEMP")) != NULL && *str)
+        return str;
+    return ".";
+#else
+    if((str=getenv("TMPDIR")) != NULL && *str)
+        return str;
+    return "/tmp";
+#endif
+}
+
+/* Points the library at a config file selecting the resampler and HRTF
+ * mode. It must be done before the first call into the library. */
+static char *WriteConfig(void)
+{
+    static char env[1100];
+    char *path;
+    FILE *f;
+
+    path = malloc(1024);
+    if(!path) return NULL;
+    snprintf(path, 1024, "%s/bench_mixer-%s-%s.conf", GetTempDir(),
+             Resampler, Hrtf);
+
+    f = fopen(path, "w");
+    if(!f)
+    {
+        fprintf(stderr, "Failed to write %s\n", path);
+        free(path);
+        return NULL;
+    }
+    fprintf(f, "resampler = %s\n", Resampler);
+    fprintf(f, "sources = 1024\n");
+    fprintf(f, "slots = %d\n", MAX_RUN_SENDS);
+    fprintf(f, "hrtf_convolver = %s\n", (strcmp(Hrtf, "fft") == 0) ? "fft" : "direct");
+    fprintf(f, "hrtf_mode = %s\n", (strcmp(Hrtf, "bed") == 0) ? "bed" : "full");
+    if(HrtfSize > 0)
+        fprintf(f, "hrtf_size = %u\n", HrtfSize);
+    fprintf(f, "[loopback]\n");
+    fprintf(f, "hrtf = %s\n", (strcmp(Hrtf, "off") != 0) ? "true" : "false");
+    if(ReverbDecimate > 0)
+        fprintf(f, "[reverb]\ndecimate = %u\n", ReverbDecimate);
+    fclose(f);
+
+    snprintf(env, sizeof(env), "ALSOFT_CONF=%s", path);
+#ifdef _WIN32
+    _putenv(env);
+#else
+    putenv(env);
+#endif
+    return path;
+}
+
+/* Runs this program once for each resampler and HRTF mode combination not
+ * pinned on the command line */
+static int RunConfigs(const char *self, int argc, char **argv)
+{
+    char cmd[4096];
+    size_t r, h;
+    int i, ok = 1;
+
+    for(r = 0;r < COUNTOF(Resamplers);r++)
+    {
+        if(Resampler && strcmp(Resampler, Resamplers[r]) != 0)
+            continue;
+        for(h = 0;h < COUNTOF(HrtfModes);h++)
+        {
+            size_t len;
+
+            if(Hrtf && strcmp(Hrtf, HrtfModes[h]) != 0)
+                continue;
+
+            len = snprintf(cmd, sizeof(cmd), "\"%s\" --no-header "
+                           "--resampler=%s --hrtf=%s", self, Resamplers[r],
+                           HrtfModes[h]);
+            for(i = 1;i < argc && len < sizeof(cmd);i++)
+            {
+                if(strncmp(argv[i], "--resampler=", 12) == 0 ||
+                   strncmp(argv[i], "--hrtf=", 7) == 0 ||
+                   strcmp(argv[i], "--no-header") == 0)
+                    continue;
+                len += snprintf(cmd+len, sizeof(cmd)-len, " \"%s\"", argv[i]);
+            }
+            if(len >= sizeof(cmd))
+            {
+                fprintf(stderr, "Command line too long\n");
+                return 0;
+            }
+
+            fflush(stdout);
+            if(system(cmd) != 0)
+                ok = 0;
+        }
+    }
+    return ok;
+}
+
+
+static void PrintUsage(const char *self)
+{
+    printf("Usage: %s [options]\n\n"
+           "Options:\n"
+           "  --resampler=NAME   point, linear, cubic or sinc\n"
+           "  --hrtf=MODE        off, on, fft (on with FFT convolution), or bed\n"
+           "                     (sources panned into a binauralized bed)\n"
+           "  --hrtf-size=N      HRIR length to cut HRTFs to: 8, 16, 32 or 64\n"
+           "  --reverb-decimate=N  rate divisor for the late reverb: 1, 2 or 4\n"
+           "  --sources=N        number of playing sources\n"
+           "  --storage=TYPE     int8, int16, float32, mulaw or ima4 buffers\n"
+           "  --channels=N       1 (mono) or 2 (stereo) buffers\n"
+           "  --sends=N          auxiliary sends per source, up to %d\n"
+           "  --effect=NAME      none, reverb, eaxreverb, echo, modulator or\n"
+           "                     dedicated\n"
+           "  --seconds=S        length of audio to render per run (default %g)\n"
+           "  --no-header        don't print the CSV header\n\n"
+           "Unpinned settings are swept one at a time from a baseline of %u\n"
+           "mono %s sources with no sends. The output is CSV, one line per run.\n",
+           self, MAX_RUN_SENDS, Seconds, SourceCounts[0],
+           StorageNames[Storages[0]]);
+}
+
+/* Pins a dimension to a single value */
+static void PinDim(int dim, ALuint value)
+{
+    static ALuint pinned[DimCount];
+    pinned[dim] = value;
+    Dims[dim].Values = &pinned[dim];
+    Dims[dim].Count = 1;
+}
+
+int main(int argc, char *argv[])
+{
+    int header = 1;
+    char *config;
+    int i, ok;
+
+    for(i = 1;i < argc;i++)
+    {
+        const char *arg = argv[i];
+        int idx;
+
+        if(strncmp(arg, "--resampler=", 12) == 0)
+        {
+            Resampler = arg+12;
+            if(FindName(Resamplers, COUNTOF(Resamplers), Resampler) < 0)
+                goto bad_arg;
+        }
+        else if(strncmp(arg, "--hrtf=", 7) == 0)
+        {
+            Hrtf = arg+7;
+            if(FindName(HrtfModes, COUNTOF(HrtfModes), Hrtf) < 0)
+                goto bad_arg;
+        }
+        else if(strncmp(arg, "--hrtf-size=", 12) == 0)
+        {
+            idx = atoi(arg+12);
+            if(idx != 8 && idx != 16 && idx != 32 && idx != 64) goto bad_arg;
+            HrtfSize = idx;
+        }
+        else if(strncmp(arg, "--reverb-decimate=", 18) == 0)
+        {
+            idx = atoi(arg+18);
+            if(idx != 1 && idx != 2 && idx != 4) goto bad_arg;
+            ReverbDecimate = idx;
+        }
+        else if(strncmp(arg, "--sources=", 10) == 0)
+        {
+            idx = atoi(arg+10);
+            if(idx <= 0) goto bad_arg;
+            PinDim(DimSources, idx);
+        }
+        else if(strncmp(arg, "--storage=", 10) == 0)
+        {
+            idx = FindName(StorageNames, COUNTOF(StorageNames), arg+10);
+            if(idx < 0) goto bad_arg;
+            PinDim(DimStorage, idx);
+        }
+        else if(strncmp(arg, "--channels=", 11) == 0)
+        {
+            idx = atoi(arg+11);
+            if(idx != 1 && idx != 2) goto bad_arg;
+            PinDim(DimChannels, idx);
+        }
+        else if(strncmp(arg, "--sends=", 8) == 0)
+        {
+            idx = atoi(arg+8);
+            if(idx < 0 || idx > MAX_RUN_SENDS) goto bad_arg;
+            PinDim(DimSends, idx);
+        }
+        else if(strncmp(arg, "--effect=", 9) == 0)
+        {
+            idx = FindName(EffectNames, COUNTOF(EffectNames), arg+9);
+            if(idx < 0) goto bad_arg;
+            PinDim(DimEffect, idx);
+        }
+        else if(strncmp(arg, "--seconds=", 10) == 0)
+        {
+            Seconds = atof(arg+10);
+            if(!(Seconds > 0.0)) goto bad_arg;
+        }
+        else if(strcmp(arg, "--no-header") == 0)
+            header = 0;
+        else if(strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0)
+        {
+            PrintUsage(argv[0]);
+            return 0;
+        }
+        else
+        {
+        bad_arg:
+            fprintf(stderr, "Invalid option: %s\n", arg);
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(header)
+    {
+        printf("resampler,hrtf,sources,storage,channels,sends,effect,frames,"
+               "ns_per_sample,voices_per_core\n");
+        fflush(stdout);
+    }
+
+    if(!Resampler || !Hrtf)
+        return RunConfigs(argv[0], argc, argv) ? 0 : 1;
+
+    config = WriteConfig();
+    if(!config)
+        return 1;
+    ok = RunSweep();
+    remove(config);
+    free(config);
+
+    return ok ? 0 : 1;
+}